@@ -0,0 +1,1073 @@
+/**
+ * @file bench.c
+ * @brief Microbenchmarks for dynamic_object.h
+ *
+ * Not part of the test suite - build the `bench` target in Release mode
+ * and run it directly. Timings are wall-clock nanoseconds per operation.
+ *
+ * Usage: bench [--json FILE] [SUITE...]
+ *
+ * With no SUITE names every suite runs. --json also writes each measurement
+ * with the build configuration to FILE ("-" for stdout, in which case the
+ * tables go to stderr), so runs of different versions can be diffed.
+ * Inputs are generated from fixed seeds and do not vary between runs.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#define DO_IMPLEMENTATION
+#define DO_SNAPSHOT 1
+#include "dynamic_object.h"
+
+#include <stdio.h>
+#include <time.h>
+
+/* =============================================================================
+ * TIMING HELPERS
+ * ============================================================================= */
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Prevent the compiler from discarding benchmarked results
+static volatile uintptr_t bench_sink;
+
+// Human-readable tables
+static FILE* bench_out;
+
+// Every measurement of the run, for --json
+typedef struct {
+    const char* suite;
+    char metric[32];
+    const char* unit;
+    long param;
+    double value;
+} bench_result_t;
+
+static bench_result_t* bench_results;  // stb_ds array
+static const char* bench_suite;        // Suite currently running
+
+static void record(const char* metric, long param, double value, const char* unit) {
+    bench_result_t result = { bench_suite, {0}, unit, param, value };
+    snprintf(result.metric, sizeof(result.metric), "%s", metric);
+    arrput(bench_results, result);
+}
+
+static void write_json(FILE* file) {
+    fprintf(file, "{\n  \"config\": {\n");
+#if defined(__VERSION__)
+    fprintf(file, "    \"compiler\": \"%s\",\n", __VERSION__);
+#endif
+    fprintf(file, "    \"DO_HASH_THRESHOLD\": %d,\n", DO_HASH_THRESHOLD);
+    fprintf(file, "    \"DO_INLINE_SIZE\": %d,\n", DO_INLINE_SIZE);
+    fprintf(file, "    \"DO_POOL_ALLOCATOR\": %d,\n", DO_POOL_ALLOCATOR);
+    fprintf(file, "    \"DO_SIMD\": %d,\n", DO_SIMD);
+    fprintf(file, "    \"DO_ATOMIC_REFCOUNT\": %d,\n", DO_ATOMIC_REFCOUNT);
+    fprintf(file, "    \"DO_BIASED_REFCOUNT\": %d,\n", DO_BIASED_REFCOUNT);
+    fprintf(file, "    \"DO_INTERN_CONCURRENT\": %d,\n", DO_INTERN_CONCURRENT);
+    fprintf(file, "    \"DO_CONCURRENT_OBJECTS\": %d\n", DO_CONCURRENT_OBJECTS);
+    fprintf(file, "  },\n  \"results\": [");
+    for (int i = 0; i < arrlen(bench_results); i++) {
+        const bench_result_t* r = &bench_results[i];
+        fprintf(file, "%s\n    {\"suite\": \"%s\", \"metric\": \"%s\", \"param\": %ld, "
+                "\"value\": %.3f, \"unit\": \"%s\"}",
+                i ? "," : "", r->suite, r->metric, r->param, r->value, r->unit);
+    }
+    fprintf(file, "\n  ]\n}\n");
+}
+
+/* =============================================================================
+ * STRING INTERNING BENCHMARKS
+ * ============================================================================= */
+
+static char** make_keys(int count, const char* prefix) {
+    char** keys = (char**)malloc((size_t)count * sizeof(char*));
+    char buf[64];
+    for (int i = 0; i < count; i++) {
+        snprintf(buf, sizeof(buf), "%s%d", prefix, i);
+        keys[i] = (char*)malloc(strlen(buf) + 1);
+        strcpy(keys[i], buf);
+    }
+    return keys;
+}
+
+static void free_keys(char** keys, int count) {
+    for (int i = 0; i < count; i++) free(keys[i]);
+    free(keys);
+}
+
+static void bench_intern(int table_size) {
+    const int lookups = 1000000;
+    char** keys = make_keys(table_size, "identifier_");
+    char** missing = make_keys(1024, "missing_");
+    
+    double start = now_ns();
+    for (int i = 0; i < table_size; i++) {
+        bench_sink += (uintptr_t)do_string_intern(keys[i]);
+    }
+    double insert_ns = (now_ns() - start) / table_size;
+    
+    start = now_ns();
+    for (int i = 0; i < lookups; i++) {
+        bench_sink += (uintptr_t)do_string_intern(keys[i % table_size]);
+    }
+    double hit_ns = (now_ns() - start) / lookups;
+    
+    start = now_ns();
+    for (int i = 0; i < lookups; i++) {
+        bench_sink += (uintptr_t)do_string_find_interned(missing[i & 1023]);
+    }
+    double miss_ns = (now_ns() - start) / lookups;
+    
+    fprintf(bench_out, "%-10d %12.1f %12.1f %12.1f\n", table_size, insert_ns, hit_ns, miss_ns);
+    record("insert", table_size, insert_ns, "ns/op");
+    record("hit", table_size, hit_ns, "ns/op");
+    record("miss", table_size, miss_ns, "ns/op");
+    
+    do_string_intern_cleanup();
+    free_keys(keys, table_size);
+    free_keys(missing, 1024);
+}
+
+// Identifiers as (offset, length) slices of one source buffer, interned
+// through a NUL-terminated copy versus directly with do_string_intern_n
+static void bench_intern_slices(int table_size) {
+    const int lookups = 1000000;
+    char** keys = make_keys(table_size, "identifier_");
+    size_t* offsets = (size_t*)malloc((size_t)table_size * sizeof(size_t));
+    size_t* lengths = (size_t*)malloc((size_t)table_size * sizeof(size_t));
+    size_t source_size = 0;
+    for (int i = 0; i < table_size; i++) source_size += strlen(keys[i]) + 1;
+    char* source = (char*)malloc(source_size);
+    size_t used = 0;
+    for (int i = 0; i < table_size; i++) {
+        offsets[i] = used;
+        lengths[i] = strlen(keys[i]);
+        memcpy(source + used, keys[i], lengths[i]);
+        source[used + lengths[i]] = ' ';
+        used += lengths[i] + 1;
+        bench_sink += (uintptr_t)do_string_intern(keys[i]);
+    }
+    
+    char buf[64];
+    double start = now_ns();
+    for (int i = 0; i < lookups; i++) {
+        int k = i % table_size;
+        memcpy(buf, source + offsets[k], lengths[k]);
+        buf[lengths[k]] = '\0';
+        bench_sink += (uintptr_t)do_string_intern(buf);
+    }
+    double copy_ns = (now_ns() - start) / lookups;
+    
+    start = now_ns();
+    for (int i = 0; i < lookups; i++) {
+        int k = i % table_size;
+        bench_sink += (uintptr_t)do_string_intern_n(source + offsets[k], lengths[k]);
+    }
+    double slice_ns = (now_ns() - start) / lookups;
+    
+    fprintf(bench_out, "%-10d %12.1f %12.1f\n", table_size, copy_ns, slice_ns);
+    record("slice_copy", table_size, copy_ns, "ns/op");
+    record("slice_n", table_size, slice_ns, "ns/op");
+    
+    do_string_intern_cleanup();
+    free(source);
+    free(offsets);
+    free(lengths);
+    free_keys(keys, table_size);
+}
+
+/* =============================================================================
+ * PROPERTY ACCESS BENCHMARKS
+ * ============================================================================= */
+
+static void bench_cached_get(int depth) {
+    const int lookups = 10000000;
+    const char* key = do_string_intern("method");
+    
+    // Chain of `depth` prototypes with the property on the root, a few
+    // unrelated properties at every level
+    do_object holder = do_create(NULL);
+    DO_SET(holder, "method", 1);
+    do_object obj = holder;
+    for (int level = 0; level < depth; level++) {
+        do_object child = do_create_with_prototype(obj, NULL);
+        DO_SET(child, "a", level);
+        DO_SET(child, "b", level);
+        DO_SET(child, "c", level);
+        do_release(&obj);
+        obj = child;
+    }
+    
+    double start = now_ns();
+    for (int i = 0; i < lookups; i++) {
+        bench_sink += *(int*)do_get_interned(obj, key);
+    }
+    double plain_ns = (now_ns() - start) / lookups;
+    
+    do_ic_t ic = DO_IC_INIT;
+    start = now_ns();
+    for (int i = 0; i < lookups; i++) {
+        bench_sink += *(int*)do_get_cached(obj, key, &ic);
+    }
+    double cached_ns = (now_ns() - start) / lookups;
+    
+    fprintf(bench_out, "%-10d %12.2f %12.2f\n", depth, plain_ns, cached_ns);
+    record("interned", depth, plain_ns, "ns/op");
+    record("cached", depth, cached_ns, "ns/op");
+    
+    do_release(&obj);
+    do_string_intern_cleanup();
+}
+
+// Own-key lookup over `count` keys, hit in a pseudo-random order: the
+// scalar and vector slot scans versus the hash table, to place DO_HASH_THRESHOLD
+static void bench_key_scan(int count) {
+    const int lookups = 20000000;
+    char** names = make_keys(count, "scan_");
+    const char* keys[64];
+    do_object owner = do_create(NULL);
+    do_hash_table_t* table = NULL;
+    for (int i = 0; i < count; i++) {
+        keys[i] = do_string_intern(names[i]);
+        table_insert(owner, &table, keys[i])->value.size = 0;
+    }
+    const char* probes[1024];
+    uint32_t seed = 12345;
+    for (int i = 0; i < 1024; i++) {
+        seed = seed * 1103515245u + 12345u;
+        probes[i] = keys[(seed >> 16) % (uint32_t)count];
+    }
+    
+    double start = now_ns();
+    for (int i = 0; i < lookups; i++) {
+        bench_sink += (uintptr_t)find_key_index_scalar(keys, count, probes[i & 1023]);
+    }
+    double scalar_ns = (now_ns() - start) / lookups;
+    
+    start = now_ns();
+    for (int i = 0; i < lookups; i++) {
+        bench_sink += (uintptr_t)find_key_index(keys, count, probes[i & 1023]);
+    }
+    double simd_ns = (now_ns() - start) / lookups;
+    
+    start = now_ns();
+    for (int i = 0; i < lookups; i++) {
+        bench_sink += (uintptr_t)find_hash_property(table, probes[i & 1023]);
+    }
+    double hash_ns = (now_ns() - start) / lookups;
+    
+    fprintf(bench_out, "%-10d %12.2f %12.2f %12.2f\n", count, scalar_ns, simd_ns, hash_ns);
+    record("scalar", count, scalar_ns, "ns/op");
+    record("vector", count, simd_ns, "ns/op");
+    record("hash", count, hash_ns, "ns/op");
+    
+    table_free(owner, table);
+    do_release(&owner);
+    free_keys(names, count);
+    do_string_intern_cleanup();
+}
+
+// Large hashed objects: hit, miss and delete+reinsert on the property table,
+// with the generic stb_ds map it replaced for reference
+static void bench_table(int count) {
+    const int lookups = 10000000;
+    char** names = make_keys(count, "global_");
+    char** absent = make_keys(count, "absent_");
+    const char** keys = (const char**)malloc((size_t)count * sizeof(char*));
+    const char** misses = (const char**)malloc((size_t)count * sizeof(char*));
+    do_object obj = do_create(NULL);
+    do_hash_entry_t* reference = NULL;
+    do_property_t value = {0};
+    for (int i = 0; i < count; i++) {
+        keys[i] = do_string_intern(names[i]);
+        misses[i] = do_string_intern(absent[i]);
+        do_set_interned(obj, keys[i], &i, sizeof(i));
+        hmput(reference, keys[i], value);
+    }
+    const do_hash_table_t* table = obj->properties.table;
+    uint32_t seed = 12345;
+    
+    double start = now_ns();
+    for (int i = 0; i < lookups; i++) {
+        seed = seed * 1103515245u + 12345u;
+        bench_sink += (uintptr_t)find_hash_property(table, keys[(seed >> 8) % (uint32_t)count]);
+    }
+    double hit_ns = (now_ns() - start) / lookups;
+    
+    start = now_ns();
+    for (int i = 0; i < lookups; i++) {
+        seed = seed * 1103515245u + 12345u;
+        bench_sink += (uintptr_t)find_hash_property(table, misses[(seed >> 8) % (uint32_t)count]);
+    }
+    double miss_ns = (now_ns() - start) / lookups;
+    
+    start = now_ns();
+    for (int i = 0; i < lookups; i++) {
+        seed = seed * 1103515245u + 12345u;
+        bench_sink += (uintptr_t)hmgetp_null(reference, keys[(seed >> 8) % (uint32_t)count]);
+    }
+    double stb_ns = (now_ns() - start) / lookups;
+    
+    const int churn = 1000000;
+    start = now_ns();
+    for (int i = 0; i < churn; i++) {
+        const char* key = keys[i % count];
+        do_delete_interned(obj, key);
+        do_set_interned(obj, key, &i, sizeof(i));
+    }
+    double churn_ns = (now_ns() - start) / churn;
+    
+    fprintf(bench_out, "%-10d %12.2f %12.2f %12.2f %12.2f\n", count, hit_ns, miss_ns, stb_ns, churn_ns);
+    record("hit", count, hit_ns, "ns/op");
+    record("miss", count, miss_ns, "ns/op");
+    record("stb_ds_hit", count, stb_ns, "ns/op");
+    record("delete_insert", count, churn_ns, "ns/op");
+    
+    hmfree(reference);
+    do_release(&obj);
+    free(keys);
+    free(misses);
+    free_keys(names, count);
+    free_keys(absent, count);
+    do_string_intern_cleanup();
+}
+
+// Public get/overwrite of own properties on an object of `count` keys, on
+// either side of DO_HASH_THRESHOLD
+static void bench_own_access(int count) {
+    const int lookups = 10000000;
+    char** names = make_keys(count, "own_");
+    const char** keys = (const char**)malloc((size_t)count * sizeof(char*));
+    const char** probes = (const char**)malloc(1024 * sizeof(char*));
+    do_object obj = do_create(NULL);
+    for (int i = 0; i < count; i++) {
+        keys[i] = do_string_intern(names[i]);
+        do_set_interned(obj, keys[i], &i, sizeof(i));
+    }
+    uint32_t seed = 12345;
+    for (int i = 0; i < 1024; i++) {
+        seed = seed * 1103515245u + 12345u;
+        probes[i] = keys[(seed >> 16) % (uint32_t)count];
+    }
+    
+    double start = now_ns();
+    for (int i = 0; i < lookups; i++) {
+        bench_sink += (uintptr_t)do_get_interned(obj, probes[i & 1023]);
+    }
+    double get_ns = (now_ns() - start) / lookups;
+    
+    start = now_ns();
+    for (int i = 0; i < lookups; i++) {
+        do_set_interned(obj, probes[i & 1023], &i, sizeof(i));
+    }
+    double set_ns = (now_ns() - start) / lookups;
+    
+    const char* mode = obj->is_hashed ? "hash" : "linear";
+    fprintf(bench_out, "%-10d %-8s %12.2f %12.2f\n", count, mode, get_ns, set_ns);
+    record(obj->is_hashed ? "hash_get" : "linear_get", count, get_ns, "ns/op");
+    record(obj->is_hashed ? "hash_set" : "linear_set", count, set_ns, "ns/op");
+    
+    do_release(&obj);
+    free(keys);
+    free(probes);
+    free_keys(names, count);
+    do_string_intern_cleanup();
+}
+
+// The one do_set that moves an object from shape slots to the property
+// table, next to an ordinary slot-appending do_set at the same size
+static void bench_upgrade(void) {
+    const int count = 20000;
+    const char* keys[DO_HASH_THRESHOLD + 2];
+    char buf[16];
+    for (int i = 0; i < DO_HASH_THRESHOLD + 2; i++) {
+        snprintf(buf, sizeof(buf), "u%d", i);
+        keys[i] = do_string_intern(buf);
+    }
+    do_object* objs = (do_object*)malloc((size_t)count * sizeof(do_object));
+    int value = 0;
+    
+    // Objects hold DO_HASH_THRESHOLD + 1 keys after an append, one more upgrades
+    double times[2];
+    for (int upgrade = 0; upgrade <= 1; upgrade++) {
+        int prefill = DO_HASH_THRESHOLD + upgrade;
+        for (int n = 0; n < count; n++) {
+            objs[n] = do_create(NULL);
+            for (int i = 0; i < prefill; i++) do_set_interned(objs[n], keys[i], &value, sizeof(value));
+        }
+        double start = now_ns();
+        for (int n = 0; n < count; n++) do_set_interned(objs[n], keys[prefill], &value, sizeof(value));
+        times[upgrade] = (now_ns() - start) / count;
+        for (int n = 0; n < count; n++) {
+            bench_sink += (uintptr_t)objs[n]->is_hashed;
+            do_release(&objs[n]);
+        }
+    }
+    
+    fprintf(bench_out, "%-10d %12.1f %12.1f\n", DO_HASH_THRESHOLD, times[0], times[1]);
+    record("append", DO_HASH_THRESHOLD, times[0], "ns/op");
+    record("upgrade", DO_HASH_THRESHOLD, times[1], "ns/op");
+    
+    free(objs);
+    do_string_intern_cleanup();
+}
+
+// Build objects that end up with `props` keys, growing on demand or after
+// do_reserve_properties sized them up front
+static void bench_fill(int props) {
+    const int count = 5000;
+    const char** keys = (const char**)malloc((size_t)props * sizeof(const char*));
+    char buf[16];
+    for (int i = 0; i < props; i++) {
+        snprintf(buf, sizeof(buf), "f%d", i);
+        keys[i] = do_string_intern(buf);
+    }
+    
+    double times[2];
+    for (int reserve = 0; reserve <= 1; reserve++) {
+        double start = now_ns();
+        for (int n = 0; n < count; n++) {
+            do_object obj = do_create(NULL);
+            if (reserve) do_reserve_properties(obj, props);
+            for (int i = 0; i < props; i++) do_set_interned(obj, keys[i], &i, sizeof(i));
+            bench_sink += (uintptr_t)obj->property_count;
+            do_release(&obj);
+        }
+        times[reserve] = (now_ns() - start) / count;
+    }
+    
+    fprintf(bench_out, "%-10d %12.1f %12.1f\n", props, times[0], times[1]);
+    record("fill", props, times[0], "ns/object");
+    record("fill_reserved", props, times[1], "ns/object");
+    
+    free((void*)keys);
+    do_string_intern_cleanup();
+}
+
+/* =============================================================================
+ * ALLOCATION BENCHMARKS
+ * ============================================================================= */
+
+// Create an object, give it `props` properties of `value_size` bytes, then
+// release it: the allocation pattern of short-lived records
+static void bench_churn(int props, size_t value_size) {
+    const int rounds = 1000000;
+    const char* keys[16];
+    char value[64] = {0};
+    char buf[16];
+    for (int i = 0; i < props; i++) {
+        snprintf(buf, sizeof(buf), "p%d", i);
+        keys[i] = do_string_intern(buf);
+    }
+    
+    double start = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        do_object obj = do_create(NULL);
+        for (int i = 0; i < props; i++) {
+            do_set_interned(obj, keys[i], value, value_size);
+        }
+        bench_sink += (uintptr_t)obj->property_count;
+        do_release(&obj);
+    }
+    double churn_ns = (now_ns() - start) / rounds;
+    
+    fprintf(bench_out, "%-10d %-10zu %12.2f\n", props, value_size, churn_ns);
+    snprintf(buf, sizeof(buf), "churn_%zub", value_size);
+    record(buf, props, churn_ns, "ns/object");
+    
+    do_pool_trim();
+    do_string_intern_cleanup();
+}
+
+// Overwrite one property of `size` bytes: copy via do_set_interned versus
+// building the value in place with do_set_reserve_interned
+static void bench_update(size_t size) {
+    const int rounds = 5000000;
+    const char* key = do_string_intern("buffer");
+    unsigned char value[256] = {0};
+    do_object obj = do_create(NULL);
+    do_set_interned(obj, key, value, size);
+    
+    double start = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        value[0] = (unsigned char)r;
+        do_set_interned(obj, key, value, size);
+    }
+    double set_ns = (now_ns() - start) / rounds;
+    
+    start = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        unsigned char* storage = (unsigned char*)do_set_reserve_interned(obj, key, size);
+        storage[0] = (unsigned char)r;
+    }
+    double reserve_ns = (now_ns() - start) / rounds;
+    
+    fprintf(bench_out, "%-10zu %12.2f %12.2f\n", size, set_ns, reserve_ns);
+    record("set", (long)size, set_ns, "ns/op");
+    record("reserve", (long)size, reserve_ns, "ns/op");
+    
+    do_release(&obj);
+    do_string_intern_cleanup();
+}
+
+// Build an object of `batch` properties one call at a time versus one
+// do_set_many, then read them back with do_get_interned versus do_get_many
+static void bench_batch(int batch) {
+    const int rounds = 200000;
+    const char* keys[32];
+    const void* values[32];
+    size_t sizes[32];
+    void* found[32];
+    int value = 1;
+    char buf[16];
+    for (int i = 0; i < batch; i++) {
+        snprintf(buf, sizeof(buf), "k%d", i);
+        keys[i] = do_string_intern(buf);
+        values[i] = &value;
+        sizes[i] = sizeof(value);
+    }
+    
+    double start = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        do_object obj = do_create(NULL);
+        for (int i = 0; i < batch; i++) do_set_interned(obj, keys[i], values[i], sizes[i]);
+        for (int i = 0; i < batch; i++) bench_sink += (uintptr_t)do_get_interned(obj, keys[i]);
+        do_release(&obj);
+    }
+    double single_ns = (now_ns() - start) / rounds;
+    
+    start = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        do_object obj = do_create(NULL);
+        do_set_many(obj, keys, values, sizes, batch);
+        bench_sink += (uintptr_t)do_get_many(obj, keys, found, batch);
+        do_release(&obj);
+    }
+    double batch_ns = (now_ns() - start) / rounds;
+    
+    fprintf(bench_out, "%-10d %12.1f %12.1f\n", batch, single_ns, batch_ns);
+    record("single", batch, single_ns, "ns/object");
+    record("many", batch, batch_ns, "ns/object");
+    
+    do_string_intern_cleanup();
+}
+
+static void copy_property(const char* key, void* data, size_t size, void* context) {
+    do_set_interned((do_object)context, key, data, size);
+}
+
+// Stamp instances out of an 8-property template: copying key by key versus
+// do_clone, untouched and with one property then overwritten
+static void bench_clone(void) {
+    const int rounds = 500000;
+    char value[32] = {0};
+    char buf[16];
+    do_object template_obj = do_create(NULL);
+    for (int i = 0; i < 8; i++) {
+        snprintf(buf, sizeof(buf), "t%d", i);
+        do_set(template_obj, buf, value, i % 2 ? sizeof(value) : 4);
+    }
+    const char* first = do_string_intern("t0");
+    int update = 1;
+    
+    double start = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        do_object copy = do_create_with_prototype(do_get_prototype(template_obj), NULL);
+        do_foreach_property(template_obj, copy_property, copy);
+        do_release(&copy);
+    }
+    double manual_ns = (now_ns() - start) / rounds;
+    
+    start = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        do_object copy = do_clone(template_obj);
+        bench_sink += (uintptr_t)do_get_interned(copy, first);
+        do_release(&copy);
+    }
+    double clone_ns = (now_ns() - start) / rounds;
+    
+    start = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        do_object copy = do_clone(template_obj);
+        do_set_interned(copy, first, &update, sizeof(update));
+        do_release(&copy);
+    }
+    double written_ns = (now_ns() - start) / rounds;
+    
+    fprintf(bench_out, "%12.1f %12.1f %12.1f\n", manual_ns, clone_ns, written_ns);
+    record("key_by_key", 8, manual_ns, "ns/object");
+    record("clone", 8, clone_ns, "ns/object");
+    record("clone_write", 8, written_ns, "ns/object");
+    
+    do_release(&template_obj);
+    do_string_intern_cleanup();
+}
+
+// Build `count` objects of 8 properties, then tear them all down: one
+// do_release per heap object versus a single arena reset
+static void bench_teardown(int count) {
+    const char* keys[8];
+    char buf[16];
+    for (int i = 0; i < 8; i++) {
+        snprintf(buf, sizeof(buf), "f%d", i);
+        keys[i] = do_string_intern(buf);
+    }
+    char value[32] = {0};
+    do_object* objs = (do_object*)malloc((size_t)count * sizeof(do_object));
+    
+    for (int n = 0; n < count; n++) {
+        objs[n] = do_create(NULL);
+        for (int i = 0; i < 8; i++) do_set_interned(objs[n], keys[i], value, i % 2 ? sizeof(value) : 4);
+    }
+    double start = now_ns();
+    for (int n = 0; n < count; n++) do_release(&objs[n]);
+    double heap_us = (now_ns() - start) / 1e3;
+    
+    do_arena arena = do_arena_create(0);
+    for (int n = 0; n < count; n++) {
+        do_object obj = do_arena_create_object(arena, NULL);
+        for (int i = 0; i < 8; i++) do_set_interned(obj, keys[i], value, i % 2 ? sizeof(value) : 4);
+    }
+    start = now_ns();
+    do_arena_reset(arena);
+    double arena_us = (now_ns() - start) / 1e3;
+    
+    fprintf(bench_out, "%-10d %12.1f %12.1f\n", count, heap_us, arena_us);
+    record("release", count, heap_us, "us");
+    record("arena_reset", count, arena_us, "us");
+    
+    do_arena_destroy(&arena);
+    free(objs);
+    do_pool_trim();
+    do_string_intern_cleanup();
+}
+
+// Retain/release pairs on an object made by this thread, and on one made by
+// another thread (always the shared count when biased)
+static void bench_refcount(void) {
+    const int pairs = 10000000;
+    do_object own = do_create(NULL);
+    double start = now_ns();
+    for (int i = 0; i < pairs; i++) {
+        do_object ref = do_retain(own);
+        bench_sink += (uintptr_t)ref;
+        do_release(&ref);
+    }
+    double own_ns = (now_ns() - start) / pairs;
+    
+#if DO_BIASED_REFCOUNT
+    // Hand the count to the shared side, as for a thread that did not create it
+    do_object foreign = do_create(NULL);
+    foreign->owner = NULL;
+    atomic_store(&foreign->ref_count, DO_RC_ONE | DO_RC_MERGED);
+    atomic_store(&foreign->ref_local, 0);
+#else
+    do_object foreign = do_create(NULL);
+#endif
+    start = now_ns();
+    for (int i = 0; i < pairs; i++) {
+        do_object ref = do_retain(foreign);
+        bench_sink += (uintptr_t)ref;
+        do_release(&ref);
+    }
+    double foreign_ns = (now_ns() - start) / pairs;
+    
+    fprintf(bench_out, "%12.2f %12.2f\n", own_ns, foreign_ns);
+    record("retain_release_owner", 0, own_ns, "ns/op");
+    record("retain_release_other", 0, foreign_ns, "ns/op");
+    do_release(&own);
+    do_release(&foreign);
+}
+
+// A library of `classes` prototypes with 32 methods each, built call by
+// call and loaded from a snapshot of the same graph
+static void bench_snapshot(int classes) {
+    const char* path = "bench_snapshot.bin";
+    char key[32];
+    do_object* protos = (do_object*)malloc((size_t)classes * sizeof(do_object));
+    
+    double start = now_ns();
+    do_object base = do_create(NULL);
+    for (int c = 0; c < classes; c++) {
+        protos[c] = do_create_with_prototype(base, NULL);
+        for (int m = 0; m < 32; m++) {
+            snprintf(key, sizeof(key), "method_%d_%d", c % 64, m);
+            uintptr_t fn = (uintptr_t)(c * 32 + m);
+            do_set(protos[c], key, &fn, sizeof(fn));
+        }
+    }
+    double build_us = (now_ns() - start) / 1e3;
+    
+    do_snapshot_write(path, protos, classes);
+    for (int c = 0; c < classes; c++) do_release(&protos[c]);
+    do_release(&base);
+    do_string_intern_cleanup();
+    
+    start = now_ns();
+    do_snapshot snapshot = do_snapshot_map(path);
+    double map_us = (now_ns() - start) / 1e3;
+    bench_sink += (uintptr_t)do_snapshot_root_count(snapshot);
+    
+    fprintf(bench_out, "%-10d %12.1f %12.1f\n", classes, build_us, map_us);
+    record("build", classes, build_us, "us");
+    record("map", classes, map_us, "us");
+    
+    do_snapshot_destroy(&snapshot);
+    remove(path);
+    free(protos);
+    do_string_intern_cleanup();
+}
+
+static void bench_enumerate(int depth, int keys_per_level) {
+    char buf[32];
+    do_object levels[16];
+    do_object parent = NULL;
+    int value = 0;
+    for (int d = 0; d < depth; d++) {
+        levels[d] = do_create_with_prototype(parent, NULL);
+        for (int i = 0; i < keys_per_level; i++) {
+            // Half of every level shadows its prototype
+            snprintf(buf, sizeof(buf), "k%d_%d", i % 2 ? d : 0, i);
+            do_set(levels[d], buf, &value, sizeof(value));
+        }
+        parent = levels[d];
+    }
+    do_object leaf = levels[depth - 1];
+    
+    int iters = 2000;
+    double start = now_ns();
+    for (int n = 0; n < iters; n++) {
+        const char** keys = do_get_all_keys(leaf);
+        bench_sink += (uintptr_t)arrlen(keys);
+        arrfree(keys);
+    }
+    double all_keys_ns = (now_ns() - start) / iters;
+    
+    start = now_ns();
+    for (int n = 0; n < iters; n++) {
+        do_iter_t it;
+        do_iter_init(&it, leaf, DO_ITER_INHERITED);
+        while (do_iter_next(&it)) bench_sink += (uintptr_t)it.key;
+    }
+    double iter_ns = (now_ns() - start) / iters;
+    
+    fprintf(bench_out, "%-6d %-6d %12.0f %12.0f\n", depth, keys_per_level, all_keys_ns, iter_ns);
+    snprintf(buf, sizeof(buf), "get_all_keys_k%d", keys_per_level);
+    record(buf, depth, all_keys_ns, "ns/walk");
+    snprintf(buf, sizeof(buf), "iterator_k%d", keys_per_level);
+    record(buf, depth, iter_ns, "ns/walk");
+    
+    for (int d = depth - 1; d >= 0; d--) do_release(&levels[d]);
+    do_string_intern_cleanup();
+}
+
+#if DO_CONCURRENT_OBJECTS
+#include <pthread.h>
+
+// A 64-key registry read by `threads` readers while one writer replaces a
+// value every 50 us: lock-free read sections against a mutex around a
+// plain object
+typedef struct {
+    do_object registry;
+    const char** keys;
+    pthread_mutex_t* mutex;         // NULL for the concurrent object
+    atomic_int start;
+    atomic_int stop;
+} shared_bench_t;
+
+enum { SHARED_KEYS = 64, SHARED_LOOKUPS = 2000000 };
+
+static void* shared_reader(void* arg) {
+    shared_bench_t* bench = (shared_bench_t*)arg;
+    uintptr_t sum = 0;
+    while (!atomic_load(&bench->start)) {
+    }
+    for (int i = 0; i < SHARED_LOOKUPS; i++) {
+        const char* key = bench->keys[(i * 7) & (SHARED_KEYS - 1)];
+        if (bench->mutex) {
+            pthread_mutex_lock(bench->mutex);
+            sum += *(uintptr_t*)do_get_interned(bench->registry, key);
+            pthread_mutex_unlock(bench->mutex);
+        } else {
+            do_rcu_read_lock();
+            sum += *(uintptr_t*)do_get_interned(bench->registry, key);
+            do_rcu_read_unlock();
+        }
+    }
+    bench_sink += sum;
+    return NULL;
+}
+
+static void* shared_writer(void* arg) {
+    shared_bench_t* bench = (shared_bench_t*)arg;
+    struct timespec pause = { 0, 50000 };
+    for (uintptr_t n = 0; !atomic_load(&bench->stop); n++) {
+        const char* key = bench->keys[n & (SHARED_KEYS - 1)];
+        if (bench->mutex) pthread_mutex_lock(bench->mutex);
+        do_set_interned(bench->registry, key, &n, sizeof(n));
+        if (bench->mutex) pthread_mutex_unlock(bench->mutex);
+        nanosleep(&pause, NULL);
+    }
+    return NULL;
+}
+
+// Aggregate reads per microsecond
+static double run_shared(int threads, int concurrent) {
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    const char* keys[SHARED_KEYS];
+    char buf[32];
+    shared_bench_t bench;
+    bench.registry = concurrent ? do_create_concurrent(NULL) : do_create(NULL);
+    bench.keys = keys;
+    bench.mutex = concurrent ? NULL : &mutex;
+    atomic_init(&bench.start, 0);
+    atomic_init(&bench.stop, 0);
+    for (uintptr_t i = 0; i < SHARED_KEYS; i++) {
+        snprintf(buf, sizeof(buf), "service_%d", (int)i);
+        keys[i] = do_string_intern(buf);
+        do_set_interned(bench.registry, keys[i], &i, sizeof(i));
+    }
+    
+    pthread_t readers[16];
+    pthread_t writer;
+    for (int t = 0; t < threads; t++) pthread_create(&readers[t], NULL, shared_reader, &bench);
+    pthread_create(&writer, NULL, shared_writer, &bench);
+    double start = now_ns();
+    atomic_store(&bench.start, 1);
+    for (int t = 0; t < threads; t++) pthread_join(readers[t], NULL);
+    double elapsed_us = (now_ns() - start) / 1e3;
+    atomic_store(&bench.stop, 1);
+    pthread_join(writer, NULL);
+    
+    do_release(&bench.registry);
+    do_rcu_synchronize();
+    do_string_intern_cleanup();
+    return (double)threads * SHARED_LOOKUPS / elapsed_us;
+}
+
+static void bench_shared(int threads) {
+    double mutex_rate = run_shared(threads, 0);
+    double rcu_rate = run_shared(threads, 1);
+    fprintf(bench_out, "%-10d %12.1f %12.1f\n", threads, mutex_rate, rcu_rate);
+    record("mutex", threads, mutex_rate, "reads/us");
+    record("rcu", threads, rcu_rate, "reads/us");
+}
+#endif
+
+/* =============================================================================
+ * SUITES
+ * ============================================================================= */
+
+static void suite_intern(void) {
+    fprintf(bench_out, "string interning (ns/op)\n");
+    fprintf(bench_out, "%-10s %12s %12s %12s\n", "keys", "insert", "hit", "miss");
+    for (int size = 100; size <= 1000000; size *= 10) {
+        bench_intern(size);
+    }
+    fprintf(bench_out, "\nslices (ns/op)\n");
+    fprintf(bench_out, "%-10s %12s %12s\n", "keys", "copy", "intern_n");
+    for (int size = 100; size <= 100000; size *= 10) {
+        bench_intern_slices(size);
+    }
+}
+
+static void suite_prototype(void) {
+    fprintf(bench_out, "prototype lookup (ns/op)\n");
+    fprintf(bench_out, "%-10s %12s %12s\n", "depth", "interned", "cached");
+    for (int depth = 0; depth <= 16; depth++) {
+        bench_cached_get(depth);
+    }
+}
+
+static void suite_own(void) {
+    fprintf(bench_out, "own get/set (ns/op)\n");
+    fprintf(bench_out, "%-10s %-8s %12s %12s\n", "props", "mode", "get", "set");
+    int counts[] = { 1, 4, 8, DO_HASH_THRESHOLD, DO_HASH_THRESHOLD + 2, 64, 1000 };
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        bench_own_access(counts[i]);
+    }
+}
+
+static void suite_key_scan(void) {
+    fprintf(bench_out, "own key lookup kernels (ns/op)\n");
+    fprintf(bench_out, "%-10s %12s %12s %12s\n", "keys", "scalar", "vector", "hash");
+    int scan_counts[] = { 1, 2, 4, 8, 12, 16, 24, 32, 48, 64 };
+    for (size_t i = 0; i < sizeof(scan_counts) / sizeof(scan_counts[0]); i++) {
+        bench_key_scan(scan_counts[i]);
+    }
+}
+
+static void suite_table(void) {
+    fprintf(bench_out, "large object table (ns/op)\n");
+    fprintf(bench_out, "%-10s %12s %12s %12s %12s\n", "props", "hit", "miss", "stb_ds hit", "del+insert");
+    for (int count = 50; count <= 50000; count *= 10) {
+        bench_table(count);
+    }
+}
+
+static void suite_upgrade(void) {
+    fprintf(bench_out, "linear to hash upgrade (ns/op)\n");
+    fprintf(bench_out, "%-10s %12s %12s\n", "threshold", "append", "upgrade");
+    bench_upgrade();
+    
+    fprintf(bench_out, "\nfill to N properties (ns/object)\n");
+    fprintf(bench_out, "%-10s %12s %12s\n", "props", "grow", "reserved");
+    for (int props = DO_HASH_THRESHOLD / 2; props <= DO_HASH_THRESHOLD * 16; props *= 4) {
+        bench_fill(props);
+    }
+}
+
+static void suite_churn(void) {
+    fprintf(bench_out, "create/set/release, %s (ns/object)\n",
+            DO_POOL_ALLOCATOR ? "pool allocator" : "DO_MALLOC");
+    fprintf(bench_out, "%-10s %-10s %12s\n", "props", "bytes", "churn");
+    bench_churn(1, sizeof(int));
+    bench_churn(4, sizeof(int));
+    bench_churn(4, 32);
+    bench_churn(16, sizeof(int));
+    bench_churn(16, 64);
+}
+
+static void suite_overwrite(void) {
+    fprintf(bench_out, "property overwrite (ns/op)\n");
+    fprintf(bench_out, "%-10s %12s %12s\n", "bytes", "set", "reserve");
+    bench_update(8);
+    bench_update(64);
+    bench_update(256);
+}
+
+static void suite_batch(void) {
+    fprintf(bench_out, "build + read back one object (ns/object)\n");
+    fprintf(bench_out, "%-10s %12s %12s\n", "batch", "single", "many");
+    bench_batch(4);
+    bench_batch(8);
+    bench_batch(16);
+    bench_batch(30);
+}
+
+static void suite_clone(void) {
+    fprintf(bench_out, "instances of an 8-property template (ns/object)\n");
+    fprintf(bench_out, "%12s %12s %12s\n", "key by key", "clone", "clone+write");
+    bench_clone();
+}
+
+static void suite_teardown(void) {
+    fprintf(bench_out, "teardown of 8-property objects (us total)\n");
+    fprintf(bench_out, "%-10s %12s %12s\n", "objects", "release", "arena reset");
+    for (int count = 1000; count <= 100000; count *= 10) {
+        bench_teardown(count);
+    }
+}
+
+static void suite_refcount(void) {
+    fprintf(bench_out, "retain + release, %s (ns/op)\n",
+            DO_BIASED_REFCOUNT ? "biased" : DO_ATOMIC_REFCOUNT ? "atomic" : "non-atomic");
+    fprintf(bench_out, "%12s %12s\n", "owner", "other");
+    bench_refcount();
+}
+
+static void suite_snapshot(void) {
+    fprintf(bench_out, "prototype library of 32-method classes (us total)\n");
+    fprintf(bench_out, "%-10s %12s %12s\n", "classes", "build", "map");
+    for (int classes = 100; classes <= 10000; classes *= 10) {
+        bench_snapshot(classes);
+    }
+}
+
+static void suite_enumerate(void) {
+    fprintf(bench_out, "enumerate every key of a hierarchy (ns/walk)\n");
+    fprintf(bench_out, "%-6s %-6s %12s %12s\n", "depth", "keys", "get_all_keys", "iterator");
+    bench_enumerate(1, 8);
+    bench_enumerate(4, 8);
+    bench_enumerate(4, 64);
+    bench_enumerate(8, 64);
+    bench_enumerate(8, 256);
+}
+
+#if DO_CONCURRENT_OBJECTS
+static void suite_shared(void) {
+    fprintf(bench_out, "readers of a shared registry, one writer (reads/us, all threads)\n");
+    fprintf(bench_out, "%-10s %12s %12s\n", "readers", "mutex", "rcu");
+    for (int threads = 1; threads <= 16; threads *= 2) {
+        bench_shared(threads);
+    }
+}
+#endif
+
+static const struct {
+    const char* name;
+    void (*run)(void);
+} suites[] = {
+    { "intern", suite_intern },
+    { "prototype", suite_prototype },
+    { "own", suite_own },
+    { "key_scan", suite_key_scan },
+    { "table", suite_table },
+    { "upgrade", suite_upgrade },
+    { "churn", suite_churn },
+    { "overwrite", suite_overwrite },
+    { "batch", suite_batch },
+    { "clone", suite_clone },
+    { "teardown", suite_teardown },
+    { "enumerate", suite_enumerate },
+    { "refcount", suite_refcount },
+    { "snapshot", suite_snapshot },
+#if DO_CONCURRENT_OBJECTS
+    { "shared", suite_shared },
+#endif
+};
+
+#define SUITE_COUNT ((int)(sizeof(suites) / sizeof(suites[0])))
+
+int main(int argc, char** argv) {
+    const char* json_path = NULL;
+    int selected[SUITE_COUNT] = {0};
+    int any_selected = 0;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+            continue;
+        }
+        int found = 0;
+        for (int s = 0; s < SUITE_COUNT; s++) {
+            if (strcmp(argv[i], suites[s].name) == 0) selected[s] = found = any_selected = 1;
+        }
+        if (!found) {
+            fprintf(stderr, "usage: %s [--json FILE] [SUITE...]\nsuites:", argv[0]);
+            for (int s = 0; s < SUITE_COUNT; s++) fprintf(stderr, " %s", suites[s].name);
+            fprintf(stderr, "\n");
+            return 1;
+        }
+    }
+    
+    bench_out = json_path && strcmp(json_path, "-") == 0 ? stderr : stdout;
+    
+    int first = 1;
+    for (int s = 0; s < SUITE_COUNT; s++) {
+        if (any_selected && !selected[s]) continue;
+        if (!first) fprintf(bench_out, "\n");
+        first = 0;
+        bench_suite = suites[s].name;
+        suites[s].run();
+        fflush(bench_out);
+    }
+    
+    if (json_path) {
+        FILE* file = strcmp(json_path, "-") == 0 ? stdout : fopen(json_path, "w");
+        if (!file) {
+            fprintf(stderr, "cannot write %s\n", json_path);
+            arrfree(bench_results);
+            return 1;
+        }
+        write_json(file);
+        if (file != stdout) fclose(file);
+    }
+    
+    arrfree(bench_results);
+    return 0;
+}
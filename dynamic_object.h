@@ -75,13 +75,153 @@ extern "C" {
 #define DO_ATOMIC_REFCOUNT 0  // Default to non-atomic
 #endif
 
+// Biased reference counting: the creating thread counts its own references
+// without read-modify-writes, other threads share an atomic count
+#ifndef DO_BIASED_REFCOUNT
+#define DO_BIASED_REFCOUNT 0
+#endif
+#if DO_BIASED_REFCOUNT && !DO_ATOMIC_REFCOUNT
+#error "DO_BIASED_REFCOUNT requires DO_ATOMIC_REFCOUNT"
+#endif
+
 // Property storage optimization threshold
 #ifndef DO_HASH_THRESHOLD
-#define DO_HASH_THRESHOLD 8  // Switch to hash table after N properties
+#define DO_HASH_THRESHOLD 16  // Switch to hash table after N properties
+#endif
+
+// Hashed objects deleted down to this many properties move back to shape
+// slots; the gap below DO_HASH_THRESHOLD keeps objects hovering near one
+// size from switching back and forth (-1 = never downgrade)
+#ifndef DO_HASH_DOWNGRADE_THRESHOLD
+#define DO_HASH_DOWNGRADE_THRESHOLD (DO_HASH_THRESHOLD / 4)
+#endif
+
+// Values up to this many bytes are stored inside the property slot itself
+#ifndef DO_INLINE_SIZE
+#define DO_INLINE_SIZE 16  // Must be at least sizeof(void*), and 8 with DO_TAGGED_VALUES
+#endif
+
+// Shapes with this many outgoing transitions are treated as megamorphic;
+// objects that would add another one switch to hash storage instead
+#ifndef DO_SHAPE_MAX_TRANSITIONS
+#define DO_SHAPE_MAX_TRANSITIONS 64
+#endif
+
+// Entries in the per-thread (prototype, key) -> holder lookup cache used
+// by do_get_interned for inherited properties
+#ifndef DO_PROTO_CACHE_SIZE
+#define DO_PROTO_CACHE_SIZE 0  // Entries (power of two), 0 = disabled
+#endif
+
+// Recycle small object headers and property blocks through per-thread
+// size-class free lists instead of going to DO_MALLOC/DO_FREE every time
+#ifndef DO_POOL_ALLOCATOR
+#define DO_POOL_ALLOCATOR 0
+#endif
+
+// Largest block (bytes) served by the pool; larger requests bypass it
+#ifndef DO_POOL_MAX_BLOCK
+#define DO_POOL_MAX_BLOCK 256
+#endif
+
+// Free blocks each thread keeps per size class before returning them to DO_FREE
+#ifndef DO_POOL_MAX_FREE
+#define DO_POOL_MAX_FREE 256
+#endif
+
+// Trial-deletion cycle collector for objects that reference each other
+// through property values (see do_collect_cycles)
+#ifndef DO_CYCLE_COLLECTOR
+#define DO_CYCLE_COLLECTOR 0
+#endif
+#if DO_CYCLE_COLLECTOR && DO_ATOMIC_REFCOUNT
+#error "DO_CYCLE_COLLECTOR cannot be combined with DO_ATOMIC_REFCOUNT"
+#endif
+
+// Queue objects whose last reference is released and destroy them in
+// do_drain_releases instead of inside do_release
+#ifndef DO_DEFERRED_RELEASE
+#define DO_DEFERRED_RELEASE 0
+#endif
+
+// Binary snapshots of object graphs (do_snapshot_write, do_snapshot_map);
+// files are memory-mapped on POSIX systems and read in elsewhere
+#ifndef DO_SNAPSHOT
+#define DO_SNAPSHOT 0
+#endif
+
+// Typed values: do_set_i64/f64/ptr/obj store a type tag next to the
+// inline payload; object references are retained while stored
+#ifndef DO_TAGGED_VALUES
+#define DO_TAGGED_VALUES 0
+#endif
+#if DO_TAGGED_VALUES && !DO_STRING_INTERNING
+#error "DO_TAGGED_VALUES requires DO_STRING_INTERNING"
+#endif
+#if DO_TAGGED_VALUES && DO_INLINE_SIZE < 8
+#error "DO_TAGGED_VALUES requires DO_INLINE_SIZE of at least 8"
+#endif
+
+// do_create_concurrent objects: lock-free readers over published versions,
+// reclaimed once no read section can see them (see do_rcu_read_lock)
+#ifndef DO_CONCURRENT_OBJECTS
+#define DO_CONCURRENT_OBJECTS 0
+#endif
+#if DO_CONCURRENT_OBJECTS && !(DO_ATOMIC_REFCOUNT && DO_STRING_INTERNING)
+#error "DO_CONCURRENT_OBJECTS requires DO_ATOMIC_REFCOUNT and DO_STRING_INTERNING"
+#endif
+
+// Default bytes per arena chunk (see do_arena_create)
+#ifndef DO_ARENA_CHUNK_SIZE
+#define DO_ARENA_CHUNK_SIZE 65536
+#endif
+
+// Initial slot count of the string intern table (must be a power of two)
+#ifndef DO_INTERN_INITIAL_CAPACITY
+#define DO_INTERN_INITIAL_CAPACITY 64
+#endif
+
+// Thread-safe string interning (requires C11 atomics)
+#ifndef DO_INTERN_CONCURRENT
+#define DO_INTERN_CONCURRENT 0  // Default to single-threaded intern table
+#endif
+
+// Concurrent intern table is split into 2^N independently locked shards
+#ifndef DO_INTERN_SHARD_BITS
+#define DO_INTERN_SHARD_BITS 6
+#endif
+
+// Per-thread direct-mapped cache in front of the concurrent intern table
+#ifndef DO_INTERN_TLS_CACHE
+#define DO_INTERN_TLS_CACHE 0  // Entries (power of two), 0 = disabled
+#endif
+
+// Intern contexts: per-tenant key tables whose unused keys can be swept
+// (see do_context_create; requires C11 atomics)
+#ifndef DO_INTERN_CONTEXT
+#define DO_INTERN_CONTEXT 0
+#endif
+#if DO_INTERN_CONTEXT && !DO_STRING_INTERNING
+#error "DO_INTERN_CONTEXT requires DO_STRING_INTERNING"
+#endif
+
+// Per-thread counters on the lookup, allocation and interning paths, read
+// with do_stats_snapshot (requires C11 atomics; 0 compiles them all out)
+#ifndef DO_STATS
+#define DO_STATS 0
+#endif
+
+// Prototype walks are histogrammed by levels visited; the last bucket
+// also collects every deeper walk
+#ifndef DO_STATS_DEPTH_BUCKETS
+#define DO_STATS_DEPTH_BUCKETS 8
 #endif
 
 // Atomic operations (inherit from dynamic_array.h)
-#if DO_ATOMIC_REFCOUNT
+#if DO_ATOMIC_REFCOUNT && defined(__cplusplus) && !defined(DO_IMPLEMENTATION)
+    // C++ code sees only the declarations (dynamic_object.hpp), where
+    // do_object_t is opaque, so no C++ type stands in for _Atomic int
+#elif DO_ATOMIC_REFCOUNT
     #include <stdatomic.h>
     #define DO_ATOMIC_INT _Atomic int
     #define DO_ATOMIC_LOAD(ptr) atomic_load(ptr)
@@ -95,6 +235,45 @@ extern "C" {
     #define DO_ATOMIC_FETCH_ADD_VOID(ptr, val) (void)((*(ptr) += (val)) - (val))
 #endif
 
+// Thread-local storage qualifier
+#ifndef DO_THREAD_LOCAL
+#if defined(__cplusplus) && __cplusplus >= 201103L
+    #define DO_THREAD_LOCAL thread_local
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+    #define DO_THREAD_LOCAL _Thread_local
+#elif defined(_MSC_VER)
+    #define DO_THREAD_LOCAL __declspec(thread)
+#else
+    #define DO_THREAD_LOCAL __thread
+#endif
+#endif
+
+// Spin-wait hint for internal spinlocks
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define DO_CPU_RELAX() __builtin_ia32_pause()
+#elif defined(__GNUC__) && defined(__aarch64__)
+    #define DO_CPU_RELAX() __asm__ __volatile__("yield")
+#else
+    #define DO_CPU_RELAX() ((void)0)
+#endif
+
+// Vectorized key compares for slot lookup: AVX2, SSE2 or NEON when the
+// compiler targets them and pointers are 64-bit (0 = scalar loop only)
+#ifndef DO_SIMD
+#define DO_SIMD 1
+#endif
+
+#if DO_SIMD && UINTPTR_MAX == 0xFFFFFFFFFFFFFFFFu
+    #if defined(__AVX2__)
+        #define DO_SIMD_AVX2 1
+    #endif
+    #if defined(__SSE2__) || defined(_M_X64)
+        #define DO_SIMD_SSE2 1
+    #elif defined(__ARM_NEON) && defined(__aarch64__)
+        #define DO_SIMD_NEON 1
+    #endif
+#endif
+
 // Function decoration
 #ifndef DO_DEF
 #ifdef DO_STATIC
@@ -109,54 +288,194 @@ extern "C" {
 #define DO_ERROR_CYCLE -1
 #define DO_ERROR_MEMORY -2
 #define DO_ERROR_NULL_PARAM -3
+#define DO_ERROR_FROZEN -4
+#define DO_ERROR_IO -5
 
 /* =============================================================================
  * TYPE DEFINITIONS
  * ============================================================================= */
 
+// Object flag bits (do_object_t.flags)
+#define DO_OBJECT_PROTOTYPE 0x1  // Has been used as some object's prototype
+#define DO_OBJECT_GC_COLOR  0x6  // Cycle collector color (DO_CYCLE_COLLECTOR)
+#define DO_OBJECT_GC_FREE   0x8  // Found to be cyclic garbage, being freed
+#define DO_OBJECT_FROZEN    0x10 // Immutable and immortal (do_freeze)
+#define DO_OBJECT_VALUE_REFS 0x20 // Has held DO_TYPE_OBJ values (DO_TAGGED_VALUES)
+#define DO_OBJECT_CONCURRENT 0x40 // Properties live in published versions (do_create_concurrent)
+
+// Property value types (DO_TAGGED_VALUES, see do_get_type)
+#define DO_TYPE_NONE  -1  // No such property
+#define DO_TYPE_BYTES 0   // Untyped bytes written by do_set and friends
+#define DO_TYPE_I64   1   // int64_t
+#define DO_TYPE_F64   2   // double
+#define DO_TYPE_PTR   3   // Pointer the object does not own
+#define DO_TYPE_OBJ   4   // do_object, retained while stored (may be NULL)
+
+// do_freeze flags
+#define DO_FREEZE_PROTOTYPES 0x1  // Also freeze every object up the prototype chain
+
 typedef struct do_object_t* do_object;
+typedef struct do_arena_t* do_arena;
+
+/**
+ * @brief Callback receiving one object referenced from a property value
+ */
+typedef void (*do_visit_fn)(do_object child, void* context);
+
+/**
+ * @brief Report the objects a property value holds references to
+ * 
+ * Called by the cycle collector for every property of an object with a
+ * trace function. It must call visit(child, context) once for each
+ * reference the value owns - the ones the object's release_fn drops.
+ */
+typedef void (*do_trace_fn)(void* value, size_t size, do_visit_fn visit, void* context);
+
+/**
+ * @brief Allocation hooks for the memory of a group of objects
+ * 
+ * Objects created on a thread while an allocator is installed there (see
+ * do_set_allocator) take their header and all of their property storage
+ * from it for their whole lifetime, whichever thread later writes or
+ * frees them. Every call receives the block size and `context`, so hooks
+ * can keep per-tenant totals and enforce quotas by returning NULL; the
+ * library call that needed the memory then fails with DO_ERROR_MEMORY
+ * (or returns NULL).
+ */
+typedef struct do_allocator_t {
+    void* (*alloc)(size_t size, void* context);
+    void* (*resize)(void* ptr, size_t old_size, size_t new_size, void* context);  // Optional
+    void (*free)(void* ptr, size_t size, void* context);
+    void* context;
+} do_allocator_t;
 
 /**
  * @brief Property storage structure for generic data
  * 
  * Stores arbitrary data types using void* + size pattern, similar to
- * dynamic_array.h element storage. No destructor needed - the object's
- * release_fn handles cleanup of property values.
+ * dynamic_array.h element storage. Values of up to DO_INLINE_SIZE bytes
+ * live inside the slot; larger values are kept in a separate heap buffer,
+ * which is reused by later writes that fit in its capacity.
+ * The key is not stored here - it lives in the object's shape (or in the
+ * hash entry for hashed objects). No destructor needed - the object's
+ * release_fn handles cleanup of property values. With DO_TAGGED_VALUES the
+ * size shrinks to 32 bits to make room for the type tag.
  */
 typedef struct {
-    const char* key;     // Interned string key (pointer equality)
-    void* data;          // Generic data pointer
+#if DO_TAGGED_VALUES
+    uint32_t size;       // Size of data in bytes
+    uint32_t type;       // DO_TYPE_* of the value
+#else
     size_t size;         // Size of data in bytes
+#endif
+    union {
+        unsigned char bytes[DO_INLINE_SIZE]; // Inline storage (size <= DO_INLINE_SIZE)
+        struct {
+            void* ptr;                       // Heap buffer (size > DO_INLINE_SIZE)
+            size_t capacity;                 // Allocated bytes at ptr
+        } heap;
+        long long align_ll;                  // Alignment for inline scalars
+        double align_d;
+    } data;
 } do_property_t;
 
 /**
- * @brief Hash map entry for stb_ds hash table
+ * @brief Property table entry (hash mode)
  */
 typedef struct {
-    const char* key;     // Hash map key (interned string)
+    const char* key;     // Interned key, NULL for a deleted entry
     do_property_t value; // Property value
 } do_hash_entry_t;
 
+/**
+ * @brief Open-addressing property table for large objects
+ * 
+ * Swiss-table style: one control byte per slot (empty, deleted, or 7 bits
+ * of the key's hash) is probed 16 at a time, and slots hold indices into a
+ * dense entries array kept in insertion order. Keys are interned, so they
+ * are hashed and compared by pointer and stored once, in the entry.
+ * Deletes leave a hole in entries that iteration skips; holes and deleted
+ * control bytes are purged when the table is rebuilt, which also happens
+ * once inserts have used up growth_left (so probes always reach an empty
+ * slot, however many set/delete cycles the table sees). The table, its
+ * control bytes, slots and entries are one allocation.
+ */
+typedef struct do_hash_table_t {
+    uint8_t* ctrl;               // capacity control bytes + a mirrored first group
+    uint32_t* index;             // Entry index for each full slot
+    do_hash_entry_t* entries;    // Insertion order, key == NULL for holes
+    uint32_t capacity;           // Slots (power of two, at least 16)
+    uint32_t count;              // Live entries
+    uint32_t used;               // Entries appended, holes included
+    uint32_t entry_capacity;     // Room in entries (7/8 of capacity)
+    uint32_t growth_left;        // Empty slots that may still be filled
+} do_hash_table_t;
+
+/**
+ * @brief Shared key layout (hidden class) for objects in slot mode
+ * 
+ * A shape maps interned keys to slot indices. Objects that receive the
+ * same keys in the same order share one shape, found by following the
+ * transition tree rooted at the empty shape. Shapes are immutable once
+ * created and reference counted by objects and child shapes.
+ */
+typedef struct do_shape_t {
+    uint64_t id;                    // Unique for the process lifetime (never reused)
+    int ref_count;                  // Objects and child shapes using this shape
+    struct do_shape_t* parent;      // Shape before `key` was added (NULL for root)
+    const char* key;                // Key added by the transition from parent
+    const char** keys;              // keys[i] is the key stored in slot i
+    int slot_count;                 // Number of keys in this layout
+    struct {
+        const char* key;
+        struct do_shape_t* value;
+    }* transitions;                 // stb_ds hash map: key -> child (non-owning)
+} do_shape_t;
+
 /**
  * @brief Dynamic object structure with prototype-based inheritance
  * 
- * Uses hybrid storage: linear array for small objects (cache-friendly),
- * hash table for large objects (O(1) access). Automatic upgrade at threshold.
+ * Uses hybrid storage: a flat slot array described by a shared shape for
+ * small objects (cache-friendly, no per-object keys), hash table for large
+ * or megamorphic objects (O(1) access). Automatic upgrade at threshold.
  * 
  * The release_fn is called on property values when they are removed or
  * the object is destroyed, enabling proper cleanup of reference-counted values.
+ *
+ * Opaque to C++ translation units, which only go through the API.
  */
+#if !defined(__cplusplus) || defined(DO_IMPLEMENTATION)
 typedef struct do_object_t {
-    DO_ATOMIC_INT ref_count;        // Reference counting (object-level)
+    DO_ATOMIC_INT ref_count;        // Reference counting (object-level; shared part when biased)
     struct do_object_t* prototype;  // Inheritance chain
     void (*release_fn)(void*);      // Called on property values when removed
+    do_shape_t* shape;              // Key layout in slot mode (NULL when hashed)
     union {
-        do_property_t* linear_props; // stb_ds array for small objects
-        do_hash_entry_t* hash_props; // stb_ds hash map for large objects
+        do_property_t* slots;        // Slot values, indexed by shape slot
+        do_hash_table_t* table;      // Property table for large objects
+        struct do_concurrent_t* concurrent; // Versions of a DO_OBJECT_CONCURRENT object
     } properties;
-    int is_hashed;                  // 0 = linear array, 1 = hash table
+    int is_hashed;                  // 0 = shape + slots, 1 = hash table
+    int flags;                      // DO_OBJECT_* bits
     int property_count;             // Number of own properties
+    int slot_capacity;              // Allocated length of properties.slots
+    struct do_arena_t* arena;       // Owning arena, NULL for heap objects
+    struct do_share_t* share;       // Set while properties are shared with clones
+    const do_allocator_t* allocator; // Source of header and storage, NULL for do_alloc
+#if DO_CYCLE_COLLECTOR
+    do_trace_fn trace_fn;           // Finds object references in property values
+    int gc_root;                    // Index in the candidate buffer, -1 if not buffered
+#endif
+#if DO_DEFERRED_RELEASE
+    struct do_object_t* next_release; // Link in the deferred release queue
+#endif
+#if DO_BIASED_REFCOUNT
+    struct do_brc_thread_t* owner;  // Creating thread, NULL if all counts are shared
+    DO_ATOMIC_INT ref_local;        // Owner's references, written only by the owner
+    struct do_object_t* next_merge; // Link in the owner's merge queue
+#endif
 } do_object_t;
+#endif
 
 /* =============================================================================
  * STRING INTERNING SYSTEM
@@ -169,9 +488,58 @@ typedef struct do_object_t {
  * @param str String to intern (must not be NULL)
  * @return Interned string pointer (stable across calls)
  * @note Interned strings enable pointer-based key comparison for performance
+ * @note With DO_INTERN_CONCURRENT, safe to call from any thread; lookups of
+ *       already-interned strings never take a lock
  */
 DO_DEF const char* do_string_intern(const char* str);
 
+/**
+ * @brief Intern the first len bytes of str, e.g. a slice of a source buffer
+ * @param str Bytes to intern (must not be NULL or contain NUL; need not be terminated)
+ * @param len Number of bytes
+ * @return Interned, NUL-terminated copy, or NULL on allocation failure
+ */
+DO_DEF const char* do_string_intern_n(const char* str, size_t len);
+
+/**
+ * @brief Intern a slice whose hash the caller already computed
+ * @param str Bytes to intern (same requirements as do_string_intern_n)
+ * @param len Number of bytes
+ * @param hash do_string_hash(str, len), e.g. accumulated with
+ *             DO_STRING_HASH_STEP while scanning the bytes
+ * @return Interned, NUL-terminated copy, or NULL on allocation failure
+ * @note The bytes are only read again to compare against interned strings
+ *       with the same hash and length
+ */
+DO_DEF const char* do_string_intern_hashed(const char* str, size_t len, size_t hash);
+
+/**
+ * @brief Hash used by the intern table (djb2)
+ * @param str Bytes to hash (may be NULL if len is 0)
+ * @param len Number of bytes
+ * @return Hash of the bytes
+ */
+DO_DEF size_t do_string_hash(const char* str, size_t len);
+
+// Incremental form of do_string_hash: start from DO_STRING_HASH_INIT and
+// apply DO_STRING_HASH_STEP to each byte in order
+#define DO_STRING_HASH_INIT ((size_t)5381)
+#define DO_STRING_HASH_STEP(hash, c) ((hash) * 33 + (unsigned char)(c))
+
+/**
+ * @brief Length of an interned string, read from its header
+ * @param interned String returned by the intern functions
+ * @return Bytes before the terminating NUL
+ */
+DO_DEF size_t do_interned_length(const char* interned);
+
+/**
+ * @brief do_string_hash of an interned string, read from its header
+ * @param interned String returned by the intern functions
+ * @return Hash of the string
+ */
+DO_DEF size_t do_interned_hash(const char* interned);
+
 /**
  * @brief Check if string is already interned
  * @param str String to check
@@ -182,6 +550,8 @@ DO_DEF const char* do_string_find_interned(const char* str);
 /**
  * @brief Clear the string interning table (for cleanup/testing)
  * @warning This invalidates all previously interned strings
+ * @warning Not thread-safe, even with DO_INTERN_CONCURRENT - no other thread
+ *          may intern or look up strings while the table is cleared
  */
 DO_DEF void do_string_intern_cleanup(void);
 
@@ -211,6 +581,21 @@ DO_DEF do_object do_create(void (*release_fn)(void*));
  */
 DO_DEF do_object do_create_with_prototype(do_object prototype, void (*release_fn)(void*));
 
+/**
+ * @brief Create a copy of an object's own properties, sharing its prototype
+ * @param source Object to copy (must not be NULL)
+ * @return New heap object with reference count 1, or NULL on allocation failure
+ * @note Copy-on-write: the clone shares the source's property storage until
+ *       either of them is modified (set, delete or do_get_mut), at which
+ *       point the writer takes a private copy. Arena sources are copied
+ *       immediately
+ * @note Values are duplicated bytewise, like do_set of the same bytes.
+ *       release_fn runs once per stored copy - a never-modified clone does
+ *       not add a call - so objects whose values own resources through
+ *       release_fn should not be cloned
+ */
+DO_DEF do_object do_clone(do_object source);
+
 /**
  * @brief Increment object reference count
  * @param obj Object to retain (must not be NULL)
@@ -221,9 +606,44 @@ DO_DEF do_object do_retain(do_object obj);
 /**
  * @brief Decrement reference count and free if zero
  * @param obj Pointer to object pointer (will be set to NULL)
+ * @note With DO_DEFERRED_RELEASE an object released for the last time is
+ *       only queued; do_drain_releases destroys it later
  */
 DO_DEF void do_release(do_object* obj);
 
+/**
+ * @brief Destroy objects queued by their last do_release
+ * @param budget Most objects to destroy, SIZE_MAX to empty the queue
+ * @return Number of objects destroyed (0 once the queue is empty)
+ * @note Destroying an object runs its release_fn and releases its
+ *       prototype; objects whose count drops to zero join the queue rather than
+ *       being destroyed recursively, so the stack never grows with the
+ *       size of the graph. Safe to call from any thread with
+ *       DO_ATOMIC_REFCOUNT; drains from several threads take turns.
+ *       Always returns 0 without DO_DEFERRED_RELEASE.
+ */
+DO_DEF size_t do_drain_releases(size_t budget);
+
+/**
+ * @brief Merge the objects other threads queued for the calling thread
+ * @return Number of objects merged
+ * @note With DO_BIASED_REFCOUNT, an object released more often on other
+ *       threads than it was retained there is queued for its creating
+ *       thread, which folds its private count into the shared one (and
+ *       destroys the object if no references are left). Queues are also
+ *       merged by the owner's next do_release. Always returns 0 otherwise.
+ */
+DO_DEF size_t do_refcount_merge(void);
+
+/**
+ * @brief Give up ownership of the calling thread's objects
+ * @note Call before a thread that created objects exits, or they may never
+ *       be freed. Pending merges are done now and later ones by the
+ *       releasing thread. The thread may go on using objects, and owns the
+ *       ones it creates afterwards. No-op without DO_BIASED_REFCOUNT.
+ */
+DO_DEF void do_refcount_thread_exit(void);
+
 /**
  * @brief Get current reference count
  * @param obj Object to query (must not be NULL)
@@ -231,6 +651,35 @@ DO_DEF void do_release(do_object* obj);
  */
 DO_DEF int do_get_ref_count(do_object obj);
 
+/**
+ * @brief Make an object immutable and immortal
+ * @param obj Object to freeze (must not be NULL)
+ * @param flags 0 or DO_FREEZE_PROTOTYPES
+ * @note Afterwards do_retain and do_release leave the reference count
+ *       untouched, so threads sharing the object never write to it.
+ *       Setters return DO_ERROR_FROZEN, deleters remove nothing,
+ *       do_get_mut returns NULL and do_clone copies instead of sharing.
+ * @note Freeze before other threads can see the object. Frozen heap objects
+ *       live until do_frozen_cleanup; frozen arena objects still die with
+ *       their arena
+ */
+DO_DEF void do_freeze(do_object obj, int flags);
+
+/**
+ * @brief Check whether do_freeze has been applied to an object
+ * @param obj Object to query (must not be NULL)
+ * @return 1 if frozen, 0 otherwise
+ */
+DO_DEF int do_is_frozen(do_object obj);
+
+/**
+ * @brief Destroy every frozen heap object
+ * @note For shutdown: no references to frozen objects may be used afterwards.
+ *       Their release_fn runs and the references they hold are released
+ *       before any of them is freed, so frozen objects may refer to each other
+ */
+DO_DEF void do_frozen_cleanup(void);
+
 /* =============================================================================
  * PROTOTYPE CHAIN MANAGEMENT
  * ============================================================================= */
@@ -239,7 +688,8 @@ DO_DEF int do_get_ref_count(do_object obj);
  * @brief Set object's prototype (with cycle detection)
  * @param obj Object to modify (must not be NULL)
  * @param prototype New prototype (can be NULL)
- * @return DO_SUCCESS or DO_ERROR_CYCLE if would create circular reference
+ * @return DO_SUCCESS, DO_ERROR_CYCLE if would create circular reference,
+ *         or DO_ERROR_FROZEN if obj is frozen
  */
 DO_DEF int do_set_prototype(do_object obj, do_object prototype);
 
@@ -259,7 +709,9 @@ DO_DEF do_object do_get_prototype(do_object obj);
  * @param obj Object to search (must not be NULL)
  * @param key Property key (must not be NULL)
  * @return Pointer to property data, or NULL if not found
- * @note Returned pointer is valid until property is modified or object released
+ * @note Returned pointer is valid until the owning object is modified (any
+ *       set or delete, since small values live inline in relocatable storage)
+ *       or released
  */
 DO_DEF void* do_get(do_object obj, const char* key);
 
@@ -269,10 +721,34 @@ DO_DEF void* do_get(do_object obj, const char* key);
  * @param key Property key (must not be NULL)
  * @param data Data to store (must not be NULL)
  * @param size Size of data in bytes
- * @return DO_SUCCESS or error code
+ * @return DO_SUCCESS or error code (DO_ERROR_FROZEN on a frozen object)
  */
 DO_DEF int do_set(do_object obj, const char* key, const void* data, size_t size);
 
+/**
+ * @brief Make an own property `size` bytes long and return its storage for writing
+ * @param obj Object to modify (must not be NULL)
+ * @param key Property key (must not be NULL)
+ * @param size Size of the value in bytes
+ * @return Writable pointer to the value, or NULL on allocation failure
+ * @note Replaces the value like do_set (release_fn runs on the old one) but
+ *       copies nothing: the caller fills in the storage. An existing heap
+ *       buffer that is large enough is reused, in which case it still holds
+ *       the old bytes; otherwise the contents are uninitialized
+ * @note The pointer is valid under the same rules as do_get
+ */
+DO_DEF void* do_set_reserve(do_object obj, const char* key, size_t size);
+
+/**
+ * @brief Get writable pointer to an own property's value
+ * @param obj Object to search (must not be NULL)
+ * @param key Property key (must not be NULL)
+ * @return Pointer to the value, or NULL if obj has no own property key
+ * @note Writes go straight to the stored value; release_fn is not called.
+ *       Inherited properties are not returned - set them on obj first
+ */
+DO_DEF void* do_get_mut(do_object obj, const char* key);
+
 /**
  * @brief Check if property exists (searches prototype chain)
  * @param obj Object to search (must not be NULL) 
@@ -321,6 +797,23 @@ DO_DEF void* do_get_interned(do_object obj, const char* interned_key);
  */
 DO_DEF int do_set_interned(do_object obj, const char* interned_key, const void* data, size_t size);
 
+/**
+ * @brief Reserve property storage using pre-interned key (see do_set_reserve)
+ * @param obj Object to modify (must not be NULL)
+ * @param interned_key Pre-interned key (must be interned)
+ * @param size Size of the value in bytes
+ * @return Writable pointer to the value, or NULL on allocation failure
+ */
+DO_DEF void* do_set_reserve_interned(do_object obj, const char* interned_key, size_t size);
+
+/**
+ * @brief Get writable own property using pre-interned key (see do_get_mut)
+ * @param obj Object to search (must not be NULL)
+ * @param interned_key Pre-interned key (must be interned)
+ * @return Pointer to the value, or NULL if not an own property
+ */
+DO_DEF void* do_get_mut_interned(do_object obj, const char* interned_key);
+
 /**
  * @brief Check property existence using pre-interned key
  * @param obj Object to search (must not be NULL)
@@ -341,109 +834,421 @@ DO_DEF int do_delete_interned(do_object obj, const char* interned_key);
 // No interning - fall back to regular functions
 #define do_get_interned(obj, key) do_get(obj, key)
 #define do_set_interned(obj, key, data, size) do_set(obj, key, data, size)
+#define do_set_reserve_interned(obj, key, size) do_set_reserve(obj, key, size)
+#define do_get_mut_interned(obj, key) do_get_mut(obj, key)
 #define do_has_interned(obj, key) do_has(obj, key)
 #define do_delete_interned(obj, key) do_delete(obj, key)
 #endif
 
 /* =============================================================================
- * ENHANCED TYPE INFERENCE SYSTEM (like dynamic_array.h)
+ * TYPED VALUE API
  * ============================================================================= */
 
-/* Detect C23/C++11 auto support (preferred) or typeof fallback */
-#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 202311L && !defined(__STDC_NO_TYPEOF__)
-    #define DO_TYPEOF(x) typeof(x)     /* the C23 typeof keyword */
-    #define DO_HAS_TYPEOF 1
-#elif defined(__cplusplus) && __cplusplus >= 201103L
-    #define DO_TYPEOF(x) decltype(x)   /* the C++ decltype keyword */
-    #define DO_HAS_TYPEOF 1
-#elif (defined(__GNUC__) && __GNUC__ >= 4) || defined(__clang__)
-    #define DO_TYPEOF(x) typeof(x)
-    #define DO_HAS_TYPEOF 1
-#else
-    #define DO_HAS_TYPEOF 0
-#endif
+#if DO_TAGGED_VALUES
 
-#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 202311L
-    #define DO_AUTO auto   /* the C23 auto keyword */
-    #define DO_HAS_AUTO 1
-#elif defined(__cplusplus) && __cplusplus >= 201103L
-    #define DO_AUTO auto   /* the C++ auto keyword */
-    #define DO_HAS_AUTO 1
-#elif (defined(__GNUC__) && __GNUC__ >= 4) || defined(__clang__)
-    #define DO_AUTO __auto_type
-    #define DO_HAS_AUTO 1
-#else
-    #define DO_HAS_AUTO 0
-#endif
+/**
+ * @brief Store a typed value (DO_TYPE_I64, DO_TYPE_F64, DO_TYPE_PTR)
+ * @param obj Object to modify (must not be NULL)
+ * @param interned_key Pre-interned key (must be interned)
+ * @param value Value stored inline in the property, tagged with its type
+ * @return DO_SUCCESS, DO_ERROR_FROZEN, or DO_ERROR_MEMORY
+ * @note Typed values never reach the object's release_fn
+ */
+DO_DEF int do_set_i64(do_object obj, const char* interned_key, int64_t value);
+DO_DEF int do_set_f64(do_object obj, const char* interned_key, double value);
+DO_DEF int do_set_ptr(do_object obj, const char* interned_key, void* value);
 
-#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
-    #define DO_GENERIC(x, ...) _Generic((x), __VA_ARGS__)
-    #define DO_HAS_GENERIC 1
-#else
-    #define DO_HAS_GENERIC 0
-#endif
+/**
+ * @brief Store an object reference (DO_TYPE_OBJ)
+ * @param obj Object to modify (must not be NULL)
+ * @param interned_key Pre-interned key (must be interned)
+ * @param value Object to reference, retained until the property is
+ *        overwritten or deleted or obj is destroyed (may be NULL)
+ * @return DO_SUCCESS, DO_ERROR_FROZEN, or DO_ERROR_MEMORY
+ * @note The cycle collector sees these references without a trace_fn.
+ *       In arena objects the arena holds one reference per distinct heap
+ *       object stored, dropped when the arena is reset or destroyed rather
+ *       than on overwrite or delete.
+ */
+DO_DEF int do_set_obj(do_object obj, const char* interned_key, do_object value);
+
+/**
+ * @brief Read a typed value (searches prototype chain)
+ * @param obj Object to search (must not be NULL)
+ * @param interned_key Pre-interned key (must be interned)
+ * @param value Receives the value (must not be NULL)
+ * @return 1 if found with that type, 0 otherwise (value untouched)
+ */
+DO_DEF int do_get_i64(do_object obj, const char* interned_key, int64_t* value);
+DO_DEF int do_get_f64(do_object obj, const char* interned_key, double* value);
+
+/**
+ * @brief Read a DO_TYPE_PTR or DO_TYPE_OBJ value (searches prototype chain)
+ * @return The value, or NULL if missing or of another type
+ * @note do_get_obj returns a borrowed reference
+ */
+DO_DEF void* do_get_ptr(do_object obj, const char* interned_key);
+DO_DEF do_object do_get_obj(do_object obj, const char* interned_key);
+
+/**
+ * @brief Type of a property value (searches prototype chain)
+ * @param obj Object to search (must not be NULL)
+ * @param interned_key Pre-interned key (must be interned)
+ * @return DO_TYPE_* of the value, DO_TYPE_NONE if there is no such property
+ */
+DO_DEF int do_get_type(do_object obj, const char* interned_key);
 
-#if DO_HAS_AUTO
-    #define DO_SUPPORT_TYPE_INFERENCE 1
-    #define DO_MAKE_VAR_WITH_INFERRED_TYPE(name, initializer) DO_AUTO (name) = (initializer);
-#elif DO_HAS_TYPEOF
-    #define DO_SUPPORT_TYPE_INFERENCE 1
-    #define DO_MAKE_VAR_WITH_INFERRED_TYPE(name, initializer) DO_TYPEOF(initializer) (name) = (initializer);
-#else
-    #define DO_SUPPORT_TYPE_INFERENCE 0
 #endif
 
 /* =============================================================================
- * TYPE-SAFE CONVENIENCE MACROS
+ * STATIC KEY TABLES
  * ============================================================================= */
 
-/* Enhanced property setter with inferred type support */
-#if DO_SUPPORT_TYPE_INFERENCE
-    #define DO_SET_INFERRED(obj, key, val) do { DO_MAKE_VAR_WITH_INFERRED_TYPE(_temp, val); do_set(obj, key, (void*)&_temp, sizeof(_temp)); } while(0)
-    #if DO_STRING_INTERNING
-        #define DO_SET_INTERNED_INFERRED(obj, key, val) do { DO_MAKE_VAR_WITH_INFERRED_TYPE(_temp, val); do_set_interned(obj, key, (void*)&_temp, sizeof(_temp)); } while(0)
-    #endif
-#endif
+/**
+ * @brief One entry of a static key table (see DO_DECLARE_KEYS)
+ */
+typedef struct {
+    const char* name;               // Key text
+    const char** key;               // Receives the interned pointer
+} do_key_entry_t;
 
-#if DO_HAS_TYPEOF
+/**
+ * @brief Declare a table of keys that are interned once, up front
+ * @param table Name of the generated entry array
+ * @param LIST X-macro listing the keys, e.g.
+ *        `#define APP_KEYS(X) X(length) X(push) X(pop)`
+ * @note Generates a file-scope `static const char*` per key, readable through
+ *       DO_KEY(name), plus the entry array passed to DO_REGISTER_KEYS. Use it
+ *       at file scope; each translation unit registers its own table.
+ * @note Keys must be valid C identifiers, since they name the variables
+ */
+#define DO_DECLARE_KEYS(table, LIST) \
+    LIST(DO_KEY_DECLARE_) \
+    static const do_key_entry_t table[] = { LIST(DO_KEY_ENTRY_) }
+
+#define DO_KEY_DECLARE_(name) static const char* do_key_##name;
+#define DO_KEY_ENTRY_(name) { #name, &do_key_##name },
 
 /**
- * @brief Type-safe property setter (automatic size calculation)
- * @param obj Object to modify
- * @param key Property key  
- * @param value Value to store (type inferred)
- * @note Automatically infers type using typeof or auto
+ * @brief Interned pointer for a key declared with DO_DECLARE_KEYS
+ * @note NULL until the table is registered, so a missed registration trips
+ *       the key assertions in the property functions instead of missing
+ *       silently
  */
-#if DO_SUPPORT_TYPE_INFERENCE
-#define DO_SET(obj, key, value) \
-    do { \
-        DO_MAKE_VAR_WITH_INFERRED_TYPE(_temp, value); \
-        do_set(obj, key, &_temp, sizeof(_temp)); \
-    } while(0)
-#else
-#define DO_SET(obj, key, value) \
-    do { \
-        DO_TYPEOF(value) _temp = (value); \
-        do_set(obj, key, &_temp, sizeof(_temp)); \
-    } while(0)
-#endif
+#define DO_KEY(name) do_key_##name
 
 /**
- * @brief Type-safe property getter
- * @param obj Object to search
- * @param key Property key
- * @param type Expected data type
- * @return Value of specified type (undefined if property doesn't exist)
+ * @brief Intern every key of a table declared with DO_DECLARE_KEYS
  */
-#define DO_GET(obj, key, type) \
-    (*(type*)do_get(obj, key))
+#define DO_REGISTER_KEYS(table) \
+    do_register_keys(table, sizeof(table) / sizeof((table)[0]))
 
-// Interned key versions (if interning enabled)
-#if DO_STRING_INTERNING
 /**
- * @brief Type-safe property setter with pre-interned key
- * @param obj Object to modify
- * @param key Pre-interned property key
+ * @brief Intern a batch of keys and store each interned pointer
+ * @param entries Keys to intern (must not be NULL if count > 0)
+ * @param count Number of entries
+ * @return DO_SUCCESS or DO_ERROR_MEMORY (keys interned so far stay valid)
+ * @note Call again after do_string_intern_cleanup, which invalidates the
+ *       stored pointers
+ * @note With DO_INTERN_CONCURRENT, safe to call from any thread, but the
+ *       stored pointers are plain variables - register before handing the
+ *       keys to other threads
+ * @note Keys always go into the global table, even with a DO_INTERN_CONTEXT
+ *       context bound
+ */
+DO_DEF int do_register_keys(const do_key_entry_t* entries, size_t count);
+
+/* =============================================================================
+ * INTERN CONTEXT API
+ * ============================================================================= */
+
+#if DO_INTERN_CONTEXT
+
+typedef struct do_context_t* do_context;
+
+/**
+ * @brief Counters of one intern context, filled in by do_context_stats
+ */
+typedef struct {
+    size_t keys;                    // Strings in the context's table
+    size_t key_bytes;               // Bytes held by those strings
+    size_t keys_reclaimed;          // Strings freed by do_context_sweep
+    size_t sweeps;                  // do_context_sweep calls
+} do_context_stats_t;
+
+/**
+ * @brief Create an intern context (e.g. one per tenant)
+ * @param allocator Hooks for the context's strings and for objects created
+ *        while it is bound, NULL for the defaults (must outlive the context)
+ * @return New context, or NULL on allocation failure
+ * @note Strings interned on a thread with the context bound (including the
+ *       keys of do_get, do_set and friends) go into the context's own table,
+ *       unless the global table already holds them - global keys, such as
+ *       DO_REGISTER_KEYS tables, are shared by every context. Text the
+ *       context already holds keeps resolving to its own copy while bound,
+ *       even after the same text is interned globally, so register global
+ *       keys before binding a context that may use the same text.
+ */
+DO_DEF do_context do_context_create(const do_allocator_t* allocator);
+
+/**
+ * @brief Destroy a context and free its strings
+ * @param ctx Pointer to the context (set to NULL; NULL context is a no-op)
+ * @warning Objects using the context's keys must already be destroyed
+ */
+DO_DEF void do_context_destroy(do_context* ctx);
+
+/**
+ * @brief Bind a context to the calling thread
+ * @param ctx Context used from now on, NULL for the global table only
+ * @return The previously bound context (NULL if none)
+ * @note While bound, the context's allocator applies to new objects unless
+ *       do_set_allocator installed one on this thread
+ */
+DO_DEF do_context do_context_bind(do_context ctx);
+
+/**
+ * @brief Free the context's strings that no longer name a property
+ * @param ctx Context to sweep (must not be NULL)
+ * @return Number of strings reclaimed
+ * @note Keys are counted by the shapes and property tables that store
+ *       them, so live objects are never visited and other threads keep
+ *       running. A string nothing stores is only reclaimed once a whole
+ *       sweep interval passes without it being interned again: pointers
+ *       returned by do_string_intern stay valid until the second sweep
+ *       after the call.
+ * @note Lookups read the context without its lock inside short per-thread
+ *       read sections, so reclaimed strings and superseded tables are freed
+ *       by a later sweep once every lookup that could still see them has
+ *       finished, or by do_context_destroy. Sweeps never wait for readers.
+ */
+DO_DEF size_t do_context_sweep(do_context ctx);
+
+/**
+ * @brief Read the counters of a context
+ * @param ctx Context to inspect (must not be NULL)
+ * @param stats Receives the counters (must not be NULL)
+ */
+DO_DEF void do_context_stats(do_context ctx, do_context_stats_t* stats);
+
+#endif
+
+/* =============================================================================
+ * INLINE CACHE API
+ * ============================================================================= */
+
+#if DO_STRING_INTERNING
+
+/**
+ * @brief Caller-owned inline cache for one property access site
+ * 
+ * Own-property hits are validated by the receiver's shape id alone. For
+ * inherited properties the cache also remembers the receiver's prototype
+ * and the holder found along the chain; those entries stay valid until the
+ * global prototype epoch changes (a key added to, deleted from or released
+ * with an object used as a prototype, or do_set_prototype on one). A hit is
+ * a few compares regardless of chain depth. Shape ids are never reused, so
+ * a cache can never validate against a freed layout. Initialize with
+ * DO_IC_INIT; no cleanup is required.
+ */
+typedef struct {
+    const char* key;          // Key the cache was filled for
+    uint64_t shape_id;        // Receiver shape at the last fill
+    do_object start;          // Receiver's prototype (inherited entries only)
+    do_object holder;         // Object holding the property (NULL = receiver)
+    uint64_t epoch;           // Prototype epoch an inherited entry is valid for
+    int slot;                 // Slot index in the holder, -1 if it is hashed
+    unsigned long hits;       // Lookups answered from the cache
+    unsigned long misses;     // Lookups that needed the full path
+} do_ic_t;
+
+#define DO_IC_INIT {0}
+
+/**
+ * @brief Get property through an inline cache (searches prototype chain)
+ * @param obj Object to search (must not be NULL)
+ * @param interned_key Pre-interned key (must be interned)
+ * @param ic Cache owned by the access site (must not be NULL)
+ * @return Pointer to property data, or NULL if not found
+ * @note A site with a high miss count is polymorphic or megamorphic
+ */
+DO_DEF void* do_get_cached(do_object obj, const char* interned_key, do_ic_t* ic);
+
+/**
+ * @brief Set own property through an inline cache
+ * @param obj Object to modify (must not be NULL)
+ * @param interned_key Pre-interned key (must be interned)
+ * @param data Data to store (must not be NULL)
+ * @param size Size of data in bytes
+ * @param ic Cache owned by the access site (must not be NULL)
+ * @return DO_SUCCESS or error code
+ * @note Hits update an existing slot in place of the key lookup; adding a
+ *       new property always takes the do_set_interned path
+ */
+DO_DEF int do_set_cached(do_object obj, const char* interned_key, const void* data, size_t size, do_ic_t* ic);
+
+#endif
+
+/* =============================================================================
+ * BATCH API
+ * ============================================================================= */
+
+/**
+ * @brief Make room for an expected number of own properties
+ * @param obj Object to modify (must not be NULL)
+ * @param count Own properties the object is expected to end up with
+ * @return DO_SUCCESS, DO_ERROR_FROZEN, or DO_ERROR_MEMORY
+ * @note An object expected to pass DO_HASH_THRESHOLD moves to a property
+ *       table sized for count right away, so filling it never migrates
+ *       slots or rebuilds the table. Smaller counts reserve slot storage.
+ *       Reserving never shrinks anything.
+ */
+DO_DEF int do_reserve_properties(do_object obj, int count);
+
+#if DO_STRING_INTERNING
+
+/**
+ * @brief Set several properties in one call
+ * @param obj Object to modify (must not be NULL)
+ * @param interned_keys Pre-interned keys, expected to be distinct
+ * @param values values[i] is the data stored under interned_keys[i]
+ * @param sizes sizes[i] is the size of values[i] in bytes
+ * @param count Number of properties
+ * @return DO_SUCCESS, DO_ERROR_FROZEN (nothing set), or DO_ERROR_MEMORY
+ *         (properties before the failing one remain set, except on
+ *         concurrent objects)
+ * @note Storage is sized once for the whole batch, and an object the batch
+ *       would take past the hash threshold switches to hash storage before
+ *       the first insert instead of part-way through
+ * @note An object from do_create_concurrent applies the batch all or
+ *       nothing: readers see every property in one new version, and on
+ *       failure no version is published
+ */
+DO_DEF int do_set_many(do_object obj, const char* const* interned_keys, const void* const* values,
+                       const size_t* sizes, int count);
+
+/**
+ * @brief Get several properties in one call (searches prototype chain)
+ * @param obj Object to search (must not be NULL)
+ * @param interned_keys Pre-interned keys
+ * @param values Receives count pointers (NULL for keys not found), valid
+ *        under the same rules as do_get
+ * @param count Number of keys
+ * @return Number of keys found
+ */
+DO_DEF int do_get_many(do_object obj, const char* const* interned_keys, void** values, int count);
+
+/**
+ * @brief Delete several own properties in one call
+ * @param obj Object to modify (must not be NULL)
+ * @param interned_keys Pre-interned keys
+ * @param count Number of keys
+ * @return Number of properties deleted
+ * @note The object's layout is rebuilt once for the whole batch
+ */
+DO_DEF int do_delete_many(do_object obj, const char* const* interned_keys, int count);
+
+#endif
+
+/* =============================================================================
+ * ENHANCED TYPE INFERENCE SYSTEM (like dynamic_array.h)
+ * ============================================================================= */
+
+/* Detect C23/C++11 auto support (preferred) or typeof fallback */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 202311L && !defined(__STDC_NO_TYPEOF__)
+    #define DO_TYPEOF(x) typeof(x)     /* the C23 typeof keyword */
+    #define DO_HAS_TYPEOF 1
+#elif defined(__cplusplus) && __cplusplus >= 201103L
+    #define DO_TYPEOF(x) decltype(x)   /* the C++ decltype keyword */
+    #define DO_HAS_TYPEOF 1
+#elif (defined(__GNUC__) && __GNUC__ >= 4) || defined(__clang__)
+    #define DO_TYPEOF(x) typeof(x)
+    #define DO_HAS_TYPEOF 1
+#else
+    #define DO_HAS_TYPEOF 0
+#endif
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 202311L
+    #define DO_AUTO auto   /* the C23 auto keyword */
+    #define DO_HAS_AUTO 1
+#elif defined(__cplusplus) && __cplusplus >= 201103L
+    #define DO_AUTO auto   /* the C++ auto keyword */
+    #define DO_HAS_AUTO 1
+#elif (defined(__GNUC__) && __GNUC__ >= 4) || defined(__clang__)
+    #define DO_AUTO __auto_type
+    #define DO_HAS_AUTO 1
+#else
+    #define DO_HAS_AUTO 0
+#endif
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+    #define DO_GENERIC(x, ...) _Generic((x), __VA_ARGS__)
+    #define DO_HAS_GENERIC 1
+#else
+    #define DO_HAS_GENERIC 0
+#endif
+
+#if DO_HAS_AUTO
+    #define DO_SUPPORT_TYPE_INFERENCE 1
+    #define DO_MAKE_VAR_WITH_INFERRED_TYPE(name, initializer) DO_AUTO (name) = (initializer);
+#elif DO_HAS_TYPEOF
+    #define DO_SUPPORT_TYPE_INFERENCE 1
+    #define DO_MAKE_VAR_WITH_INFERRED_TYPE(name, initializer) DO_TYPEOF(initializer) (name) = (initializer);
+#else
+    #define DO_SUPPORT_TYPE_INFERENCE 0
+#endif
+
+/* =============================================================================
+ * TYPE-SAFE CONVENIENCE MACROS
+ * ============================================================================= */
+
+/* Enhanced property setter with inferred type support */
+#if DO_SUPPORT_TYPE_INFERENCE
+    #define DO_SET_INFERRED(obj, key, val) do { DO_MAKE_VAR_WITH_INFERRED_TYPE(_temp, val); do_set(obj, key, (void*)&_temp, sizeof(_temp)); } while(0)
+    #if DO_STRING_INTERNING
+        #define DO_SET_INTERNED_INFERRED(obj, key, val) do { DO_MAKE_VAR_WITH_INFERRED_TYPE(_temp, val); do_set_interned(obj, key, (void*)&_temp, sizeof(_temp)); } while(0)
+    #endif
+#endif
+
+#if DO_HAS_TYPEOF
+
+/**
+ * @brief Type-safe property setter (automatic size calculation)
+ * @param obj Object to modify
+ * @param key Property key  
+ * @param value Value to store (type inferred)
+ * @note Automatically infers type using typeof or auto
+ */
+#if DO_SUPPORT_TYPE_INFERENCE
+#define DO_SET(obj, key, value) \
+    do { \
+        DO_MAKE_VAR_WITH_INFERRED_TYPE(_temp, value); \
+        do_set(obj, key, &_temp, sizeof(_temp)); \
+    } while(0)
+#else
+#define DO_SET(obj, key, value) \
+    do { \
+        DO_TYPEOF(value) _temp = (value); \
+        do_set(obj, key, &_temp, sizeof(_temp)); \
+    } while(0)
+#endif
+
+/**
+ * @brief Type-safe property getter
+ * @param obj Object to search
+ * @param key Property key
+ * @param type Expected data type
+ * @return Value of specified type (undefined if property doesn't exist)
+ */
+#define DO_GET(obj, key, type) \
+    (*(type*)do_get(obj, key))
+
+// Interned key versions (if interning enabled)
+#if DO_STRING_INTERNING
+/**
+ * @brief Type-safe property setter with pre-interned key
+ * @param obj Object to modify
+ * @param key Pre-interned property key
  * @param value Value to store (type inferred)
  * @note Automatically infers type using typeof or auto
  */
@@ -577,558 +1382,5006 @@ DO_DEF int do_delete_interned(do_object obj, const char* interned_key);
 #define DO_CREATE_SIMPLE() do_create(NULL)
 
 /* =============================================================================
- * UTILITY AND INTROSPECTION API  
+ * MEMORY POOL API
  * ============================================================================= */
 
+#if DO_POOL_ALLOCATOR
+
 /**
- * @brief Get array of own property keys
- * @param obj Object to introspect (must not be NULL)
- * @return stb_ds array of const char* keys (caller must call arrfree)
+ * @brief Return the calling thread's cached pool blocks to DO_FREE
+ * @note Call before a thread exits, or after a burst of short-lived objects,
+ *       to give memory back; the pool refills itself on demand
  */
-DO_DEF const char** do_get_own_keys(do_object obj);
+DO_DEF void do_pool_trim(void);
+
+#else
+#define do_pool_trim() ((void)0)
+#endif
+
+/* =============================================================================
+ * MEMORY ACCOUNTING API
+ * ============================================================================= */
+
+// do_memory_usage flags
+#define DO_MEMORY_OWN 0          // The object alone
+#define DO_MEMORY_PROTOTYPES 1   // The object and every prototype in its chain
 
 /**
- * @brief Get array of all property keys (including prototype chain)
- * @param obj Object to introspect (must not be NULL) 
- * @return stb_ds array of const char* keys (caller must call arrfree)
+ * @brief Bytes held by an object
+ * @param obj Object to measure
+ * @param flags DO_MEMORY_OWN or DO_MEMORY_PROTOTYPES
+ * @return Header, slot array or property table, out-of-line value buffers
+ *         and copy-on-write record, as requested from the allocator
+ * @note Shapes are shared between objects and not included. Storage
+ *       shared by do_clone is counted in full for every sharer.
  */
-DO_DEF const char** do_get_all_keys(do_object obj);
+DO_DEF size_t do_memory_usage(do_object obj, int flags);
 
 /**
- * @brief Get number of own properties  
- * @param obj Object to query (must not be NULL)
- * @return Number of own properties
+ * @brief Shrink an object's storage to fit its current properties
+ * @param obj Object to compact (must not be NULL)
+ * @return DO_SUCCESS, DO_ERROR_FROZEN, or DO_ERROR_MEMORY (object unchanged)
+ * @note Hashed objects with at most DO_HASH_THRESHOLD properties move back
+ *       to shape slots; larger ones get a rebuilt table without holes.
+ *       Deletes already shrink storage with some slack, this removes it.
+ *       Storage shared by do_clone and arena objects are left as they are.
  */
-DO_DEF int do_property_count(do_object obj);
+DO_DEF int do_compact(do_object obj);
 
 /**
- * @brief Iterate over own properties
- * @param obj Object to iterate (must not be NULL)
- * @param callback Function called for each property
- * @param context User data passed to callback
+ * @brief Install the allocator used by objects the calling thread creates
+ * @param allocator Hooks to use from now on, NULL restores the default
+ * @return The previously installed allocator (NULL for the default)
+ * @note Objects remember their allocator, so it must outlive them.
+ *       Clones use their source's allocator; arena objects ignore it.
  */
-DO_DEF void do_foreach_property(do_object obj, 
-                                void (*callback)(const char* key, void* data, size_t size, void* context),
-                                void* context);
+DO_DEF const do_allocator_t* do_set_allocator(const do_allocator_t* allocator);
 
 /* =============================================================================
- * IMPLEMENTATION SECTION
+ * STATISTICS API
  * ============================================================================= */
 
-#ifdef DO_IMPLEMENTATION
+/**
+ * @brief Library counters, filled in by do_stats_snapshot
+ * 
+ * Event counters run from program start or the last do_stats_reset. The
+ * gauges at the end describe the current state and are never reset.
+ * Objects means heap objects (arena objects are not counted); bytes are
+ * those requested through the library allocator for object headers,
+ * shapes and property storage, excluding arena chunks and interned strings.
+ */
+typedef struct {
+    // Reads through do_get/do_get_interned
+    uint64_t gets;                  // Calls
+    uint64_t get_own_hits;          // Found on the object itself
+    uint64_t get_proto_hits;        // Found on a prototype
+    uint64_t get_misses;            // Found nowhere
+    uint64_t chain_walks[DO_STATS_DEPTH_BUCKETS];  // [i]: walks that visited i + 1 prototypes
+    uint64_t proto_cache_hits;      // DO_PROTO_CACHE_SIZE cache
+    uint64_t proto_cache_misses;
+    uint64_t ic_hits;               // do_get_cached/do_set_cached
+    uint64_t ic_misses;
+    
+    // Writes and layout
+    uint64_t sets;                  // do_set*, do_set_reserve* and do_set_many writes
+    uint64_t hash_upgrades;         // Objects moved from shape slots to a property table
+    uint64_t hash_downgrades;       // Objects moved back from a property table to shape slots
+    uint64_t shapes_created;
+    
+    // Memory
+    uint64_t objects_created;
+    uint64_t objects_destroyed;
+    uint64_t bytes_allocated;
+    uint64_t bytes_freed;
+    
+    // String interning
+    uint64_t intern_lookups;        // do_string_intern/do_string_find_interned calls
+    uint64_t intern_inserts;        // New strings added
+    uint64_t intern_probes;         // Slots probed past the first, summed over lookups
+    
+    // Gauges
+    uint64_t live_objects;
+    uint64_t live_bytes;
+    uint64_t intern_strings;        // Strings in the intern table
+} do_stats_t;
 
-#include <string.h>
-#include <stdlib.h>
+#if DO_STATS
+
+/**
+ * @brief Sum the counters of every thread
+ * @param stats Receives the totals (must not be NULL)
+ * @note Counters are relaxed: a snapshot taken while other threads run
+ *       may miss their latest events, but never sees torn values
+ */
+DO_DEF void do_stats_snapshot(do_stats_t* stats);
+
+/**
+ * @brief Restart the event counters from zero (gauges are kept)
+ */
+DO_DEF void do_stats_reset(void);
+
+#else
+#define do_stats_snapshot(stats) ((void)memset((stats), 0, sizeof(do_stats_t)))
+#define do_stats_reset() ((void)0)
+#endif
 
 /* =============================================================================
- * STRING INTERNING IMPLEMENTATION
+ * ARENA API
  * ============================================================================= */
 
-#if DO_STRING_INTERNING
+/**
+ * @brief Create an arena for objects that share one lifetime
+ * @param chunk_size Bytes per allocation chunk, 0 for DO_ARENA_CHUNK_SIZE
+ * @return New arena, or NULL on allocation failure
+ * @note An arena and its objects must be used from one thread at a time
+ */
+DO_DEF do_arena do_arena_create(size_t chunk_size);
 
-typedef struct {
-    char* str;
-    size_t hash;
-} intern_entry_t;
+/**
+ * @brief Create an object whose header and property data live in an arena
+ * @param arena Owning arena (must not be NULL)
+ * @param prototype Prototype object (can be NULL)
+ * @return New object, or NULL on allocation failure
+ * @note do_retain/do_release are no-ops on arena objects and there is no
+ *       release_fn: the object lives until the arena is reset or destroyed
+ * @note A heap prototype or do_set_obj value is retained once by the
+ *       arena, not by each object; heap objects must not keep references
+ *       to arena objects (including as prototypes) past the arena's reset
+ */
+DO_DEF do_object do_arena_create_object(do_arena arena, do_object prototype);
 
-// Simple string interning using stb_ds array
-static intern_entry_t* g_intern_table = NULL;
+/**
+ * @brief Drop every object in the arena at once, keeping one chunk for reuse
+ * @param arena Arena to reset (must not be NULL)
+ * @note Cost depends on the number of chunks, distinct shapes and heap
+ *       objects held - not on the number of objects or properties
+ */
+DO_DEF void do_arena_reset(do_arena arena);
 
-// Simple hash function (djb2)
-static size_t do_hash_string(const char* str) {
-    size_t hash = 5381;
-    int c;
-    while ((c = *str++)) {
-        hash = ((hash << 5) + hash) + c;
-    }
-    return hash;
-}
+/**
+ * @brief Drop every object in the arena and free the arena itself
+ * @param arena Pointer to arena (will be set to NULL)
+ */
+DO_DEF void do_arena_destroy(do_arena* arena);
 
-DO_DEF const char* do_string_intern(const char* str) {
-    DO_ASSERT(str != NULL);
-    
-    size_t hash = do_hash_string(str);
-    int len = arrlen(g_intern_table);
-    
-    // Linear search (could optimize with hash table later)
-    for (int i = 0; i < len; i++) {
-        if (g_intern_table[i].hash == hash && strcmp(g_intern_table[i].str, str) == 0) {
-            return g_intern_table[i].str;
-        }
-    }
-    
-    // Not found - add new entry
-    size_t str_len = strlen(str);
-    char* new_str = (char*)DO_MALLOC(str_len + 1);
-    if (!new_str) return NULL;
-    
-    strcpy(new_str, str);
-    
-    intern_entry_t new_entry = {new_str, hash};
-    arrput(g_intern_table, new_entry);
-    
+/* =============================================================================
+ * CONCURRENT OBJECT API
+ * ============================================================================= */
+
+#if DO_CONCURRENT_OBJECTS
+
+/**
+ * @brief Create an object for many reader threads and occasional writers
+ * @param release_fn Optional function to call on property values when removed (can be NULL)
+ * @return New object with reference count 1, or NULL on allocation failure
+ * @note Readers look properties up in an immutable version without taking
+ *       a lock. Each do_set, do_delete or batch builds a complete new
+ *       version under the object's writer lock and publishes it; the
+ *       version it replaces, with the values it alone held, is freed once
+ *       no read section that could see it is left
+ * @note Supports do_get/do_has/do_has_own (and their interned, cached and
+ *       batch forms), do_set, do_delete, do_set_many, do_delete_many,
+ *       do_get_own_keys, do_foreach_property, do_property_count and, as
+ *       a snapshot root, do_snapshot_write.
+ *       The object has no prototype and cannot be one; it cannot be cloned,
+ *       frozen, iterated with do_iter or used with do_set_reserve,
+ *       do_get_mut or the typed value API
+ * @note Pointers returned by do_get are only valid until the caller's
+ *       do_rcu_read_unlock; lookups outside a read section are an error.
+ *       Separate do_get calls may see different writes; do_get_many reads
+ *       all its keys from one version
+ */
+DO_DEF do_object do_create_concurrent(void (*release_fn)(void*));
+
+/**
+ * @brief Enter a read section of the calling thread
+ * @note Sections nest. Versions that were current at any point during the
+ *       section, and the values in them, stay valid until it ends. Never
+ *       blocks writers; keep sections short so replaced versions are freed
+ *       promptly
+ */
+DO_DEF void do_rcu_read_lock(void);
+
+/**
+ * @brief Leave the read section entered by the matching do_rcu_read_lock
+ */
+DO_DEF void do_rcu_read_unlock(void);
+
+/**
+ * @brief Free replaced versions that no read section can still see
+ * @return Number of versions freed
+ * @note Writers call this after each update; safe from any thread
+ */
+DO_DEF size_t do_rcu_reclaim(void);
+
+/**
+ * @brief Wait for read sections that began before the call, then reclaim
+ * @return Number of versions freed
+ * @note Must not be called inside a read section
+ */
+DO_DEF size_t do_rcu_synchronize(void);
+
+#endif
+
+/* =============================================================================
+ * CYCLE COLLECTOR API
+ * ============================================================================= */
+
+#if DO_CYCLE_COLLECTOR
+
+/**
+ * @brief Let the cycle collector see object references in obj's values
+ * @param obj Object whose properties may hold objects (must not be NULL)
+ * @param trace_fn Reports those references (NULL: values hold none)
+ * @note Pair it with a release_fn that drops the same references
+ */
+DO_DEF void do_set_trace_fn(do_object obj, do_trace_fn trace_fn);
+
+/**
+ * @brief Run a bounded step of cycle collection
+ * @param budget Upper bound on objects visited, SIZE_MAX for a full collection
+ * @return Number of objects freed
+ * @note Objects whose reference count drops without reaching zero are
+ *       buffered as candidates; each step examines candidates until the
+ *       budget is spent. A candidate's reachable graph is always finished
+ *       once started, so a step may overrun by that much. Every release
+ *       that leaves an object with a prototype or traced values alive
+ *       writes to it and to the shared candidate buffer, so the collector
+ *       is single-threaded: it cannot be built with DO_ATOMIC_REFCOUNT.
+ */
+DO_DEF size_t do_collect_cycles(size_t budget);
+
+/**
+ * @brief Number of buffered cycle candidates awaiting do_collect_cycles
+ */
+DO_DEF size_t do_cycle_candidates(void);
+
+#endif
+
+/* =============================================================================
+ * SNAPSHOT API
+ * ============================================================================= */
+
+#if DO_SNAPSHOT
+
+typedef struct do_snapshot_t* do_snapshot;
+
+/**
+ * @brief Save objects, their prototype chains and own properties to a file
+ * @param path File to create or overwrite (must not be NULL)
+ * @param roots Objects to save (must not be NULL if count > 0; no entry may be NULL)
+ * @param count Number of roots
+ * @return DO_SUCCESS, DO_ERROR_MEMORY or DO_ERROR_IO
+ * @note Values are saved as raw bytes, so values holding pointers (object
+ *       references included) do not survive. The file is position
+ *       independent - keys are string indices, links are object indices -
+ *       and has the byte order of the writing host. DO_TYPE_I64 and
+ *       DO_TYPE_F64 tags are kept; pointer and object values load untyped
+ * @note A concurrent root (do_create_concurrent) is saved as its current
+ *       version and loads as an ordinary frozen object
+ */
+DO_DEF int do_snapshot_write(const char* path, const do_object* roots, int count);
+
+/**
+ * @brief Map a snapshot file and rebuild its objects, frozen
+ * @param path File written by do_snapshot_write (must not be NULL)
+ * @return Snapshot holding the objects, or NULL if the file cannot be read,
+ *         is malformed or memory runs out
+ * @note Each key is interned once and each object is built in one pass,
+ *       with storage sized for all its properties, in an arena owned by the
+ *       snapshot. The objects are arena objects and frozen: immutable,
+ *       with no reference counting, safe to read from any thread. They live
+ *       until do_snapshot_destroy; heap objects inheriting from them must
+ *       be destroyed first (with DO_DEFERRED_RELEASE, drained)
+ * @note The file stays mapped read-only until do_snapshot_destroy (read
+ *       into memory where mmap is unavailable). Values larger than
+ *       DO_INLINE_SIZE are not copied: do_get returns a pointer into the
+ *       mapping, whose pages are loaded on first touch and shared by every
+ *       process mapping the same file
+ */
+DO_DEF do_snapshot do_snapshot_map(const char* path);
+
+/**
+ * @brief Number of roots saved in a snapshot
+ */
+DO_DEF int do_snapshot_root_count(do_snapshot snapshot);
+
+/**
+ * @brief Get a root, in the order passed to do_snapshot_write
+ * @param snapshot Snapshot to query (must not be NULL)
+ * @param index Root index, 0 to do_snapshot_root_count() - 1
+ * @return The rebuilt object
+ */
+DO_DEF do_object do_snapshot_root(do_snapshot snapshot, int index);
+
+/**
+ * @brief Free a snapshot and every object in it
+ * @param snapshot Pointer to snapshot (will be set to NULL)
+ */
+DO_DEF void do_snapshot_destroy(do_snapshot* snapshot);
+
+#endif
+
+/* =============================================================================
+ * UTILITY AND INTROSPECTION API  
+ * ============================================================================= */
+
+/**
+ * @brief Get array of own property keys
+ * @param obj Object to introspect (must not be NULL)
+ * @return stb_ds array of const char* keys (caller must call arrfree)
+ */
+DO_DEF const char** do_get_own_keys(do_object obj);
+
+/**
+ * @brief Get array of all property keys (including prototype chain)
+ * @param obj Object to introspect (must not be NULL) 
+ * @return stb_ds array of const char* keys (caller must call arrfree)
+ * @note Same order as do_iter_t with DO_ITER_INHERITED
+ */
+DO_DEF const char** do_get_all_keys(do_object obj);
+
+#define DO_ITER_OWN 0        // Own properties only
+#define DO_ITER_INHERITED 1  // Then each prototype's, skipping shadowed keys
+
+/**
+ * @brief Allocation-free property cursor
+ * 
+ * Yields own properties in insertion order, then (with DO_ITER_INHERITED)
+ * those of each prototype in turn. An inherited key is skipped when a
+ * nearer object in the chain has it, so every key appears once with the
+ * value do_get would return. Nothing in the chain may be modified while
+ * a cursor is in use.
+ * 
+ * @code
+ * do_iter_t it;
+ * do_iter_init(&it, obj, DO_ITER_INHERITED);
+ * while (do_iter_next(&it)) use(it.key, it.value, it.size);
+ * @endcode
+ */
+typedef struct {
+    const char* key;          // Current key (interned)
+    void* value;              // Current value, valid under the same rules as do_get
+    size_t size;              // Current value size in bytes
+    do_object holder;         // Object the current property belongs to
+    do_object start;          // Object iteration started from
+    int flags;                // DO_ITER_* mode
+    uint32_t index;           // Next slot or table entry in holder
+} do_iter_t;
+
+/**
+ * @brief Start iterating over an object's properties
+ * @param iter Cursor to initialize (must not be NULL)
+ * @param obj Object to iterate (must not be NULL)
+ * @param flags DO_ITER_OWN or DO_ITER_INHERITED
+ */
+DO_DEF void do_iter_init(do_iter_t* iter, do_object obj, int flags);
+
+/**
+ * @brief Advance to the next property
+ * @param iter Initialized cursor (must not be NULL)
+ * @return 1 with key/value/size/holder set, or 0 when iteration is done
+ */
+DO_DEF int do_iter_next(do_iter_t* iter);
+
+/**
+ * @brief Get number of own properties  
+ * @param obj Object to query (must not be NULL)
+ * @return Number of own properties
+ */
+DO_DEF int do_property_count(do_object obj);
+
+/**
+ * @brief Iterate over own properties
+ * @param obj Object to iterate (must not be NULL)
+ * @param callback Function called for each property
+ * @param context User data passed to callback
+ */
+DO_DEF void do_foreach_property(do_object obj, 
+                                void (*callback)(const char* key, void* data, size_t size, void* context),
+                                void* context);
+
+/* =============================================================================
+ * IMPLEMENTATION SECTION
+ * ============================================================================= */
+
+#ifdef DO_IMPLEMENTATION
+
+#include <string.h>
+#include <stdlib.h>
+
+#if defined(DO_SIMD_AVX2)
+#include <immintrin.h>
+#elif defined(DO_SIMD_SSE2)
+#include <emmintrin.h>
+#elif defined(DO_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+#if DO_ATOMIC_REFCOUNT || DO_INTERN_CONCURRENT || DO_STATS || DO_INTERN_CONTEXT
+#include <stdatomic.h>
+
+// Test-and-test-and-set spinlock for short internal critical sections
+static void do_spin_lock(atomic_int* lock) {
+    while (atomic_exchange_explicit(lock, 1, memory_order_acquire)) {
+        while (atomic_load_explicit(lock, memory_order_relaxed)) {
+            DO_CPU_RELAX();
+        }
+    }
+}
+
+static void do_spin_unlock(atomic_int* lock) {
+    atomic_store_explicit(lock, 0, memory_order_release);
+}
+#endif
+
+/* =============================================================================
+ * READ SECTION IMPLEMENTATION
+ * ============================================================================= */
+
+#if DO_CONCURRENT_OBJECTS || DO_INTERN_CONTEXT
+
+// Epoch-based reclamation shared by concurrent objects and intern
+// contexts. Every read section publishes the epoch it began in; memory
+// unlinked from shared structures is stamped with a fresh epoch by
+// rcu_advance and freed once rcu_oldest_epoch reaches the stamp, i.e.
+// once every section that could still see it has ended.
+
+typedef struct do_rcu_reader_t {
+    _Atomic uint64_t epoch;         // Epoch its read section began in, 0 outside one
+    struct do_rcu_reader_t* next;
+    char padding[48];               // Keeps other readers' epochs off this cache line
+} do_rcu_reader_t;
+
+// A reader record is pushed onto a global list on its thread's first read
+// section and never freed, like statistics blocks. Threads that could not
+// get one count in g_rcu_anonymous, which holds back every reclamation.
+static _Atomic(do_rcu_reader_t*) g_rcu_readers;
+static DO_THREAD_LOCAL do_rcu_reader_t* g_rcu_reader;
+static DO_THREAD_LOCAL int g_rcu_depth;
+static atomic_int g_rcu_anonymous;
+static _Atomic uint64_t g_rcu_epoch = 1;
+
+static do_rcu_reader_t* rcu_register(void) {
+    do_rcu_reader_t* reader = (do_rcu_reader_t*)DO_MALLOC(sizeof(do_rcu_reader_t));
+    if (!reader) return NULL;
+    atomic_init(&reader->epoch, 0);
+    reader->next = atomic_load_explicit(&g_rcu_readers, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&g_rcu_readers, &reader->next, reader,
+                                                  memory_order_release, memory_order_relaxed)) {
+    }
+    g_rcu_reader = reader;
+    return reader;
+}
+
+// Oldest epoch a read section may still be in; memory stamped with it or
+// earlier is unreachable
+static uint64_t rcu_oldest_epoch(void) {
+    uint64_t oldest = atomic_load(&g_rcu_epoch);
+    if (atomic_load(&g_rcu_anonymous) > 0) return 0;
+    for (do_rcu_reader_t* reader = atomic_load_explicit(&g_rcu_readers, memory_order_acquire); reader;
+         reader = reader->next) {
+        uint64_t epoch = atomic_load(&reader->epoch);
+        if (epoch && epoch < oldest) oldest = epoch;
+    }
+    return oldest;
+}
+
+// Stamp for memory that was just unlinked. A section that began at the
+// new stamp or later started after the unlinking, so it cannot see it.
+static uint64_t rcu_advance(void) {
+    return atomic_fetch_add(&g_rcu_epoch, 1) + 1;
+}
+
+static void rcu_enter(void) {
+    if (g_rcu_depth++ > 0) return;
+    do_rcu_reader_t* reader = g_rcu_reader ? g_rcu_reader : rcu_register();
+    if (reader) {
+        atomic_store_explicit(&reader->epoch, atomic_load_explicit(&g_rcu_epoch, memory_order_relaxed),
+                              memory_order_relaxed);
+    } else {
+        atomic_fetch_add_explicit(&g_rcu_anonymous, 1, memory_order_relaxed);
+    }
+    
+    // Either a reclaimer sees the section, or the section sees everything
+    // unlinked before that reclaimer's scan
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+static void rcu_exit(void) {
+    DO_ASSERT(g_rcu_depth > 0);
+    if (--g_rcu_depth > 0) return;
+    if (g_rcu_reader) {
+        atomic_store_explicit(&g_rcu_reader->epoch, 0, memory_order_release);
+    } else {
+        atomic_fetch_sub_explicit(&g_rcu_anonymous, 1, memory_order_release);
+    }
+}
+
+#endif
+
+/* =============================================================================
+ * STATISTICS IMPLEMENTATION
+ * ============================================================================= */
+
+#if DO_STATS
+
+// Each thread counts into its own block with a relaxed load and store (no
+// read-modify-write, no shared cache lines) and do_stats_snapshot sums the
+// blocks. A block is pushed onto a global list on its thread's first event
+// and never freed, so counts of exited threads are kept. Gauges go up and
+// down, possibly in different threads; the modular sum is still exact.
+// do_stats_reset records a baseline to subtract instead of writing to
+// blocks other threads own.
+
+#define DO_STATS_FIELDS (sizeof(do_stats_t) / sizeof(uint64_t))
+#define DO_STATS_FIRST_GAUGE (offsetof(do_stats_t, live_objects) / sizeof(uint64_t))
+
+typedef struct do_stats_block_t {
+    _Atomic uint64_t counters[DO_STATS_FIELDS];
+    struct do_stats_block_t* next;
+} do_stats_block_t;
+
+static _Atomic(do_stats_block_t*) g_stats_blocks;
+static DO_THREAD_LOCAL do_stats_block_t* g_stats_block;
+static uint64_t g_stats_baseline[DO_STATS_FIRST_GAUGE];  // Guarded by g_stats_lock
+static atomic_int g_stats_lock;
+
+static do_stats_block_t* stats_register(void) {
+    do_stats_block_t* block = (do_stats_block_t*)DO_MALLOC(sizeof(do_stats_block_t));
+    if (!block) return NULL;
+    for (size_t i = 0; i < DO_STATS_FIELDS; i++) atomic_init(&block->counters[i], 0);
+    
+    block->next = atomic_load_explicit(&g_stats_blocks, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&g_stats_blocks, &block->next, block,
+                                                  memory_order_release, memory_order_relaxed)) {
+    }
+    g_stats_block = block;
+    return block;
+}
+
+static void stats_add(size_t counter, uint64_t amount) {
+    do_stats_block_t* block = g_stats_block;
+    if (!block && !(block = stats_register())) return;  // Out of memory: drop the event
+    
+    _Atomic uint64_t* value = &block->counters[counter];
+    atomic_store_explicit(value, atomic_load_explicit(value, memory_order_relaxed) + amount,
+                          memory_order_relaxed);
+}
+
+static void stats_sum(uint64_t* totals) {
+    memset(totals, 0, DO_STATS_FIELDS * sizeof(uint64_t));
+    do_stats_block_t* block = atomic_load_explicit(&g_stats_blocks, memory_order_acquire);
+    for (; block; block = block->next) {
+        for (size_t i = 0; i < DO_STATS_FIELDS; i++) {
+            totals[i] += atomic_load_explicit(&block->counters[i], memory_order_relaxed);
+        }
+    }
+}
+
+#define DO_STAT_INDEX(field) (offsetof(do_stats_t, field) / sizeof(uint64_t))
+#define DO_STAT_ADD(field, n) stats_add(DO_STAT_INDEX(field), (uint64_t)(n))
+#define DO_STAT_SUB(field, n) stats_add(DO_STAT_INDEX(field), (uint64_t)0 - (uint64_t)(n))
+#define DO_STAT_WALK(levels) \
+    stats_add(DO_STAT_INDEX(chain_walks) + \
+              ((levels) < DO_STATS_DEPTH_BUCKETS ? (size_t)(levels) : DO_STATS_DEPTH_BUCKETS) - 1, 1)
+
+DO_DEF void do_stats_snapshot(do_stats_t* stats) {
+    DO_ASSERT(stats != NULL);
+    
+    uint64_t totals[DO_STATS_FIELDS];
+    stats_sum(totals);
+    do_spin_lock(&g_stats_lock);
+    for (size_t i = 0; i < DO_STATS_FIRST_GAUGE; i++) totals[i] -= g_stats_baseline[i];
+    do_spin_unlock(&g_stats_lock);
+    memcpy(stats, totals, sizeof(*stats));
+}
+
+DO_DEF void do_stats_reset(void) {
+    uint64_t totals[DO_STATS_FIELDS];
+    stats_sum(totals);
+    do_spin_lock(&g_stats_lock);
+    memcpy(g_stats_baseline, totals, sizeof(g_stats_baseline));
+    do_spin_unlock(&g_stats_lock);
+}
+
+#else
+
+#define DO_STAT_ADD(field, n) ((void)0)
+#define DO_STAT_SUB(field, n) ((void)0)
+#define DO_STAT_WALK(levels) ((void)(levels))
+
+#endif // DO_STATS
+
+/* =============================================================================
+ * STRING INTERNING IMPLEMENTATION
+ * ============================================================================= */
+
+#if DO_STRING_INTERNING
+
+// One pass over a NUL-terminated string for its do_string_hash and length
+static size_t hash_string(const char* str, size_t* length) {
+    size_t hash = DO_STRING_HASH_INIT;
+    const char* end = str;
+    for (; *end; end++) hash = DO_STRING_HASH_STEP(hash, *end);
+    *length = (size_t)(end - str);
+    return hash;
+}
+
+// Scramble djb2 output before masking - similar keys ("key_1", "key_2")
+// otherwise land in adjacent slots and form long linear-probe clusters
+static size_t do_intern_mix(size_t hash) {
+    hash ^= hash >> 16;
+    hash *= (size_t)0x45D9F3B;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+// Every interned string is preceded by a header with its hash and length,
+// so table probes compare those before touching the bytes. Under
+// DO_INTERN_CONTEXT it also names the string's table: global strings live
+// until do_string_intern_cleanup; context strings count the shapes and
+// property tables storing them, and do_context_sweep frees the ones nothing
+// stores that were not interned during the last interval.
+typedef struct {
+#if DO_INTERN_CONTEXT
+    struct do_context_t* context;   // Owning context, NULL for the global table
+    atomic_int refs;                // Shapes and property tables storing the key
+    _Atomic size_t last_sweep;      // Context sweep count when last interned
+#endif
+    size_t hash;                    // do_string_hash of the bytes
+    size_t length;                  // Bytes before the terminating NUL
+} do_key_header_t;
+
+#define key_header(key) ((do_key_header_t*)(void*)((char*)(key) - sizeof(do_key_header_t)))
+
+// Whether interned holds exactly the len bytes at str
+static int interned_equals(const char* interned, const char* str, size_t len) {
+    return key_header(interned)->length == len && memcmp(interned, str, len) == 0;
+}
+
+static void init_key_header(do_key_header_t* header, const char* str, size_t len, size_t hash) {
+    header->hash = hash;
+    header->length = len;
+    char* copy = (char*)(header + 1);
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+}
+
+#if DO_INTERN_CONTEXT
+
+// Context tables are read without the lock, like the intern shards: the
+// current table is published through an atomic pointer and lookups probe
+// it inside a read section. A sweep condemns a string by swapping its
+// last_sweep for DO_KEY_SWEPT, so a reader reviving it and the sweep
+// killing it cannot both succeed, and erases it in place while `erasing`
+// is odd; a reader's miss only counts if no erasure overlapped its probe.
+// Condemned strings and superseded tables are stamped with rcu_advance
+// and freed by the first sweep that finds every read section older than
+// the stamp gone.
+
+#define DO_KEY_SWEPT SIZE_MAX   // last_sweep of a string condemned by a sweep
+
+typedef struct {
+    _Atomic(char*) str;
+    _Atomic size_t hash;
+} context_slot_t;
+
+typedef struct context_table_t {
+    size_t capacity;                  // Number of slots (power of two)
+    struct context_table_t* retired;  // Next table on the retired list
+    uint64_t retired_epoch;           // Read section stamp, set when superseded
+    context_slot_t slots[];
+} context_table_t;
+
+// Strings one sweep condemned, freed together once readers moved on
+typedef struct context_swept_t {
+    struct context_swept_t* next;
+    uint64_t epoch;                   // Read section stamp, set after erasing
+    size_t count;
+    char* keys[];
+} context_swept_t;
+
+struct do_context_t {
+    _Atomic(context_table_t*) table; // Linear probing, no tombstones; NULL until first insert
+    atomic_uint erasing;             // Odd while a sweep moves slots
+    _Atomic size_t sweeps;
+    const do_allocator_t* allocator; // NULL for DO_MALLOC and do_alloc
+    atomic_int lock;                 // Serializes inserts, sweeps and counters
+    size_t key_count;
+    size_t key_bytes;
+    size_t keys_reclaimed;
+    context_table_t* retired;        // Superseded tables not yet freed
+    context_swept_t* swept;          // Condemned strings not yet freed
+};
+
+static DO_THREAD_LOCAL do_context g_context;
+
+static char* context_copy_string(do_context ctx, const char* str, size_t len, size_t hash) {
+    size_t bytes = sizeof(do_key_header_t) + len + 1;
+    do_key_header_t* header = (do_key_header_t*)(ctx && ctx->allocator
+        ? ctx->allocator->alloc(bytes, ctx->allocator->context) : DO_MALLOC(bytes));
+    if (!header) return NULL;
+    header->context = ctx;
+    atomic_init(&header->refs, 0);
+    atomic_init(&header->last_sweep, ctx ? atomic_load_explicit(&ctx->sweeps, memory_order_relaxed) : 0);
+    init_key_header(header, str, len, hash);
+    return (char*)(header + 1);
+}
+
+#define intern_copy_string(str, len, hash) context_copy_string(NULL, str, len, hash)
+
+static void intern_free_string(char* str) {
+    do_key_header_t* header = key_header(str);
+    do_context ctx = header->context;
+    if (ctx && ctx->allocator) {
+        ctx->allocator->free(header, sizeof(do_key_header_t) + header->length + 1, ctx->allocator->context);
+    } else {
+        DO_FREE(header);
+    }
+}
+
+// The slot holding str (stored in *found), or the empty slot where it
+// would be inserted (*found = NULL). Safe without the lock: a slot moved
+// by a concurrent sweep can only cause a miss, never a wrong match
+static context_slot_t* context_find_slot(context_table_t* table, const char* str, size_t len,
+                                         size_t hash, char** found) {
+    size_t mask = table->capacity - 1;
+    for (size_t i = do_intern_mix(hash) & mask;; i = (i + 1) & mask) {
+        context_slot_t* slot = &table->slots[i];
+        char* entry = atomic_load_explicit(&slot->str, memory_order_acquire);
+        if (!entry || (atomic_load_explicit(&slot->hash, memory_order_relaxed) == hash &&
+                       interned_equals(entry, str, len))) {
+            *found = entry;
+            return slot;
+        }
+    }
+}
+
+// Called with the lock held
+static context_table_t* grow_context_table(do_context ctx, context_table_t* old) {
+    size_t capacity = old ? old->capacity * 2 : DO_INTERN_INITIAL_CAPACITY;
+    size_t bytes = sizeof(context_table_t) + capacity * sizeof(context_slot_t);
+    context_table_t* table = (context_table_t*)DO_MALLOC(bytes);
+    if (!table) return NULL;
+    memset(table, 0, bytes);
+    table->capacity = capacity;
+    
+    for (size_t i = 0; old && i < old->capacity; i++) {
+        char* str = atomic_load_explicit(&old->slots[i].str, memory_order_relaxed);
+        if (!str) continue;
+        size_t hash = atomic_load_explicit(&old->slots[i].hash, memory_order_relaxed);
+        char* found;
+        context_slot_t* slot = context_find_slot(table, str, key_header(str)->length, hash, &found);
+        atomic_store_explicit(&slot->hash, hash, memory_order_relaxed);
+        atomic_store_explicit(&slot->str, str, memory_order_relaxed);
+    }
+    
+    // Publish - the release store makes the copied slots visible to readers
+    atomic_store_explicit(&ctx->table, table, memory_order_release);
+    if (old) {
+        old->retired_epoch = rcu_advance();
+        old->retired = ctx->retired;
+        ctx->retired = old;
+    }
+    return table;
+}
+
+// Empty slot i, moving later entries of its cluster back into the hole.
+// Called with the lock held and `erasing` odd.
+static void context_erase_slot(context_table_t* table, size_t i) {
+    size_t mask = table->capacity - 1;
+    for (size_t j = (i + 1) & mask;; j = (j + 1) & mask) {
+        char* str = atomic_load_explicit(&table->slots[j].str, memory_order_relaxed);
+        if (!str) break;
+        size_t hash = atomic_load_explicit(&table->slots[j].hash, memory_order_relaxed);
+        size_t home = do_intern_mix(hash) & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {  // Home is not between the hole and j
+            atomic_store_explicit(&table->slots[i].hash, hash, memory_order_relaxed);
+            atomic_store_explicit(&table->slots[i].str, str, memory_order_relaxed);
+            i = j;
+        }
+    }
+    atomic_store_explicit(&table->slots[i].str, NULL, memory_order_relaxed);
+}
+
+// Finding a string counts as using it, so lookups keep it from being swept.
+// Written only when the interval changed; fails once a sweep condemned it.
+static int context_touch(do_context ctx, char* str) {
+    _Atomic size_t* last_sweep = &key_header(str)->last_sweep;
+    size_t interval = atomic_load_explicit(&ctx->sweeps, memory_order_relaxed);
+    size_t seen = atomic_load_explicit(last_sweep, memory_order_relaxed);
+    while (seen != interval) {
+        if (seen == DO_KEY_SWEPT) return 0;
+        if (atomic_compare_exchange_weak_explicit(last_sweep, &seen, interval, memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            break;
+        }
+    }
+    return 1;
+}
+
+static char* context_lookup_locked(do_context ctx, const char* str, size_t len, size_t hash, int insert) {
+    do_spin_lock(&ctx->lock);
+    
+    // Sweeps hold the lock too, so nothing found here is condemned
+    context_table_t* table = atomic_load_explicit(&ctx->table, memory_order_relaxed);
+    char* interned = NULL;
+    if (table) context_find_slot(table, str, len, hash, &interned);
+    if (interned) {
+        context_touch(ctx, interned);
+    } else if (insert) {
+        if (!table || (ctx->key_count + 1) * 2 > table->capacity) table = grow_context_table(ctx, table);
+        interned = table ? context_copy_string(ctx, str, len, hash) : NULL;
+        if (interned) {
+            char* found;
+            context_slot_t* slot = context_find_slot(table, str, len, hash, &found);
+            atomic_store_explicit(&slot->hash, hash, memory_order_relaxed);
+            atomic_store_explicit(&slot->str, interned, memory_order_release);
+            ctx->key_count++;
+            ctx->key_bytes += len + 1;
+        }
+    }
+    
+    do_spin_unlock(&ctx->lock);
+    return interned;
+}
+
+// Strings of the bound context shadow the global table; text neither holds
+// is added here (insert). Hits and trusted misses never take the lock.
+static char* context_lookup(do_context ctx, const char* str, size_t len, size_t hash, int insert) {
+    rcu_enter();
+    unsigned erasing = atomic_load_explicit(&ctx->erasing, memory_order_acquire);
+    if (!(erasing & 1)) {
+        context_table_t* table = atomic_load_explicit(&ctx->table, memory_order_acquire);
+        char* found = NULL;
+        if (table) context_find_slot(table, str, len, hash, &found);
+        if (found && context_touch(ctx, found)) {
+            rcu_exit();
+            return found;
+        }
+        
+        atomic_thread_fence(memory_order_acquire);
+        if (!found && !insert && atomic_load_explicit(&ctx->erasing, memory_order_relaxed) == erasing) {
+            rcu_exit();
+            return NULL;
+        }
+    }
+    rcu_exit();
+    return context_lookup_locked(ctx, str, len, hash, insert);
+}
+
+// Shapes and property tables that store a key hold a reference on it
+static void key_retain(const char* key) {
+    do_key_header_t* header = key_header(key);
+    if (header->context) atomic_fetch_add_explicit(&header->refs, 1, memory_order_relaxed);
+}
+
+// Never frees: unreferenced strings wait for do_context_sweep
+static void key_release(const char* key) {
+    do_key_header_t* header = key_header(key);
+    if (header->context) atomic_fetch_sub_explicit(&header->refs, 1, memory_order_release);
+}
+
+#else
+
+static char* intern_copy_string(const char* str, size_t len, size_t hash) {
+    do_key_header_t* header = (do_key_header_t*)DO_MALLOC(sizeof(do_key_header_t) + len + 1);
+    if (!header) return NULL;
+    init_key_header(header, str, len, hash);
+    return (char*)(header + 1);
+}
+
+#define intern_free_string(str) DO_FREE(key_header(str))
+#define key_retain(key) ((void)0)
+#define key_release(key) ((void)0)
+
+#endif
+
+#if DO_INTERN_CONCURRENT
+
+// Sharded intern table with lock-free lookups. Each shard publishes its
+// current table through an atomic pointer; readers probe it without locking.
+// Inserts take the shard's spinlock, write the slot hash and then publish the
+// string pointer with a release store. Growth copies into a bigger table and
+// publishes it the same way. Superseded tables stay on a retired list until
+// do_string_intern_cleanup, so a reader holding an old table pointer never
+// touches freed memory - it may only miss a newer key and fall through to
+// the locked path, which re-checks the current table.
+
+typedef struct {
+    _Atomic(char*) str;
+    size_t hash;
+} intern_slot_t;
+
+typedef struct intern_table_t {
+    size_t capacity;                  // Number of slots (power of two)
+    size_t count;                     // Occupied slots (written under lock)
+    struct intern_table_t* retired;   // Older, superseded table of this shard
+    intern_slot_t slots[];
+} intern_table_t;
+
+typedef struct {
+    _Atomic(intern_table_t*) table;   // Current table (NULL until first insert)
+    atomic_int lock;                  // Serializes inserts within the shard
+    char padding[64 - sizeof(void*) - sizeof(atomic_int)];  // One shard per cache line
+} intern_shard_t;
+
+#define DO_INTERN_SHARDS (1u << DO_INTERN_SHARD_BITS)
+
+static intern_shard_t g_intern_shards[DO_INTERN_SHARDS];
+
+// Bumped by do_string_intern_cleanup to invalidate per-thread caches
+static atomic_uint g_intern_generation = 1;
+
+// Returns the matching slot, or the empty slot where str would be inserted
+static intern_slot_t* find_intern_slot(intern_table_t* table, const char* str, size_t len,
+                                       size_t hash, size_t mixed) {
+    size_t mask = table->capacity - 1;
+    size_t i = (mixed >> DO_INTERN_SHARD_BITS) & mask;
+    for (;;) {
+        intern_slot_t* slot = &table->slots[i];
+        char* entry = atomic_load_explicit(&slot->str, memory_order_acquire);
+        if (!entry) return slot;
+        if (slot->hash == hash && interned_equals(entry, str, len)) return slot;
+        i = (i + 1) & mask;
+    }
+}
+
+// Lock-free lookup in the shard's currently published table
+static char* intern_shard_find(intern_shard_t* shard, const char* str, size_t len, size_t hash, size_t mixed) {
+    intern_table_t* table = atomic_load_explicit(&shard->table, memory_order_acquire);
+    if (!table) return NULL;
+    intern_slot_t* slot = find_intern_slot(table, str, len, hash, mixed);
+    DO_STAT_ADD(intern_probes, ((size_t)(slot - table->slots) - (mixed >> DO_INTERN_SHARD_BITS)) &
+                               (table->capacity - 1));
+    return atomic_load_explicit(&slot->str, memory_order_acquire);
+}
+
+// Called with the shard lock held
+static intern_table_t* grow_intern_shard(intern_shard_t* shard, intern_table_t* old_table) {
+    size_t new_capacity = old_table ? old_table->capacity * 2 : DO_INTERN_INITIAL_CAPACITY;
+    size_t bytes = sizeof(intern_table_t) + new_capacity * sizeof(intern_slot_t);
+    intern_table_t* new_table = (intern_table_t*)DO_MALLOC(bytes);
+    if (!new_table) return NULL;
+    memset(new_table, 0, bytes);
+    new_table->capacity = new_capacity;
+    new_table->retired = old_table;
+    
+    if (old_table) {
+        for (size_t i = 0; i < old_table->capacity; i++) {
+            char* str = atomic_load_explicit(&old_table->slots[i].str, memory_order_relaxed);
+            if (!str) continue;
+            size_t hash = old_table->slots[i].hash;
+            intern_slot_t* slot = find_intern_slot(new_table, str, key_header(str)->length, hash, do_intern_mix(hash));
+            slot->hash = hash;
+            atomic_store_explicit(&slot->str, str, memory_order_relaxed);
+        }
+        new_table->count = old_table->count;
+    }
+    
+    // Publish - the release store makes the copied slots visible to readers
+    atomic_store_explicit(&shard->table, new_table, memory_order_release);
+    return new_table;
+}
+
+static char* intern_shard_insert(intern_shard_t* shard, const char* str, size_t len, size_t hash, size_t mixed) {
+    do_spin_lock(&shard->lock);
+    
+    // Another thread may have inserted str since our lock-free miss
+    intern_table_t* table = atomic_load_explicit(&shard->table, memory_order_relaxed);
+    if (table) {
+        char* existing = atomic_load_explicit(&find_intern_slot(table, str, len, hash, mixed)->str,
+                                              memory_order_relaxed);
+        if (existing) {
+            do_spin_unlock(&shard->lock);
+            return existing;
+        }
+    }
+    
+    if (!table || (table->count + 1) * 2 > table->capacity) {
+        table = grow_intern_shard(shard, table);
+        if (!table) {
+            do_spin_unlock(&shard->lock);
+            return NULL;
+        }
+    }
+    
+    char* new_str = intern_copy_string(str, len, hash);
+    if (!new_str) {
+        do_spin_unlock(&shard->lock);
+        return NULL;
+    }
+    
+    intern_slot_t* slot = find_intern_slot(table, str, len, hash, mixed);
+    slot->hash = hash;
+    atomic_store_explicit(&slot->str, new_str, memory_order_release);
+    table->count++;
+    
+    do_spin_unlock(&shard->lock);
+    DO_STAT_ADD(intern_inserts, 1);
+    DO_STAT_ADD(intern_strings, 1);
+    return new_str;
+}
+
+#if DO_INTERN_TLS_CACHE > 0
+
+typedef struct {
+    const char* str;
+    size_t hash;
+    unsigned generation;
+} intern_cache_entry_t;
+
+// Direct-mapped, per-thread; hits never touch the shared shards
+static DO_THREAD_LOCAL intern_cache_entry_t g_intern_cache[DO_INTERN_TLS_CACHE];
+
+#endif
+
+static const char* intern_hashed(const char* str, size_t len, size_t hash) {
+    size_t mixed = do_intern_mix(hash);
+    DO_STAT_ADD(intern_lookups, 1);
+    
+#if DO_INTERN_CONTEXT
+    // The bound context's own copy wins, so its keys keep resolving after
+    // the same text is interned globally
+    if (g_context) {
+        const char* own = context_lookup(g_context, str, len, hash, 0);
+        if (own) return own;
+    }
+#endif
+    
+#if DO_INTERN_TLS_CACHE > 0
+    unsigned generation = atomic_load_explicit(&g_intern_generation, memory_order_relaxed);
+    intern_cache_entry_t* cached = &g_intern_cache[(mixed >> DO_INTERN_SHARD_BITS) & (DO_INTERN_TLS_CACHE - 1)];
+    if (cached->generation == generation && cached->hash == hash && interned_equals(cached->str, str, len)) {
+        return cached->str;
+    }
+#endif
+    
+    intern_shard_t* shard = &g_intern_shards[mixed & (DO_INTERN_SHARDS - 1)];
+    char* interned = intern_shard_find(shard, str, len, hash, mixed);
+    if (!interned) {
+#if DO_INTERN_CONTEXT
+        if (g_context) return context_lookup(g_context, str, len, hash, 1);
+#endif
+        interned = intern_shard_insert(shard, str, len, hash, mixed);
+        if (!interned) return NULL;
+    }
+    
+#if DO_INTERN_TLS_CACHE > 0
+    cached->str = interned;
+    cached->hash = hash;
+    cached->generation = generation;
+#endif
+    
+    return interned;
+}
+
+static const char* find_interned_hashed(const char* str, size_t len, size_t hash) {
+    size_t mixed = do_intern_mix(hash);
+    DO_STAT_ADD(intern_lookups, 1);
+#if DO_INTERN_CONTEXT
+    if (g_context) {
+        const char* own = context_lookup(g_context, str, len, hash, 0);
+        if (own) return own;
+    }
+#endif
+    return intern_shard_find(&g_intern_shards[mixed & (DO_INTERN_SHARDS - 1)], str, len, hash, mixed);
+}
+
+DO_DEF void do_string_intern_cleanup(void) {
+    for (unsigned s = 0; s < DO_INTERN_SHARDS; s++) {
+        intern_shard_t* shard = &g_intern_shards[s];
+        intern_table_t* table = atomic_load_explicit(&shard->table, memory_order_acquire);
+        if (!table) continue;
+        
+        // Only the newest table owns the strings; retired ones hold copies of the pointers
+        for (size_t i = 0; i < table->capacity; i++) {
+            char* str = atomic_load_explicit(&table->slots[i].str, memory_order_relaxed);
+            if (str) intern_free_string(str);
+        }
+        DO_STAT_SUB(intern_strings, table->count);
+        while (table) {
+            intern_table_t* retired = table->retired;
+            DO_FREE(table);
+            table = retired;
+        }
+        atomic_store_explicit(&shard->table, NULL, memory_order_release);
+    }
+    atomic_fetch_add_explicit(&g_intern_generation, 1, memory_order_relaxed);
+}
+
+#else
+
+typedef struct {
+    char* str;
+    size_t hash;
+} intern_entry_t;
+
+// Open-addressing intern table (linear probing, power-of-two capacity).
+// Slots only hold pointers to separately allocated strings, so rehashing
+// never moves interned strings and returned pointers stay stable.
+static intern_entry_t* g_intern_table = NULL;
+static size_t g_intern_capacity = 0;   // Number of slots (power of two)
+static size_t g_intern_count = 0;      // Number of occupied slots
+
+// Find the slot holding str, or the empty slot where it would be inserted
+static intern_entry_t* find_intern_slot(intern_entry_t* table, size_t capacity,
+                                        const char* str, size_t len, size_t hash) {
+    size_t mask = capacity - 1;
+    size_t i = do_intern_mix(hash) & mask;
+    for (;;) {
+        intern_entry_t* entry = &table[i];
+        if (!entry->str) return entry;
+        if (entry->hash == hash && interned_equals(entry->str, str, len)) return entry;
+        i = (i + 1) & mask;
+    }
+}
+
+static int grow_intern_table(void) {
+    size_t new_capacity = g_intern_capacity ? g_intern_capacity * 2 : DO_INTERN_INITIAL_CAPACITY;
+    intern_entry_t* new_table = (intern_entry_t*)DO_MALLOC(new_capacity * sizeof(intern_entry_t));
+    if (!new_table) return DO_ERROR_MEMORY;
+    memset(new_table, 0, new_capacity * sizeof(intern_entry_t));
+    
+    // Rehash existing entries (strings themselves are not moved)
+    for (size_t i = 0; i < g_intern_capacity; i++) {
+        intern_entry_t* entry = &g_intern_table[i];
+        if (entry->str) {
+            *find_intern_slot(new_table, new_capacity, entry->str, key_header(entry->str)->length,
+                              entry->hash) = *entry;
+        }
+    }
+    
+    DO_FREE(g_intern_table);
+    g_intern_table = new_table;
+    g_intern_capacity = new_capacity;
+    return DO_SUCCESS;
+}
+
+static const char* intern_hashed(const char* str, size_t len, size_t hash) {
+    DO_STAT_ADD(intern_lookups, 1);
+    
+#if DO_INTERN_CONTEXT
+    // The bound context's own copy wins, so its keys keep resolving after
+    // the same text is interned globally
+    if (g_context) {
+        const char* own = context_lookup(g_context, str, len, hash, 0);
+        if (own) return own;
+    }
+#endif
+    
+    if (g_intern_table) {
+        intern_entry_t* entry = find_intern_slot(g_intern_table, g_intern_capacity, str, len, hash);
+        DO_STAT_ADD(intern_probes, ((size_t)(entry - g_intern_table) - do_intern_mix(hash)) &
+                                   (g_intern_capacity - 1));
+        if (entry->str) return entry->str;
+    }
+    
+#if DO_INTERN_CONTEXT
+    if (g_context) return context_lookup(g_context, str, len, hash, 1);
+#endif
+    
+    // Not found - keep load factor at or below 1/2 before inserting
+    if ((g_intern_count + 1) * 2 > g_intern_capacity) {
+        if (grow_intern_table() != DO_SUCCESS) return NULL;
+    }
+    
+    char* new_str = intern_copy_string(str, len, hash);
+    if (!new_str) return NULL;
+    
+    intern_entry_t* slot = find_intern_slot(g_intern_table, g_intern_capacity, str, len, hash);
+    slot->str = new_str;
+    slot->hash = hash;
+    g_intern_count++;
+    DO_STAT_ADD(intern_inserts, 1);
+    DO_STAT_ADD(intern_strings, 1);
+    
     return new_str;
 }
 
-DO_DEF const char* do_string_find_interned(const char* str) {
-    if (!str || !g_intern_table) return NULL;
+static const char* find_interned_hashed(const char* str, size_t len, size_t hash) {
+#if DO_INTERN_CONTEXT
+    if (g_context) {
+        const char* own = context_lookup(g_context, str, len, hash, 0);
+        if (own) return own;
+    }
+#endif
+    const char* interned = NULL;
+    if (g_intern_table) {
+        DO_STAT_ADD(intern_lookups, 1);
+        intern_entry_t* entry = find_intern_slot(g_intern_table, g_intern_capacity, str, len, hash);
+        DO_STAT_ADD(intern_probes, ((size_t)(entry - g_intern_table) - do_intern_mix(hash)) &
+                                   (g_intern_capacity - 1));
+        interned = entry->str;
+    }
+    return interned;
+}
+
+DO_DEF void do_string_intern_cleanup(void) {
+    if (g_intern_table) {
+        for (size_t i = 0; i < g_intern_capacity; i++) {
+            if (g_intern_table[i].str) {
+                intern_free_string(g_intern_table[i].str);
+            }
+        }
+        DO_FREE(g_intern_table);
+        DO_STAT_SUB(intern_strings, g_intern_count);
+        g_intern_table = NULL;
+        g_intern_capacity = 0;
+        g_intern_count = 0;
+    }
+}
+
+#endif // DO_INTERN_CONCURRENT
+
+DO_DEF size_t do_string_hash(const char* str, size_t len) {
+    DO_ASSERT(str != NULL || len == 0);
+    
+    size_t hash = DO_STRING_HASH_INIT;
+    for (size_t i = 0; i < len; i++) hash = DO_STRING_HASH_STEP(hash, str[i]);
+    return hash;
+}
+
+DO_DEF const char* do_string_intern(const char* str) {
+    DO_ASSERT(str != NULL);
+    
+    size_t len;
+    size_t hash = hash_string(str, &len);
+    return intern_hashed(str, len, hash);
+}
+
+DO_DEF const char* do_string_intern_n(const char* str, size_t len) {
+    return do_string_intern_hashed(str, len, do_string_hash(str, len));
+}
+
+DO_DEF const char* do_string_intern_hashed(const char* str, size_t len, size_t hash) {
+    DO_ASSERT(str != NULL);
+    DO_ASSERT(memchr(str, '\0', len) == NULL);
+    DO_ASSERT(hash == do_string_hash(str, len));
+    return intern_hashed(str, len, hash);
+}
+
+DO_DEF const char* do_string_find_interned(const char* str) {
+    if (!str) return NULL;
+    
+    size_t len;
+    size_t hash = hash_string(str, &len);
+    return find_interned_hashed(str, len, hash);
+}
+
+DO_DEF size_t do_interned_length(const char* interned) {
+    DO_ASSERT(interned != NULL);
+    return key_header(interned)->length;
+}
+
+DO_DEF size_t do_interned_hash(const char* interned) {
+    DO_ASSERT(interned != NULL);
+    return key_header(interned)->hash;
+}
+
+#endif // DO_STRING_INTERNING
+
+DO_DEF int do_register_keys(const do_key_entry_t* entries, size_t count) {
+    DO_ASSERT(count == 0 || entries != NULL);
+    
+#if DO_INTERN_CONTEXT
+    // The stored pointers are shared by every thread, so they must not be
+    // a context's own (sweepable) keys
+    do_context bound = g_context;
+    g_context = NULL;
+#endif
+    int result = DO_SUCCESS;
+    for (size_t i = 0; i < count; i++) {
+        const char* interned = do_string_intern(entries[i].name);
+        if (!interned) {
+            result = DO_ERROR_MEMORY;
+            break;
+        }
+        *entries[i].key = interned;
+    }
+#if DO_INTERN_CONTEXT
+    g_context = bound;
+#endif
+    return result;
+}
+
+/* =============================================================================
+ * ALLOCATION IMPLEMENTATION
+ * ============================================================================= */
+
+// All object, shape and property memory goes through do_alloc/do_dealloc,
+// which are told the block size on free. With DO_POOL_ALLOCATOR the sizes
+// are rounded up to 16-byte classes and freed blocks are kept on a
+// per-thread list for reuse; without it they map straight to DO_MALLOC/DO_FREE.
+
+// Account an in-place resize (or realloc) in the byte counters
+#if DO_STATS
+static void* stats_resized(void* ptr, size_t old_size, size_t new_size) {
+    if (ptr) {
+        DO_STAT_ADD(bytes_allocated, new_size);
+        DO_STAT_ADD(bytes_freed, old_size);
+        DO_STAT_ADD(live_bytes, (uint64_t)new_size - (uint64_t)old_size);
+    }
+    return ptr;
+}
+#else
+#define stats_resized(ptr, old_size, new_size) (ptr)
+#endif
+
+#if DO_POOL_ALLOCATOR
+
+#define DO_POOL_GRANULE 16
+#define DO_POOL_CLASSES (DO_POOL_MAX_BLOCK / DO_POOL_GRANULE)
+
+typedef struct do_pool_block_t {
+    struct do_pool_block_t* next;
+} do_pool_block_t;
+
+typedef struct {
+    do_pool_block_t* free_list[DO_POOL_CLASSES];
+    int free_count[DO_POOL_CLASSES];
+} do_pool_t;
+
+// Per-thread, so no locking; a block freed on another thread simply joins
+// that thread's list
+static DO_THREAD_LOCAL do_pool_t g_pool;
+
+static void* do_alloc(size_t size) {
+    void* ptr;
+    if (size == 0 || size > DO_POOL_MAX_BLOCK) {
+        ptr = DO_MALLOC(size);
+    } else {
+        size_t cls = (size - 1) / DO_POOL_GRANULE;
+        do_pool_block_t* block = g_pool.free_list[cls];
+        if (block) {
+            g_pool.free_list[cls] = block->next;
+            g_pool.free_count[cls]--;
+            ptr = block;
+        } else {
+            ptr = DO_MALLOC((cls + 1) * DO_POOL_GRANULE);
+        }
+    }
+    
+    // Failed allocations are not counted, so live_bytes stays exact
+    if (ptr) {
+        DO_STAT_ADD(bytes_allocated, size);
+        DO_STAT_ADD(live_bytes, size);
+    }
+    return ptr;
+}
+
+static void do_dealloc(void* ptr, size_t size) {
+    if (!ptr) return;
+    DO_STAT_ADD(bytes_freed, size);
+    DO_STAT_SUB(live_bytes, size);
+    if (size == 0 || size > DO_POOL_MAX_BLOCK) {
+        DO_FREE(ptr);
+        return;
+    }
+    
+    size_t cls = (size - 1) / DO_POOL_GRANULE;
+    if (g_pool.free_count[cls] >= DO_POOL_MAX_FREE) {
+        DO_FREE(ptr);
+        return;
+    }
+    do_pool_block_t* block = (do_pool_block_t*)ptr;
+    block->next = g_pool.free_list[cls];
+    g_pool.free_list[cls] = block;
+    g_pool.free_count[cls]++;
+}
+
+static void* do_resize(void* ptr, size_t old_size, size_t new_size) {
+    // Same size class, or both sizes outside the pool: realloc semantics apply
+    if (old_size > DO_POOL_MAX_BLOCK && new_size > DO_POOL_MAX_BLOCK) {
+        return stats_resized(DO_REALLOC(ptr, new_size), old_size, new_size);
+    }
+    if (ptr && old_size && new_size <= DO_POOL_MAX_BLOCK &&
+        (old_size - 1) / DO_POOL_GRANULE == (new_size - 1) / DO_POOL_GRANULE) {
+        return stats_resized(ptr, old_size, new_size);
+    }
+    
+    void* resized = do_alloc(new_size);
+    if (!resized) return NULL;
+    if (ptr) {
+        memcpy(resized, ptr, old_size < new_size ? old_size : new_size);
+        do_dealloc(ptr, old_size);
+    }
+    return resized;
+}
+
+DO_DEF void do_pool_trim(void) {
+    for (int cls = 0; cls < DO_POOL_CLASSES; cls++) {
+        do_pool_block_t* block = g_pool.free_list[cls];
+        while (block) {
+            do_pool_block_t* next = block->next;
+            DO_FREE(block);
+            block = next;
+        }
+        g_pool.free_list[cls] = NULL;
+        g_pool.free_count[cls] = 0;
+    }
+}
+
+#elif DO_STATS
+
+static void* do_alloc(size_t size) {
+    void* ptr = DO_MALLOC(size);
+    if (ptr) {
+        DO_STAT_ADD(bytes_allocated, size);
+        DO_STAT_ADD(live_bytes, size);
+    }
+    return ptr;
+}
+
+static void do_dealloc(void* ptr, size_t size) {
+    if (!ptr) return;
+    DO_STAT_ADD(bytes_freed, size);
+    DO_STAT_SUB(live_bytes, size);
+    DO_FREE(ptr);
+}
+
+static void* do_resize(void* ptr, size_t old_size, size_t new_size) {
+    return stats_resized(DO_REALLOC(ptr, new_size), old_size, new_size);
+}
+
+#else
+
+#define do_alloc(size) DO_MALLOC(size)
+#define do_dealloc(ptr, size) ((void)(size), DO_FREE(ptr))
+#define do_resize(ptr, old_size, new_size) ((void)(old_size), DO_REALLOC(ptr, new_size))
+
+#endif // DO_POOL_ALLOCATOR
+
+/* =============================================================================
+ * ARENA STORAGE IMPLEMENTATION
+ * ============================================================================= */
+
+// Arena memory is bump-allocated from chunks and only given back on reset
+// or destroy. The arena also owns, once each, the heap resources its
+// objects would otherwise reference individually: their shapes, heap
+// prototypes and heap objects stored as DO_TYPE_OBJ values.
+
+#define DO_ARENA_ALIGN 8  // Matches the alignment of inline property values
+
+typedef struct do_arena_chunk_t {
+    struct do_arena_chunk_t* next;
+    size_t capacity;
+    size_t used;
+    union { long long align_ll; double align_d; void* align_p; } data[];
+} do_arena_chunk_t;
+
+struct do_arena_t {
+    do_arena_chunk_t* chunks;       // Head is the chunk being bumped
+    size_t chunk_size;
+    struct { do_shape_t* key; int value; }* shapes;      // stb_ds set of held shapes
+    struct { do_object key; int value; }* held;         // stb_ds set of retained heap objects
+#if DO_INTERN_CONTEXT
+    struct { const char* key; int value; }* keys;       // stb_ds set of held context keys
+#endif
+    int used_as_prototype;          // Some object in the arena is a prototype
+#if DO_SNAPSHOT
+    const unsigned char* borrowed;  // Value bytes in here are referenced, not copied
+    size_t borrowed_size;
+#endif
+};
+
+static do_arena_chunk_t* arena_new_chunk(size_t capacity) {
+    do_arena_chunk_t* chunk = (do_arena_chunk_t*)DO_MALLOC(sizeof(do_arena_chunk_t) + capacity);
+    if (!chunk) return NULL;
+    chunk->next = NULL;
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    return chunk;
+}
+
+static void* arena_alloc(do_arena arena, size_t size) {
+    size = (size + DO_ARENA_ALIGN - 1) & ~(size_t)(DO_ARENA_ALIGN - 1);
+    
+    do_arena_chunk_t* head = arena->chunks;
+    if (head->capacity - head->used >= size) {
+        void* ptr = (unsigned char*)head->data + head->used;
+        head->used += size;
+        return ptr;
+    }
+    
+    // Big blocks get a chunk of their own behind the head, so the space
+    // left in the head chunk stays usable
+    if (size > arena->chunk_size / 4) {
+        do_arena_chunk_t* big = arena_new_chunk(size);
+        if (!big) return NULL;
+        big->used = size;
+        big->next = head->next;
+        head->next = big;
+        return big->data;
+    }
+    
+    do_arena_chunk_t* chunk = arena_new_chunk(arena->chunk_size);
+    if (!chunk) return NULL;
+    chunk->used = size;
+    chunk->next = head;
+    arena->chunks = chunk;
+    return chunk->data;
+}
+
+// Storage for an object's slots and property values: from its arena, or
+// from the pool/heap. Arena blocks are never freed individually.
+// Objects with a do_allocator_t bypass do_alloc and the pool entirely
+static void* allocator_alloc(const do_allocator_t* allocator, size_t size) {
+    void* ptr = allocator->alloc(size, allocator->context);
+    if (ptr) {
+        DO_STAT_ADD(bytes_allocated, size);
+        DO_STAT_ADD(live_bytes, size);
+    }
+    return ptr;
+}
+
+static void allocator_free(const do_allocator_t* allocator, void* ptr, size_t size) {
+    if (!ptr) return;
+    DO_STAT_ADD(bytes_freed, size);
+    DO_STAT_SUB(live_bytes, size);
+    allocator->free(ptr, size, allocator->context);
+}
+
+static void* allocator_resize(const do_allocator_t* allocator, void* ptr, size_t old_size, size_t new_size) {
+    if (!ptr) return allocator_alloc(allocator, new_size);
+    if (allocator->resize) {
+        return stats_resized(allocator->resize(ptr, old_size, new_size, allocator->context),
+                             old_size, new_size);
+    }
+    
+    void* resized = allocator_alloc(allocator, new_size);
+    if (resized) {
+        memcpy(resized, ptr, old_size < new_size ? old_size : new_size);
+        allocator_free(allocator, ptr, old_size);
+    }
+    return resized;
+}
+
+static void* object_alloc(do_object obj, size_t size) {
+    if (obj->arena) return arena_alloc(obj->arena, size);
+    return obj->allocator ? allocator_alloc(obj->allocator, size) : do_alloc(size);
+}
+
+static void object_dealloc(do_object obj, void* ptr, size_t size) {
+    if (obj->arena) return;
+    if (obj->allocator) {
+        allocator_free(obj->allocator, ptr, size);
+    } else {
+        do_dealloc(ptr, size);
+    }
+}
+
+static void* object_resize(do_object obj, void* ptr, size_t old_size, size_t new_size) {
+    if (!obj->arena) {
+        return obj->allocator ? allocator_resize(obj->allocator, ptr, old_size, new_size)
+                              : do_resize(ptr, old_size, new_size);
+    }
+    
+    void* resized = arena_alloc(obj->arena, new_size);
+    if (resized && ptr) {
+        memcpy(resized, ptr, old_size < new_size ? old_size : new_size);
+    }
+    return resized;
+}
+
+/* =============================================================================
+ * PROPERTY STORAGE IMPLEMENTATION
+ * ============================================================================= */
+
+// Pointer to a property's value, wherever it is stored
+static void* property_data(do_property_t* prop) {
+    return prop->size <= DO_INLINE_SIZE ? (void*)prop->data.bytes : prop->data.heap.ptr;
+}
+
+// Set up uninitialized storage of `size` bytes in a fresh property of obj
+// (inline when it fits). Returns the storage, or NULL on allocation failure.
+static void* init_property_storage(do_object obj, do_property_t* prop, size_t size) {
+#if DO_TAGGED_VALUES
+    if (size > UINT32_MAX) return NULL;
+    prop->type = DO_TYPE_BYTES;
+#endif
+    if (size <= DO_INLINE_SIZE) {
+        prop->size = size;
+        return prop->data.bytes;
+    }
+    
+    void* buffer = object_alloc(obj, size);
+    if (!buffer) return NULL;
+    prop->data.heap.ptr = buffer;
+    prop->data.heap.capacity = size;
+    prop->size = size;
+    return buffer;
+}
+
+#if DO_TAGGED_VALUES
+
+// Object referenced by a DO_TYPE_OBJ property
+#define property_object(prop) (*(do_object*)(void*)(prop)->data.bytes)
+
+// The reference a copied DO_TYPE_OBJ value needs of its own
+static void retain_value_ref(const do_property_t* prop) {
+    if (prop->type == DO_TYPE_OBJ && property_object(prop)) do_retain(property_object(prop));
+}
+
+// Values of arena objects hold no references: the arena does (see retain_for)
+static void release_value_ref(do_object obj, do_property_t* prop) {
+    if (obj->arena) return;
+    if (prop->type == DO_TYPE_OBJ && property_object(prop)) {
+        do_object child = property_object(prop);
+        do_release(&child);
+    }
+}
+
+#else
+#define retain_value_ref(prop) ((void)0)
+#define release_value_ref(obj, prop) ((void)0)
+#endif
+
+#if DO_SNAPSHOT
+// Whether data lies in the snapshot image obj's arena borrows from
+static int object_borrows(do_object obj, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    const struct do_arena_t* arena = obj->arena;
+    if (!arena || !arena->borrowed || bytes < arena->borrowed) return 0;
+    size_t offset = (size_t)(bytes - arena->borrowed);
+    return offset <= arena->borrowed_size && size <= arena->borrowed_size - offset;
+}
+#endif
+
+// Store a copy of data in a fresh property of obj. Heap-sized values of a
+// snapshot arena point at the image instead; capacity 0 marks the buffer
+// as not owned, so nothing frees it or writes over it.
+static int init_property_value(do_object obj, do_property_t* prop, const void* data, size_t size) {
+#if DO_SNAPSHOT
+    if (size > DO_INLINE_SIZE && object_borrows(obj, data, size)) {
+#if DO_TAGGED_VALUES
+        if (size > UINT32_MAX) return DO_ERROR_MEMORY;
+        prop->type = DO_TYPE_BYTES;
+#endif
+        prop->data.heap.ptr = (void*)data;
+        prop->data.heap.capacity = 0;
+        prop->size = size;
+        return DO_SUCCESS;
+    }
+#endif
+    void* storage = init_property_storage(obj, prop, size);
+    if (!storage) return DO_ERROR_MEMORY;
+    memcpy(storage, data, size);
+    return DO_SUCCESS;
+}
+
+// Run release_fn on the value and free its heap buffer, if any
+static void release_property_value(do_object obj, do_property_t* prop) {
+#if DO_TAGGED_VALUES
+    if (prop->type != DO_TYPE_BYTES) {  // Typed values are always inline
+        release_value_ref(obj, prop);
+        return;
+    }
+#endif
+    if (obj->release_fn) {
+        obj->release_fn(property_data(prop));
+    }
+    if (prop->size > DO_INLINE_SIZE) {
+        object_dealloc(obj, prop->data.heap.ptr, prop->data.heap.capacity);
+    }
+}
+
+// Give prop of obj its own copy of src's value, type and reference included
+static int copy_property_value(do_object obj, do_property_t* prop, const do_property_t* src) {
+    if (init_property_value(obj, prop, property_data((do_property_t*)src), src->size) != DO_SUCCESS) {
+        return DO_ERROR_MEMORY;
+    }
+#if DO_TAGGED_VALUES
+    prop->type = src->type;
+    retain_value_ref(prop);
+#endif
+    return DO_SUCCESS;
+}
+
+// Whether a new value of `size` bytes can be written over prop's heap buffer
+static int property_buffer_fits(const do_property_t* prop, size_t size) {
+    return size > DO_INLINE_SIZE && prop->size > DO_INLINE_SIZE && size <= prop->data.heap.capacity;
+}
+
+// Make prop hold `size` bytes of uninitialized storage, releasing the old
+// value. Its heap buffer is kept when the new size fits.
+static void* reserve_property_value(do_object obj, do_property_t* prop, size_t size) {
+    if (property_buffer_fits(prop, size)) {
+        if (obj->release_fn) obj->release_fn(prop->data.heap.ptr);
+        prop->size = size;
+        return prop->data.heap.ptr;
+    }
+    
+    do_property_t updated;
+    if (!init_property_storage(obj, &updated, size)) return NULL;
+    
+    release_property_value(obj, prop);
+    *prop = updated;
+    return property_data(prop);
+}
+
+// Replace an existing property's value. New data is written over a heap
+// buffer it fits in, unless it points into that buffer; otherwise it is
+// copied aside before the old value is released.
+static int replace_property_value(do_object obj, do_property_t* prop, const void* data, size_t size) {
+    if (property_buffer_fits(prop, size)) {
+        const unsigned char* buffer = (const unsigned char*)prop->data.heap.ptr;
+        const unsigned char* src = (const unsigned char*)data;
+        if (src + size <= buffer || src >= buffer + prop->data.heap.capacity) {
+            if (obj->release_fn) obj->release_fn(prop->data.heap.ptr);
+            memcpy(prop->data.heap.ptr, data, size);
+            prop->size = size;
+            return DO_SUCCESS;
+        }
+    }
+    
+    do_property_t updated;
+    if (init_property_value(obj, &updated, data, size) != DO_SUCCESS) return DO_ERROR_MEMORY;
+    
+    release_property_value(obj, prop);
+    *prop = updated;
+    return DO_SUCCESS;
+}
+
+// Write to an existing property: copy data in, or with data == NULL
+// reserve `size` bytes and report the storage through out
+static int write_property_value(do_object obj, do_property_t* prop, const void* data, size_t size, void** out) {
+    if (data) return replace_property_value(obj, prop, data, size);
+    
+    *out = reserve_property_value(obj, prop, size);
+    return *out ? DO_SUCCESS : DO_ERROR_MEMORY;
+}
+
+// Fill a fresh property: copy data in, or with data == NULL leave `size`
+// bytes uninitialized and report the storage through out
+static int fill_property_value(do_object obj, do_property_t* prop, const void* data, size_t size, void** out) {
+    if (data) return init_property_value(obj, prop, data, size);
+    
+    *out = init_property_storage(obj, prop, size);
+    return *out ? DO_SUCCESS : DO_ERROR_MEMORY;
+}
+
+/* =============================================================================
+ * SHAPE (HIDDEN CLASS) IMPLEMENTATION
+ * ============================================================================= */
+
+// Root of the transition tree: the empty layout every object starts with.
+// It is never reference counted or freed.
+static do_shape_t g_root_shape = { 1, 1, NULL, NULL, NULL, 0, NULL };
+static uint64_t g_next_shape_id = 2;  // Guarded by the shape lock
+
+// The transition tree is shared by all objects, so with atomic reference
+// counting (objects used from several threads) it is guarded by a spinlock
+#if DO_ATOMIC_REFCOUNT
+static atomic_int g_shape_lock;
+#define shape_lock() do_spin_lock(&g_shape_lock)
+#define shape_unlock() do_spin_unlock(&g_shape_lock)
+#else
+#define shape_lock() ((void)0)
+#define shape_unlock() ((void)0)
+#endif
+
+// Index of key in keys[0..count), or -1. Interned keys compare by pointer,
+// so the vector paths test 4 (AVX2) or 2 (SSE2, NEON) keys per compare.
+static int find_key_index_scalar(const char* const* keys, int count, const char* key) {
+    for (int i = 0; i < count; i++) {
+        if (keys[i] == key) {  // Pointer equality for interned strings
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int find_key_index(const char* const* keys, int count, const char* key) {
+    int i = 0;
+#if defined(DO_SIMD_AVX2)
+    __m256i needle4 = _mm256_set1_epi64x((long long)(uintptr_t)key);
+    for (; i + 4 <= count; i += 4) {
+        __m256i lanes = _mm256_loadu_si256((const __m256i*)(const void*)(keys + i));
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(lanes, needle4)));
+        if (mask) return i + ((mask & 1) ? 0 : (mask & 2) ? 1 : (mask & 4) ? 2 : 3);
+    }
+#endif
+#if defined(DO_SIMD_SSE2)
+    // SSE2 has no 64-bit compare: both 32-bit halves must match
+    __m128i needle2 = _mm_set1_epi64x((long long)(uintptr_t)key);
+    for (; i + 2 <= count; i += 2) {
+        __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(const void*)(keys + i)), needle2);
+        eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+        int mask = _mm_movemask_pd(_mm_castsi128_pd(eq));
+        if (mask) return i + ((mask & 1) ? 0 : 1);
+    }
+#elif defined(DO_SIMD_NEON)
+    uint64x2_t needle2 = vdupq_n_u64((uint64_t)(uintptr_t)key);
+    for (; i + 2 <= count; i += 2) {
+        uint64x2_t eq = vceqq_u64(vld1q_u64((const uint64_t*)(const void*)(keys + i)), needle2);
+        if (vmaxvq_u32(vreinterpretq_u32_u64(eq))) return i + (vgetq_lane_u64(eq, 0) ? 0 : 1);
+    }
+#endif
+    int tail = find_key_index_scalar(keys + i, count - i, key);
+    return tail >= 0 ? i + tail : -1;
+}
+
+// Slot index of key in shape, or -1
+static int find_shape_slot(const do_shape_t* shape, const char* key) {
+    return find_key_index(shape->keys, shape->slot_count, key);
+}
+
+static void shape_retain(do_shape_t* shape) {
+    if (shape == &g_root_shape) return;
+    shape_lock();
+    shape->ref_count++;
+    shape_unlock();
+}
+
+// Drop a reference; unreferenced shapes unlink from their parent, which
+// in turn loses the reference its child held (iteratively, not recursively)
+static void shape_release(do_shape_t* shape) {
+    shape_lock();
+    while (shape && shape != &g_root_shape) {
+        if (--shape->ref_count > 0) break;
+        
+        do_shape_t* parent = shape->parent;
+        (void)hmdel(parent->transitions, shape->key);
+        if (hmlen(parent->transitions) == 0) {
+            hmfree(parent->transitions);
+        }
+        hmfree(shape->transitions);
+        key_release(shape->key);
+        do_dealloc((void*)shape->keys, (size_t)shape->slot_count * sizeof(const char*));
+        do_dealloc(shape, sizeof(do_shape_t));
+        shape = parent;
+    }
+    shape_unlock();
+}
+
+// Shape reached from `shape` by adding `key`, with a reference owned by the
+// caller. Returns NULL on allocation failure or when shape is megamorphic.
+static do_shape_t* shape_add_key(do_shape_t* shape, const char* key) {
+    shape_lock();
+    
+    // stb_ds allocates on lookups in a NULL map, so check for one first
+    ptrdiff_t index = shape->transitions ? hmgeti(shape->transitions, key) : -1;
+    if (index >= 0) {
+        do_shape_t* existing = shape->transitions[index].value;
+        existing->ref_count++;
+        shape_unlock();
+        return existing;
+    }
+    
+    if (shape != &g_root_shape && hmlen(shape->transitions) >= DO_SHAPE_MAX_TRANSITIONS) {
+        shape_unlock();
+        return NULL;
+    }
+    
+    size_t keys_size = (size_t)(shape->slot_count + 1) * sizeof(const char*);
+    do_shape_t* child = (do_shape_t*)do_alloc(sizeof(do_shape_t));
+    const char** keys = (const char**)do_alloc(keys_size);
+    if (!child || !keys) {
+        do_dealloc(child, sizeof(do_shape_t));
+        do_dealloc((void*)keys, keys_size);
+        shape_unlock();
+        return NULL;
+    }
+    
+    if (shape->slot_count > 0) {
+        memcpy((void*)keys, shape->keys, (size_t)shape->slot_count * sizeof(const char*));
+    }
+    keys[shape->slot_count] = key;
+    
+    child->id = g_next_shape_id++;
+    DO_STAT_ADD(shapes_created, 1);
+    child->ref_count = 1;
+    child->parent = shape;
+    child->key = key;
+    child->keys = keys;
+    key_retain(key);
+    child->slot_count = shape->slot_count + 1;
+    child->transitions = NULL;
+    
+    // The child keeps its parent alive; the parent only points back weakly
+    if (shape != &g_root_shape) shape->ref_count++;
+    hmput(shape->transitions, key, child);
+    
+    shape_unlock();
+    return child;
+}
+
+// Arena objects do not reference their shapes individually: the arena
+// holds one reference per distinct shape so teardown skips the objects.
+// Call with a reference obtained for obj; it is kept or handed to the arena.
+static void object_shape_acquired(do_object obj, do_shape_t* shape) {
+    do_arena arena = obj->arena;
+    if (!arena || shape == &g_root_shape) return;
+    
+    if (hmgeti(arena->shapes, shape) >= 0) {
+        shape_release(shape);  // Already held by the arena
+    } else {
+        hmput(arena->shapes, shape, 1);
+    }
+}
+
+// Drop obj's use of shape (the arena keeps its reference until teardown)
+static void object_shape_release(do_object obj, do_shape_t* shape) {
+    if (!obj->arena) shape_release(shape);
+}
+
+// Make room for at least `needed` slots
+static int reserve_slots(do_object obj, int needed) {
+    if (needed <= obj->slot_capacity) return DO_SUCCESS;
+    
+    int new_capacity = obj->slot_capacity ? obj->slot_capacity * 2 : 4;
+    while (new_capacity < needed) new_capacity *= 2;
+    
+    do_property_t* slots = (do_property_t*)object_resize(obj, obj->properties.slots,
+                                                         (size_t)obj->slot_capacity * sizeof(do_property_t),
+                                                         (size_t)new_capacity * sizeof(do_property_t));
+    if (!slots) return DO_ERROR_MEMORY;
+    
+    obj->properties.slots = slots;
+    obj->slot_capacity = new_capacity;
+    return DO_SUCCESS;
+}
+
+/* =============================================================================
+ * PROTOTYPE EPOCH
+ * ============================================================================= */
+
+// Bumped whenever the result of an inherited lookup might change: a
+// prototype link is set, or an object used as a prototype gains or loses
+// a key or is destroyed. Caches of inherited lookups are tagged with it.
+#if DO_ATOMIC_REFCOUNT
+static _Atomic uint64_t g_proto_epoch = 1;
+#define proto_epoch() atomic_load_explicit(&g_proto_epoch, memory_order_acquire)
+#define bump_proto_epoch() ((void)atomic_fetch_add_explicit(&g_proto_epoch, 1, memory_order_acq_rel))
+#else
+static uint64_t g_proto_epoch = 1;
+#define proto_epoch() (g_proto_epoch)
+#define bump_proto_epoch() ((void)g_proto_epoch++)
+#endif
+
+#if DO_CONCURRENT_OBJECTS
+#define object_is_concurrent(obj) ((obj)->flags & DO_OBJECT_CONCURRENT)
+#else
+#define object_is_concurrent(obj) 0
+#endif
+
+// Call after adding or removing keys of obj
+static void note_layout_change(do_object obj) {
+    if (obj->flags & DO_OBJECT_PROTOTYPE) {
+        bump_proto_epoch();
+    }
+}
+
+// Call after changing obj's prototype. Caches check the receiver's own
+// prototype, so only objects other chains run through invalidate them.
+#define note_chain_change(obj) note_layout_change(obj)
+
+// Linking a new heir changes no existing chain, so this leaves the epoch be
+static void mark_prototype(do_object prototype) {
+    DO_ASSERT(!object_is_concurrent(prototype));
+    // Already-marked (and so all frozen) prototypes are not written to
+    if (!(prototype->flags & DO_OBJECT_PROTOTYPE)) prototype->flags |= DO_OBJECT_PROTOTYPE;
+    if (prototype->arena) prototype->arena->used_as_prototype = 1;
+}
+
+/* =============================================================================
+ * PROPERTY TABLE IMPLEMENTATION
+ * ============================================================================= */
+
+#define DO_TABLE_GROUP 16                   // Control bytes probed together
+#define DO_TABLE_MIN_CAPACITY 16
+#define DO_CTRL_EMPTY ((uint8_t)0x80)
+#define DO_CTRL_DELETED ((uint8_t)0xFE)     // Full slots hold 0x00-0x7F
+
+// Interned keys are unique pointers: mix the address so the low 7 bits
+// (control byte) and the rest (probe start) are both well distributed
+static uint64_t table_hash(const char* key) {
+    uint64_t h = (uint64_t)(uintptr_t)key;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    return h;
+}
+
+static int table_ctz(uint32_t mask) {
+#if defined(__GNUC__)
+    return __builtin_ctz(mask);
+#else
+    int bit = 0;
+    while (!(mask & 1)) { mask >>= 1; bit++; }
+    return bit;
+#endif
+}
+
+// Bit i set if group[i] == h2
+static uint32_t group_match(const uint8_t* group, uint8_t h2) {
+#if defined(DO_SIMD_SSE2)
+    __m128i ctrl = _mm_loadu_si128((const __m128i*)(const void*)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)h2)));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < DO_TABLE_GROUP; i++) {
+        if (group[i] == h2) mask |= (uint32_t)1 << i;
+    }
+    return mask;
+#endif
+}
+
+// Bit i set if group[i] is empty or deleted (high bit set)
+static uint32_t group_match_free(const uint8_t* group) {
+#if defined(DO_SIMD_SSE2)
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(const void*)group));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < DO_TABLE_GROUP; i++) {
+        if (group[i] & 0x80) mask |= (uint32_t)1 << i;
+    }
+    return mask;
+#endif
+}
+
+static size_t table_bytes(uint32_t capacity) {
+    size_t ctrl = ((size_t)capacity + DO_TABLE_GROUP + 7) & ~(size_t)7;
+    size_t index = ((size_t)capacity * sizeof(uint32_t) + 7) & ~(size_t)7;
+    size_t entries = (size_t)(capacity - capacity / 8) * sizeof(do_hash_entry_t);
+    return sizeof(do_hash_table_t) + ctrl + index + entries;
+}
+
+// Control bytes are mirrored so a group load starting near the end wraps
+static void table_set_ctrl(do_hash_table_t* table, uint32_t slot, uint8_t value) {
+    uint32_t mask = table->capacity - 1;
+    table->ctrl[slot] = value;
+    table->ctrl[((slot - DO_TABLE_GROUP) & mask) + DO_TABLE_GROUP] = value;
+}
+
+// Slot holding key, or -1
+static int64_t table_find_slot(const do_hash_table_t* table, const char* key) {
+    if (!table) return -1;
+    
+    uint64_t hash = table_hash(key);
+    uint8_t h2 = (uint8_t)(hash & 0x7F);
+    uint32_t mask = table->capacity - 1;
+    uint32_t pos = (uint32_t)(hash >> 7) & mask;
+    
+    // Triangular probing over groups visits every slot of a power-of-two table
+    for (uint32_t step = DO_TABLE_GROUP;; step += DO_TABLE_GROUP) {
+        const uint8_t* group = table->ctrl + pos;
+        for (uint32_t match = group_match(group, h2); match; match &= match - 1) {
+            uint32_t slot = (pos + (uint32_t)table_ctz(match)) & mask;
+            if (table->entries[table->index[slot]].key == key) return slot;
+        }
+        if (group_match(group, DO_CTRL_EMPTY)) return -1;
+        pos = (pos + step) & mask;
+    }
+}
+
+// Link entry `entry` of a table known not to contain key
+static void table_link(do_hash_table_t* table, const char* key, uint32_t entry) {
+    uint64_t hash = table_hash(key);
+    uint32_t mask = table->capacity - 1;
+    uint32_t pos = (uint32_t)(hash >> 7) & mask;
+    
+    for (uint32_t step = DO_TABLE_GROUP;; step += DO_TABLE_GROUP) {
+        uint32_t match = group_match_free(table->ctrl + pos);
+        if (match) {
+            uint32_t slot = (pos + (uint32_t)table_ctz(match)) & mask;
+            if (table->ctrl[slot] == DO_CTRL_EMPTY) table->growth_left--;  // Reusing a deleted slot is free
+            table_set_ctrl(table, slot, (uint8_t)(hash & 0x7F));
+            table->index[slot] = entry;
+            return;
+        }
+        pos = (pos + step) & mask;
+    }
+}
+
+static void table_free(do_object obj, do_hash_table_t* table) {
+    if (table) object_dealloc(obj, table, table_bytes(table->capacity));
+}
+
+// Rebuild *table_ptr (NULL for none yet) with room for `needed` live
+// entries, dropping holes and deleted slots. Values move bytewise.
+static int table_rebuild(do_object obj, do_hash_table_t** table_ptr, uint32_t needed) {
+    do_hash_table_t* old = *table_ptr;
+    
+    // Size for twice the entries so rebuilds amortize over inserts
+    uint32_t capacity = DO_TABLE_MIN_CAPACITY;
+    while (capacity - capacity / 8 < needed * 2) capacity *= 2;
+    
+    size_t bytes = table_bytes(capacity);
+    do_hash_table_t* table = (do_hash_table_t*)object_alloc(obj, bytes);
+    if (!table) return DO_ERROR_MEMORY;
+    
+    size_t ctrl_bytes = ((size_t)capacity + DO_TABLE_GROUP + 7) & ~(size_t)7;
+    table->ctrl = (uint8_t*)(table + 1);
+    table->index = (uint32_t*)(void*)(table->ctrl + ctrl_bytes);
+    table->entries = (do_hash_entry_t*)(void*)((unsigned char*)table->index +
+                                               (((size_t)capacity * sizeof(uint32_t) + 7) & ~(size_t)7));
+    table->capacity = capacity;
+    table->count = 0;
+    table->used = 0;
+    table->entry_capacity = capacity - capacity / 8;
+    table->growth_left = table->entry_capacity;  // At least capacity / 8 slots stay empty
+    memset(table->ctrl, DO_CTRL_EMPTY, (size_t)capacity + DO_TABLE_GROUP);
+    
+    if (old) {
+        for (uint32_t i = 0; i < old->used; i++) {
+            if (!old->entries[i].key) continue;
+            table->entries[table->used] = old->entries[i];
+            table_link(table, old->entries[i].key, table->used);
+            table->used++;
+        }
+        table->count = table->used;
+        table_free(obj, old);
+    }
+    
+    *table_ptr = table;
+    return DO_SUCCESS;
+}
+
+// Make sure *table_ptr has room for `needed` live entries, rebuilding it
+// only when the remaining room falls short
+static int table_reserve(do_object obj, do_hash_table_t** table_ptr, uint32_t needed) {
+    do_hash_table_t* old = *table_ptr;
+    if (old && (needed <= old->count || old->entry_capacity - old->used >= needed - old->count)) {
+        return DO_SUCCESS;
+    }
+    return table_rebuild(obj, table_ptr, needed);
+}
+
+#if DO_INTERN_CONTEXT
+
+// Like shapes, arena objects do not reference their table keys
+// individually: the arena holds one reference per distinct context key
+static void object_key_acquired(do_object obj, const char* key) {
+    do_arena arena = obj->arena;
+    if (arena && key_header(key)->context) {
+        if (arena->keys && hmgeti(arena->keys, key) >= 0) return;
+        hmput(arena->keys, key, 1);
+    }
+    key_retain(key);
+}
+
+#define object_key_released(obj, key) ((obj)->arena ? (void)0 : key_release(key))
+
+#else
+#define object_key_acquired(obj, key) ((void)0)
+#define object_key_released(obj, key) ((void)(obj))
+#endif
+
+// Append an entry for a key not in the table; its value is left for the
+// caller to fill. NULL on allocation failure.
+static do_hash_entry_t* table_insert(do_object obj, do_hash_table_t** table_ptr, const char* key) {
+    do_hash_table_t* table = *table_ptr;
+    if (!table || table->used == table->entry_capacity || table->growth_left == 0) {
+        // Out of entries, or deleted control bytes have taken the free slots
+        if (table_rebuild(obj, table_ptr, table ? table->count + 1 : 1) != DO_SUCCESS) return NULL;
+        table = *table_ptr;
+    }
+    
+    do_hash_entry_t* entry = &table->entries[table->used];
+    entry->key = key;
+    object_key_acquired(obj, key);
+    table_link(table, key, table->used);
+    table->used++;
+    table->count++;
+    return entry;
+}
+
+// Unlink the entry in `slot` of obj's table (its value must already be released)
+static void table_erase_slot(do_object obj, do_hash_table_t* table, uint32_t slot) {
+    object_key_released(obj, table->entries[table->index[slot]].key);
+    table->entries[table->index[slot]].key = NULL;
+    table_set_ctrl(table, slot, DO_CTRL_DELETED);
+    table->count--;
+    
+    // Trailing holes are reclaimed right away
+    while (table->used > 0 && !table->entries[table->used - 1].key) {
+        table->used--;
+    }
+}
+
+static do_property_t* find_hash_property(const do_hash_table_t* table, const char* key) {
+    int64_t slot = table_find_slot(table, key);
+    return slot >= 0 ? &table->entries[table->index[slot]].value : NULL;
+}
+
+// Store data under key (see put_property for data == NULL)
+static int set_hash_property(do_object obj, const char* key, const void* data, size_t size, void** out) {
+    // Check if property already exists
+    do_property_t* existing = find_hash_property(obj->properties.table, key);
+    
+    if (existing) {
+        // Update existing property - release old value
+        return write_property_value(obj, existing, data, size, out);
+    } else {
+        // New property, filled in place
+        do_hash_entry_t* entry = table_insert(obj, &obj->properties.table, key);
+        if (!entry) return DO_ERROR_MEMORY;
+        if (fill_property_value(obj, &entry->value, data, size, out) != DO_SUCCESS) {
+            table_erase_slot(obj, obj->properties.table, (uint32_t)table_find_slot(obj->properties.table, key));
+            return DO_ERROR_MEMORY;
+        }
+        
+        obj->property_count++;
+        note_layout_change(obj);
+        return DO_SUCCESS;
+    }
+}
+
+// Switch an object from shape + slots to dictionary (hash) storage, with
+// room for `expected` properties
+static int upgrade_to_hash(do_object obj, int expected) {
+    if (obj->is_hashed) return DO_SUCCESS;
+    
+    do_shape_t* shape = obj->shape;
+    do_property_t* slots = obj->properties.slots;
+    
+    do_hash_table_t* table = NULL;
+    if (expected < shape->slot_count + 1) expected = shape->slot_count + 1;
+    if (table_reserve(obj, &table, (uint32_t)expected) != DO_SUCCESS) return DO_ERROR_MEMORY;
+    
+    // Move slots to the table - values are copied as-is, so inline values
+    // and heap buffers change owner without reallocation
+    for (int i = 0; i < shape->slot_count; i++) {
+        table_insert(obj, &table, shape->keys[i])->value = slots[i];
+    }
+    
+    object_dealloc(obj, slots, (size_t)obj->slot_capacity * sizeof(do_property_t));
+    object_shape_release(obj, shape);
+    
+    obj->shape = NULL;
+    obj->properties.table = table;
+    obj->slot_capacity = 0;
+    obj->is_hashed = 1;
+    note_layout_change(obj);
+    DO_STAT_ADD(hash_upgrades, 1);
+    return DO_SUCCESS;
+}
+
+// Switch a hashed object back to shape + slots, keys in insertion order.
+// Leaves the object as it was if allocation fails or a shape along the
+// way is megamorphic.
+static int downgrade_to_slots(do_object obj) {
+    if (!obj->is_hashed) return DO_SUCCESS;
+    
+    do_hash_table_t* table = obj->properties.table;
+    int count = obj->property_count;
+    int capacity = 0;
+    do_property_t* slots = NULL;
+    if (count > 0) {
+        capacity = 4;
+        while (capacity < count) capacity *= 2;
+        slots = (do_property_t*)object_alloc(obj, (size_t)capacity * sizeof(do_property_t));
+        if (!slots) return DO_ERROR_MEMORY;
+    }
+    
+    // Values are copied as-is, as in upgrade_to_hash
+    do_shape_t* shape = &g_root_shape;
+    for (uint32_t i = 0, slot = 0; table && i < table->used; i++) {
+        const char* key = table->entries[i].key;
+        if (!key) continue;
+        do_shape_t* next = shape_add_key(shape, key);
+        shape_release(shape);
+        if (!next) {
+            object_dealloc(obj, slots, (size_t)capacity * sizeof(do_property_t));
+            return DO_ERROR_MEMORY;
+        }
+        shape = next;
+        slots[slot++] = table->entries[i].value;
+    }
+    
+    if (table) {
+        for (uint32_t i = 0; i < table->used; i++) {
+            if (table->entries[i].key) object_key_released(obj, table->entries[i].key);
+        }
+        table_free(obj, table);
+    }
+    object_shape_acquired(obj, shape);
+    
+    obj->shape = shape;
+    obj->properties.slots = slots;
+    obj->slot_capacity = capacity;
+    obj->is_hashed = 0;
+    note_layout_change(obj);
+    DO_STAT_ADD(hash_downgrades, 1);
+    return DO_SUCCESS;
+}
+
+// Called after a hashed delete. Objects only leave the table well below
+// DO_HASH_THRESHOLD and tables are only rebuilt smaller once mostly empty,
+// so sizes hovering near either boundary do not rebuild over and over.
+static void shrink_hash_storage(do_object obj) {
+    if (obj->arena) return;  // Replacing storage would only take more of the arena
+    if (obj->property_count <= DO_HASH_DOWNGRADE_THRESHOLD && downgrade_to_slots(obj) == DO_SUCCESS) return;
+    
+    do_hash_table_t* table = obj->properties.table;
+    if (table && table->capacity > DO_TABLE_MIN_CAPACITY && table->count * 8 < table->entry_capacity) {
+        (void)table_rebuild(obj, &obj->properties.table, table->count);  // Keeps the old table on failure
+    }
+}
+
+// Called after a slot delete: halve slot storage once a quarter of it is used
+static void shrink_slots(do_object obj) {
+    int count = obj->shape->slot_count;
+    if (obj->arena || obj->slot_capacity <= 4 || count * 4 > obj->slot_capacity) return;
+    
+    int capacity = obj->slot_capacity / 2;
+    do_property_t* slots = (do_property_t*)object_resize(obj, obj->properties.slots,
+                                                         (size_t)obj->slot_capacity * sizeof(do_property_t),
+                                                         (size_t)capacity * sizeof(do_property_t));
+    if (!slots) return;
+    obj->properties.slots = slots;
+    obj->slot_capacity = capacity;
+}
+
+/* =============================================================================
+ * CONCURRENT OBJECT IMPLEMENTATION
+ * ============================================================================= */
+
+#if DO_CONCURRENT_OBJECTS
+
+// A concurrent object's properties are an immutable version: keys in
+// insertion order, their values and, past DO_HASH_THRESHOLD keys, an
+// open-addressing index. Writers build the next version under the
+// object's lock, publish it with a seq_cst store and retire the old one
+// stamped with a fresh epoch; a retired version is freed once no read
+// section older than its stamp is left. Value buffers are shared by
+// consecutive versions and die with the last one holding them.
+
+typedef struct {
+    void* data;
+    size_t size;
+    int owned;                      // Freed with the version: its successor dropped it
+} do_version_value_t;
+
+typedef struct do_version_t {
+    struct do_version_t* next_retired;
+    uint64_t retired;               // Epoch stamp, set when retired
+    const do_allocator_t* allocator; // NULL for do_alloc
+    void (*release_fn)(void*);
+    size_t bytes;                   // Size of this block
+    int count;
+    uint32_t index_mask;            // Index slots - 1
+    do_version_value_t* values;
+    const char** keys;
+    uint32_t* index;                // Entry + 1 per slot, 0 = empty; NULL for small versions
+} do_version_t;
+
+typedef struct do_concurrent_t {
+    _Atomic(do_version_t*) current;
+    atomic_int write_lock;          // Serializes writers
+} do_concurrent_t;
+
+static do_version_t* g_rcu_retired;  // Guarded by g_rcu_lock
+static atomic_int g_rcu_lock;
+
+#define version_value_bytes(size) ((size) ? (size) : 1)
+
+static void* version_alloc(const do_allocator_t* allocator, size_t size) {
+    return allocator ? allocator_alloc(allocator, size) : do_alloc(size);
+}
+
+static void version_dealloc(const do_allocator_t* allocator, void* ptr, size_t size) {
+    if (allocator) {
+        allocator_free(allocator, ptr, size);
+    } else {
+        do_dealloc(ptr, size);
+    }
+}
+
+// Empty version with room for `capacity` entries
+static do_version_t* version_create(const do_allocator_t* allocator, void (*release_fn)(void*), int capacity) {
+    uint32_t slots = 0;
+    if (capacity > DO_HASH_THRESHOLD) {
+        for (slots = 1; slots < (uint32_t)capacity * 2; slots <<= 1) {
+        }
+    }
+    size_t bytes = sizeof(do_version_t) + (size_t)capacity * (sizeof(do_version_value_t) + sizeof(const char*)) +
+                   slots * sizeof(uint32_t);
+    do_version_t* version = (do_version_t*)version_alloc(allocator, bytes);
+    if (!version) return NULL;
+    
+    version->next_retired = NULL;
+    version->retired = 0;
+    version->allocator = allocator;
+    version->release_fn = release_fn;
+    version->bytes = bytes;
+    version->count = 0;
+    version->index_mask = slots ? slots - 1 : 0;
+    version->values = (do_version_value_t*)(void*)(version + 1);
+    version->keys = (const char**)(void*)(version->values + capacity);
+    version->index = slots ? (uint32_t*)(void*)(version->keys + capacity) : NULL;
+    return version;
+}
+
+static void version_index_insert(do_version_t* version, int entry) {
+    uint32_t i = (uint32_t)table_hash(version->keys[entry]) & version->index_mask;
+    while (version->index[i]) i = (i + 1) & version->index_mask;
+    version->index[i] = (uint32_t)entry + 1;
+}
+
+static void version_build_index(do_version_t* version) {
+    if (!version->index) return;
+    memset(version->index, 0, ((size_t)version->index_mask + 1) * sizeof(uint32_t));
+    for (int i = 0; i < version->count; i++) version_index_insert(version, i);
+}
+
+// Entry of key, or -1. Entries whose key was cleared never match.
+static int version_find(const do_version_t* version, const char* key) {
+    if (!version->index) return find_key_index(version->keys, version->count, key);
+    for (uint32_t i = (uint32_t)table_hash(key) & version->index_mask;; i = (i + 1) & version->index_mask) {
+        uint32_t entry = version->index[i];
+        if (!entry) return -1;
+        if (version->keys[entry - 1] == key) return (int)entry - 1;
+    }
+}
+
+// Whether data is the value old holds for key
+static int version_holds(const do_version_t* old, const char* key, const void* data) {
+    int i = version_find(old, key);
+    return i >= 0 && old->values[i].data == data;
+}
+
+// Release the values the version owns and free it
+static void version_destroy(do_version_t* version) {
+    for (int i = 0; i < version->count; i++) {
+        do_version_value_t* value = &version->values[i];
+        if (!value->owned) continue;
+        if (version->release_fn) version->release_fn(value->data);
+        version_dealloc(version->allocator, value->data, version_value_bytes(value->size));
+    }
+    version_dealloc(version->allocator, version, version->bytes);
+}
+
+// Called after the version was replaced
+static void rcu_retire(do_version_t* version) {
+    version->retired = rcu_advance();
+    do_spin_lock(&g_rcu_lock);
+    version->next_retired = g_rcu_retired;
+    g_rcu_retired = version;
+    do_spin_unlock(&g_rcu_lock);
+}
+
+DO_DEF void do_rcu_read_lock(void) {
+    rcu_enter();
+}
+
+DO_DEF void do_rcu_read_unlock(void) {
+    rcu_exit();
+}
+
+DO_DEF size_t do_rcu_reclaim(void) {
+    uint64_t oldest = rcu_oldest_epoch();
+    
+    do_version_t* expired = NULL;
+    do_spin_lock(&g_rcu_lock);
+    for (do_version_t** link = &g_rcu_retired; *link;) {
+        do_version_t* version = *link;
+        if (version->retired <= oldest) {
+            *link = version->next_retired;
+            version->next_retired = expired;
+            expired = version;
+        } else {
+            link = &version->next_retired;
+        }
+    }
+    do_spin_unlock(&g_rcu_lock);
+    
+    // release_fn runs outside the lock and may itself update concurrent objects
+    size_t freed = 0;
+    while (expired) {
+        do_version_t* next = expired->next_retired;
+        version_destroy(expired);
+        expired = next;
+        freed++;
+    }
+    return freed;
+}
+
+DO_DEF size_t do_rcu_synchronize(void) {
+    DO_ASSERT(g_rcu_depth == 0);
+    
+    uint64_t target = atomic_load(&g_rcu_epoch);
+    while (rcu_oldest_epoch() < target) {
+        DO_CPU_RELAX();
+    }
+    return do_rcu_reclaim();
+}
+
+static do_version_t* current_version(do_object obj) {
+    return atomic_load_explicit(&obj->properties.concurrent->current, memory_order_acquire);
+}
+
+static void* concurrent_find(do_object obj, const char* key) {
+    DO_ASSERT(g_rcu_depth > 0);  // The result is only valid inside the reader's section
+    const do_version_t* version = current_version(obj);
+    int i = version_find(version, key);
+    return i >= 0 ? version->values[i].data : NULL;
+}
+
+// Look every key up in the same version, so the values are from one write
+static int concurrent_get_many(do_object obj, const char* const* keys, void** values, int count) {
+    DO_ASSERT(g_rcu_depth > 0);
+    const do_version_t* version = current_version(obj);
+    int found = 0;
+    for (int i = 0; i < count; i++) {
+        int entry = version_find(version, keys[i]);
+        values[i] = entry >= 0 ? version->values[entry].data : NULL;
+        found += entry >= 0;
+    }
+    return found;
+}
+
+static int concurrent_has(do_object obj, const char* key) {
+    do_rcu_read_lock();
+    int found = concurrent_find(obj, key) != NULL;
+    do_rcu_read_unlock();
+    return found;
+}
+
+// Bytes of obj's state, current version and the values in it
+static size_t concurrent_usage(do_object obj) {
+    do_rcu_read_lock();
+    const do_version_t* version = current_version(obj);
+    size_t total = sizeof(do_concurrent_t) + version->bytes;
+    for (int i = 0; i < version->count; i++) total += version_value_bytes(version->values[i].size);
+    do_rcu_read_unlock();
+    return total;
+}
+
+// Free the values of next that old does not hold (a failed update)
+static void discard_version(do_version_t* next, const do_version_t* old) {
+    for (int i = 0; i < next->count; i++) {
+        void* data = next->values[i].data;
+        if (next->keys[i] && !version_holds(old, next->keys[i], data)) {
+            version_dealloc(next->allocator, data, version_value_bytes(next->values[i].size));
+        }
+    }
+    version_dealloc(next->allocator, next, next->bytes);
+}
+
+// Replace obj's version with one where each keys[i] is set to values[i]
+// (sizes[i] bytes), or deleted when values is NULL. *changed counts the
+// keys set or deleted; nothing is published when it is 0.
+static int concurrent_update(do_object obj, const char* const* keys, const void* const* values,
+                             const size_t* sizes, int count, int* changed) {
+    do_concurrent_t* state = obj->properties.concurrent;
+    *changed = 0;
+    
+    do_spin_lock(&state->write_lock);
+    do_version_t* old = atomic_load_explicit(&state->current, memory_order_relaxed);
+    do_version_t* next = version_create(obj->allocator, obj->release_fn, old->count + (values ? count : 0));
+    if (!next) {
+        do_spin_unlock(&state->write_lock);
+        return DO_ERROR_MEMORY;
+    }
+    next->count = old->count;
+    memcpy(next->keys, old->keys, (size_t)old->count * sizeof(const char*));
+    for (int i = 0; i < old->count; i++) {
+        next->values[i] = old->values[i];
+        next->values[i].owned = 0;
+    }
+    version_build_index(next);
+    
+    // Deleted entries keep their slot with a cleared key until compaction
+    for (int i = 0; i < count; i++) {
+        DO_ASSERT(keys[i] != NULL);
+        int entry = version_find(next, keys[i]);
+        if (entry >= 0) {
+            // A value set earlier in this batch was never published
+            void* data = next->values[entry].data;
+            if (!version_holds(old, keys[i], data)) {
+                if (obj->release_fn) obj->release_fn(data);
+                version_dealloc(obj->allocator, data, version_value_bytes(next->values[entry].size));
+            }
+            next->keys[entry] = values ? keys[i] : NULL;
+        }
+        if (!values) {
+            *changed += entry >= 0;
+            continue;
+        }
+        
+        DO_ASSERT(values[i] != NULL);
+        void* data = version_alloc(obj->allocator, version_value_bytes(sizes[i]));
+        if (!data) {
+            if (entry >= 0) next->keys[entry] = NULL;  // Its value is gone already
+            discard_version(next, old);
+            do_spin_unlock(&state->write_lock);
+            *changed = 0;
+            return DO_ERROR_MEMORY;
+        }
+        memcpy(data, values[i], sizes[i]);
+        if (entry < 0) {
+            entry = next->count++;
+            next->keys[entry] = keys[i];
+            if (next->index) version_index_insert(next, entry);
+        }
+        next->values[entry].data = data;
+        next->values[entry].size = sizes[i];
+        (*changed)++;
+    }
+    
+    if (*changed == 0) {
+        version_dealloc(obj->allocator, next, next->bytes);
+        do_spin_unlock(&state->write_lock);
+        return DO_SUCCESS;
+    }
+    
+    int live = 0;
+    for (int i = 0; i < next->count; i++) {
+        if (!next->keys[i]) continue;
+        next->keys[live] = next->keys[i];
+        next->values[live++] = next->values[i];
+    }
+    next->count = live;
+    version_build_index(next);
+    
+    // Values the new version no longer holds die with the old one. Readers
+    // of old never look at `owned`.
+    for (int i = 0; i < old->count; i++) {
+        old->values[i].owned = !version_holds(next, old->keys[i], old->values[i].data);
+        if (version_find(next, old->keys[i]) < 0) key_release(old->keys[i]);
+    }
+    for (int i = 0; i < next->count; i++) {
+        if (version_find(old, next->keys[i]) < 0) key_retain(next->keys[i]);
+    }
+    
+    atomic_store(&state->current, next);
+    do_spin_unlock(&state->write_lock);
+    
+    rcu_retire(old);
+    do_rcu_reclaim();
+    return DO_SUCCESS;
+}
+
+// Retire the last version of an object being destroyed
+static void free_concurrent_storage(do_object obj) {
+    do_concurrent_t* state = obj->properties.concurrent;
+    do_version_t* version = atomic_load_explicit(&state->current, memory_order_relaxed);
+    for (int i = 0; i < version->count; i++) {
+        version->values[i].owned = 1;
+        key_release(version->keys[i]);
+    }
+    object_dealloc(obj, state, sizeof(do_concurrent_t));
+    rcu_retire(version);
+    do_rcu_reclaim();
+}
+
+#endif
+
+/* =============================================================================
+ * COPY-ON-WRITE STORAGE IMPLEMENTATION
+ * ============================================================================= */
+
+// Clones point at the same slots or hash table, with identical layout
+// fields, and hold one reference each on a shared count. The storage is
+// read-only while shared; writers take a private copy first.
+typedef struct do_share_t {
+    DO_ATOMIC_INT ref_count;
+} do_share_t;
+
+// Release the values and arrays of obj's storage (not its shape)
+static void free_property_storage(do_object obj) {
+#if DO_CONCURRENT_OBJECTS
+    if (object_is_concurrent(obj)) {
+        free_concurrent_storage(obj);
+        return;
+    }
+#endif
+    if (obj->is_hashed) {
+        do_hash_table_t* table = obj->properties.table;
+        if (table) {
+            for (uint32_t i = 0; i < table->used; i++) {
+                if (!table->entries[i].key) continue;
+                release_property_value(obj, &table->entries[i].value);
+                object_key_released(obj, table->entries[i].key);
+            }
+            table_free(obj, table);
+        }
+    } else {
+        for (int i = 0; i < obj->shape->slot_count; i++) {
+            release_property_value(obj, &obj->properties.slots[i]);
+        }
+        object_dealloc(obj, obj->properties.slots, (size_t)obj->slot_capacity * sizeof(do_property_t));
+    }
+}
+
+// Give dst private copies of the values in src's storage; dst must already
+// have src's layout (is_hashed, shape, slot_capacity)
+static int copy_property_storage(do_object dst, const do_object_t* src) {
+    if (src->is_hashed) {
+        const do_hash_table_t* source = src->properties.table;
+        dst->properties.table = NULL;
+        if (!source) return DO_SUCCESS;
+        if (table_reserve(dst, &dst->properties.table, source->count) != DO_SUCCESS) return DO_ERROR_MEMORY;
+        
+        for (uint32_t i = 0; i < source->used; i++) {
+            const do_hash_entry_t* entry = &source->entries[i];
+            if (!entry->key) continue;
+            do_hash_entry_t* copy = table_insert(dst, &dst->properties.table, entry->key);
+            if (copy_property_value(dst, &copy->value, &entry->value) != DO_SUCCESS) {
+                table_erase_slot(dst, dst->properties.table, (uint32_t)table_find_slot(dst->properties.table, entry->key));
+                void (*release_fn)(void*) = dst->release_fn;
+                dst->release_fn = NULL;  // Partial copy: free without releasing
+                free_property_storage(dst);
+                dst->release_fn = release_fn;
+                return DO_ERROR_MEMORY;
+            }
+        }
+        return DO_SUCCESS;
+    }
+    
+    dst->properties.slots = NULL;
+    if (src->slot_capacity == 0) return DO_SUCCESS;
+    
+    do_property_t* slots = (do_property_t*)object_alloc(dst, (size_t)src->slot_capacity * sizeof(do_property_t));
+    if (!slots) return DO_ERROR_MEMORY;
+    for (int i = 0; i < src->shape->slot_count; i++) {
+        do_property_t* prop = &src->properties.slots[i];
+        if (copy_property_value(dst, &slots[i], prop) != DO_SUCCESS) {
+            while (i-- > 0) {
+                release_value_ref(dst, &slots[i]);
+                if (slots[i].size > DO_INLINE_SIZE) {
+                    object_dealloc(dst, slots[i].data.heap.ptr, slots[i].data.heap.capacity);
+                }
+            }
+            object_dealloc(dst, slots, (size_t)src->slot_capacity * sizeof(do_property_t));
+            return DO_ERROR_MEMORY;
+        }
+    }
+    dst->properties.slots = slots;
+    return DO_SUCCESS;
+}
+
+// Drop obj's reference on shared storage. Returns 1 if obj was the last
+// user, which then owns the storage outright.
+static int release_share(do_object obj) {
+    do_share_t* share = obj->share;
+    obj->share = NULL;
+    if (DO_ATOMIC_FETCH_ADD(&share->ref_count, -1) == 1) {
+        object_dealloc(obj, share, sizeof(do_share_t));
+        return 1;
+    }
+    return 0;
+}
+
+// Make obj's storage private before it is modified
+static int unshare_properties(do_object obj) {
+    if (!obj->share) return DO_SUCCESS;
+    
+    // The other clones have already copied or gone away
+    if (DO_ATOMIC_LOAD(&obj->share->ref_count) == 1) {
+        release_share(obj);
+        return DO_SUCCESS;
+    }
+    
+    do_object_t shared = *obj;
+    if (copy_property_storage(obj, &shared) != DO_SUCCESS) return DO_ERROR_MEMORY;
+    
+    // Raced with the remaining clones copying too: the original is ours to free
+    obj->share = shared.share;
+    if (release_share(obj)) {
+        free_property_storage(&shared);
+    }
+    return DO_SUCCESS;
+}
+
+/* =============================================================================
+ * CORE OBJECT IMPLEMENTATION
+ * ============================================================================= */
+
+// Arena and frozen objects ignore reference counting
+#define object_is_immortal(obj) ((obj)->arena || ((obj)->flags & DO_OBJECT_FROZEN))
+
+#if DO_BIASED_REFCOUNT
+
+// Biased reference counting (Choi, Shull and Torrellas): ref_local counts
+// the owner's references with relaxed loads and stores. ref_count holds all
+// other threads' references in units of DO_RC_ONE, plus two flags. Until
+// MERGED is set the shared count may go negative - references the owner
+// took and handed over - and the object lives on the owner's count. The
+// owner merges when its count reaches zero. The release that first takes
+// the shared count negative queues the object for its owner instead
+// (QUEUED), so references moved to other threads cannot strand it. The
+// update that leaves exactly MERGED - no references, not queued - means the
+// object is dead.
+
+#define DO_RC_MERGED 0x1
+#define DO_RC_QUEUED 0x2
+#define DO_RC_ONE    0x4
+
+typedef struct do_brc_thread_t {
+    _Atomic(do_object) queue;           // Objects waiting for this thread to merge
+    atomic_int exited;                  // Set by do_refcount_thread_exit
+    struct do_brc_thread_t* next;
+} do_brc_thread_t;
+
+// Like stats blocks, records are never freed: objects may outlive their thread
+static _Atomic(do_brc_thread_t*) g_brc_threads;
+static DO_THREAD_LOCAL do_brc_thread_t* g_brc_thread;
+
+static do_brc_thread_t* brc_current_thread(void) {
+    if (g_brc_thread) return g_brc_thread;
+    
+    do_brc_thread_t* thread = (do_brc_thread_t*)DO_MALLOC(sizeof(do_brc_thread_t));
+    if (!thread) return NULL;
+    atomic_init(&thread->queue, NULL);
+    atomic_init(&thread->exited, 0);
+    thread->next = atomic_load_explicit(&g_brc_threads, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&g_brc_threads, &thread->next, thread,
+                                                  memory_order_release, memory_order_relaxed)) {
+    }
+    g_brc_thread = thread;
+    return thread;
+}
+
+// One reference, owned by the calling thread when it has a record
+static void init_ref_count(do_object obj, do_brc_thread_t* owner) {
+    obj->owner = owner;
+    obj->next_merge = NULL;
+    atomic_init(&obj->ref_local, owner ? 1 : 0);
+    atomic_init(&obj->ref_count, owner ? 0 : DO_RC_ONE | DO_RC_MERGED);
+}
+
+#define object_ref_count(obj) \
+    (atomic_load_explicit(&(obj)->ref_local, memory_order_relaxed) + \
+     (atomic_load_explicit(&(obj)->ref_count, memory_order_relaxed) & ~(DO_RC_ONE - 1)) / DO_RC_ONE)
+#define object_ref_adjust(obj, n) \
+    ((void)atomic_fetch_add_explicit(&(obj)->ref_count, (n) * DO_RC_ONE, memory_order_relaxed))
+
+#else
+
+#define init_ref_count(obj, owner) DO_ATOMIC_STORE(&(obj)->ref_count, 1)
+#define object_ref_count(obj) DO_ATOMIC_LOAD(&(obj)->ref_count)
+#define object_ref_adjust(obj, n) ((void)DO_ATOMIC_FETCH_ADD(&(obj)->ref_count, n))
+
+#endif
+
+#if DO_CYCLE_COLLECTOR
+
+// Bacon-Rajan colors, kept in the DO_OBJECT_GC_COLOR flag bits
+#define DO_GC_BLACK  0x0  // In use (or not examined)
+#define DO_GC_GRAY   0x2  // Trial-deleted, awaiting scan
+#define DO_GC_WHITE  0x4  // Unreachable from outside the examined graph
+#define DO_GC_PURPLE 0x6  // Count dropped: possible root of a garbage cycle
+
+#define gc_color(obj) ((obj)->flags & DO_OBJECT_GC_COLOR)
+#define gc_set_color(obj, color) ((obj)->flags = ((obj)->flags & ~DO_OBJECT_GC_COLOR) | (color))
+
+static do_object* g_cycle_roots = NULL;  // stb_ds array of candidates
+
+static void gc_remove_root(do_object obj) {
+    do_object last = arrpop(g_cycle_roots);
+    if (last != obj) {
+        g_cycle_roots[obj->gc_root] = last;
+        last->gc_root = obj->gc_root;
+    }
+    obj->gc_root = -1;
+}
+
+// A release left obj alive: it may be the last outside link into a cycle.
+// Objects with no outgoing references cannot be on a cycle.
+static void gc_possible_root(do_object obj) {
+    if (!obj->trace_fn && !obj->prototype && !(obj->flags & DO_OBJECT_VALUE_REFS)) return;
+    if (obj->flags & DO_OBJECT_GC_FREE) return;
+    gc_set_color(obj, DO_GC_PURPLE);
+    if (obj->gc_root < 0) {
+        obj->gc_root = (int)arrlen(g_cycle_roots);
+        arrput(g_cycle_roots, obj);
+    }
+}
+
+#endif
+
+// Allocator for objects created on this thread (see do_set_allocator)
+static DO_THREAD_LOCAL const do_allocator_t* g_allocator;
+
+DO_DEF const do_allocator_t* do_set_allocator(const do_allocator_t* allocator) {
+    const do_allocator_t* previous = g_allocator;
+    g_allocator = allocator;
+    return previous;
+}
+
+// An allocator installed on the thread wins over the bound context's
+#if DO_INTERN_CONTEXT
+#define current_allocator() (g_allocator ? g_allocator : g_context ? g_context->allocator : NULL)
+#else
+#define current_allocator() g_allocator
+#endif
+
+static do_object create_object(void (*release_fn)(void*), const do_allocator_t* allocator) {
+    do_object obj = (do_object)(allocator ? allocator_alloc(allocator, sizeof(do_object_t))
+                                          : do_alloc(sizeof(do_object_t)));
+    if (!obj) return NULL;
+    
+    init_ref_count(obj, brc_current_thread());
+    obj->prototype = NULL;
+    obj->release_fn = release_fn;
+    obj->shape = &g_root_shape;
+    obj->properties.slots = NULL;
+    obj->is_hashed = 0;
+    obj->flags = 0;
+    obj->property_count = 0;
+    obj->slot_capacity = 0;
+    obj->arena = NULL;
+    obj->share = NULL;
+    obj->allocator = allocator;
+#if DO_CYCLE_COLLECTOR
+    obj->trace_fn = NULL;
+    obj->gc_root = -1;
+#endif
+    
+    DO_STAT_ADD(objects_created, 1);
+    DO_STAT_ADD(live_objects, 1);
+    return obj;
+}
+
+DO_DEF do_object do_create(void (*release_fn)(void*)) {
+    return create_object(release_fn, current_allocator());
+}
+
+// Free the header of a heap object from create_object
+static void free_object(do_object obj) {
+    DO_STAT_ADD(objects_destroyed, 1);
+    DO_STAT_SUB(live_objects, 1);
+    object_dealloc(obj, obj, sizeof(do_object_t));
+}
+
+// Reference a prototype or DO_TYPE_OBJ value on behalf of obj. Arena
+// objects share a single reference per heap object, held by the arena
+// until teardown.
+static do_object retain_for(do_object obj, do_object target) {
+    do_arena arena = obj->arena;
+    if (arena && !target->arena) {
+        if (hmgeti(arena->held, target) < 0) {
+            hmput(arena->held, target, 1);
+            do_retain(target);
+        }
+        return target;
+    }
+    return do_retain(target);
+}
+
+static void release_prototype(do_object obj) {
+    if (obj->arena) {
+        obj->prototype = NULL;
+    } else {
+        do_release(&obj->prototype);
+    }
+}
+
+DO_DEF do_object do_create_with_prototype(do_object prototype, void (*release_fn)(void*)) {
+    do_object obj = do_create(release_fn);
+    if (!obj) return NULL;
+    
+    if (prototype) {
+        mark_prototype(prototype);
+        obj->prototype = retain_for(obj, prototype);
+    }
+    
+    return obj;
+}
+
+#if DO_CONCURRENT_OBJECTS
+DO_DEF do_object do_create_concurrent(void (*release_fn)(void*)) {
+    do_object obj = do_create(release_fn);
+    if (!obj) return NULL;
+    
+    do_concurrent_t* state = (do_concurrent_t*)object_alloc(obj, sizeof(do_concurrent_t));
+    do_version_t* version = state ? version_create(obj->allocator, release_fn, 0) : NULL;
+    if (!version) {
+        if (state) object_dealloc(obj, state, sizeof(do_concurrent_t));
+        free_object(obj);
+        return NULL;
+    }
+    atomic_init(&state->current, version);
+    atomic_init(&state->write_lock, 0);
+    obj->properties.concurrent = state;
+    obj->flags |= DO_OBJECT_CONCURRENT;
+    return obj;
+}
+#endif
+
+DO_DEF do_object do_clone(do_object source) {
+    DO_ASSERT(source != NULL);
+    DO_ASSERT(!object_is_concurrent(source));
+    
+    // Shared storage must be freed by the allocator that made it
+    do_object clone = create_object(source->release_fn, source->arena ? current_allocator() : source->allocator);
+    if (!clone) return NULL;
+    
+    clone->is_hashed = source->is_hashed;
+    clone->shape = source->shape;
+#if DO_CYCLE_COLLECTOR
+    clone->trace_fn = source->trace_fn;
+#endif
+    clone->flags |= source->flags & DO_OBJECT_VALUE_REFS;
+    clone->property_count = source->property_count;
+    clone->slot_capacity = source->slot_capacity;
+    
+    if (object_is_immortal(source)) {
+        // Arena storage dies with the arena, and a frozen source is never
+        // written to, so take a private heap copy now
+        if (copy_property_storage(clone, source) != DO_SUCCESS) {
+            free_object(clone);
+            return NULL;
+        }
+    } else {
+        if (!source->share) {
+            do_share_t* share = (do_share_t*)object_alloc(source, sizeof(do_share_t));
+            if (!share) {
+                free_object(clone);
+                return NULL;
+            }
+            DO_ATOMIC_STORE(&share->ref_count, 1);
+            source->share = share;
+        }
+        (void)DO_ATOMIC_FETCH_ADD(&source->share->ref_count, 1);
+        clone->share = source->share;
+        clone->properties = source->properties;
+    }
+    
+    if (!clone->is_hashed) shape_retain(clone->shape);
+    if (source->prototype) {
+        mark_prototype(source->prototype);
+        clone->prototype = retain_for(clone, source->prototype);
+    }
+    return clone;
+}
+
+DO_DEF do_object do_retain(do_object obj) {
+    DO_ASSERT(obj != NULL);
+    if (object_is_immortal(obj)) return obj;  // Lives until its arena is reset or do_frozen_cleanup
+#if DO_BIASED_REFCOUNT
+    if (obj->owner == g_brc_thread) {
+        int local = atomic_load_explicit(&obj->ref_local, memory_order_relaxed);
+        if (local > 0) {
+            atomic_store_explicit(&obj->ref_local, local + 1, memory_order_relaxed);
+            return obj;
+        }
+    }
+    (void)atomic_fetch_add_explicit(&obj->ref_count, DO_RC_ONE, memory_order_relaxed);
+#elif DO_ATOMIC_REFCOUNT
+    // New references are made from existing ones, so nothing to order
+    (void)atomic_fetch_add_explicit(&obj->ref_count, 1, memory_order_relaxed);
+#else
+    DO_ATOMIC_FETCH_ADD_VOID(&obj->ref_count, 1);
+#endif
+    return obj;
+}
+
+static void free_properties(do_object obj) {
+    // Shared storage is freed by the last clone to let go of it
+    if (!obj->share || release_share(obj)) {
+        free_property_storage(obj);
+    }
+    if (!obj->is_hashed) {
+        shape_release(obj->shape);
+    }
+}
+
+// Free an object whose last reference is gone
+static void destroy_object(do_object o) {
+    // Cached lookups may name a prototype by address, which can be
+    // reused after this point
+    if (o->flags & DO_OBJECT_PROTOTYPE) {
+        bump_proto_epoch();
+    }
+    if (o->prototype) {
+        do_release(&o->prototype);
+    }
+    
+    free_properties(o);
+    free_object(o);
+}
+
+#if DO_DEFERRED_RELEASE
+
+// Releasing threads push dead objects onto a shared stack, linked through
+// next_release. A drain moves the whole stack to a private list and works
+// through it; whatever its budget leaves stays there for the next drain.
+// Destroying objects only ever pushes more, so nothing recurses.
+
+#if DO_ATOMIC_REFCOUNT
+static _Atomic(do_object) g_release_queue;
+static atomic_int g_release_lock;  // Owns g_release_pending
+#else
+static do_object g_release_queue;
+#endif
+static do_object g_release_pending;
+
+static void queue_release(do_object obj) {
+#if DO_ATOMIC_REFCOUNT
+    obj->next_release = atomic_load_explicit(&g_release_queue, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&g_release_queue, &obj->next_release, obj,
+                                                  memory_order_release, memory_order_relaxed)) {
+    }
+#else
+    obj->next_release = g_release_queue;
+    g_release_queue = obj;
+#endif
+}
+
+static do_object take_released(void) {
+#if DO_ATOMIC_REFCOUNT
+    return atomic_exchange_explicit(&g_release_queue, NULL, memory_order_acquire);
+#else
+    do_object list = g_release_queue;
+    g_release_queue = NULL;
+    return list;
+#endif
+}
+
+DO_DEF size_t do_drain_releases(size_t budget) {
+    size_t destroyed = 0;
+#if DO_ATOMIC_REFCOUNT
+    do_spin_lock(&g_release_lock);
+#endif
+    while (destroyed < budget) {
+        if (!g_release_pending) {
+            g_release_pending = take_released();
+            if (!g_release_pending) break;
+        }
+        do_object o = g_release_pending;
+        g_release_pending = o->next_release;
+        destroy_object(o);
+        destroyed++;
+    }
+#if DO_ATOMIC_REFCOUNT
+    do_spin_unlock(&g_release_lock);
+#endif
+    return destroyed;
+}
+
+#else
+
+DO_DEF size_t do_drain_releases(size_t budget) {
+    (void)budget;
+    return 0;  // do_release already destroyed everything
+}
+
+#endif // DO_DEFERRED_RELEASE
+
+// The last reference to o is gone
+static void release_dead_object(do_object o) {
+#if DO_CYCLE_COLLECTOR
+    if (o->gc_root >= 0) gc_remove_root(o);
+#endif
+#if DO_DEFERRED_RELEASE
+    queue_release(o);
+#else
+    destroy_object(o);
+#endif
+}
+
+#if DO_BIASED_REFCOUNT
+
+// Fold the owner's count into the shared one, on the owner or on any thread
+// once the owner has exited. Returns 1 if no references are left.
+static int brc_merge(do_object obj, int dequeue) {
+    int local = atomic_load_explicit(&obj->ref_local, memory_order_relaxed);
+    atomic_store_explicit(&obj->ref_local, 0, memory_order_relaxed);
+    
+    int old = atomic_load_explicit(&obj->ref_count, memory_order_relaxed);
+    int word;
+    do {
+        word = (old + local * DO_RC_ONE) | DO_RC_MERGED;
+        if (dequeue) word &= ~DO_RC_QUEUED;
+    } while (!atomic_compare_exchange_weak_explicit(&obj->ref_count, &old, word,
+                                                    memory_order_acq_rel, memory_order_relaxed));
+    return word == DO_RC_MERGED;
+}
+
+static size_t brc_merge_queue(do_brc_thread_t* thread) {
+    do_object list = atomic_exchange(&thread->queue, NULL);
+    size_t merged = 0;
+    while (list) {
+        do_object o = list;
+        list = o->next_merge;
+        if (brc_merge(o, 1)) release_dead_object(o);
+        merged++;
+    }
+    return merged;
+}
+
+static void brc_queue(do_object obj) {
+    do_brc_thread_t* owner = obj->owner;
+    obj->next_merge = atomic_load_explicit(&owner->queue, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak(&owner->queue, &obj->next_merge, obj)) {
+    }
+    // Sequentially consistent with do_refcount_thread_exit: either the
+    // owner's final merge takes this push or this thread sees it exited
+    if (atomic_load(&owner->exited)) brc_merge_queue(owner);
+}
+
+// A release by a thread other than the owner, or after the merge
+static int brc_release_shared(do_object obj) {
+    int old = atomic_load_explicit(&obj->ref_count, memory_order_relaxed);
+    int word;
+    do {
+        word = old - DO_RC_ONE;
+        if (word < 0 && !(word & DO_RC_QUEUED)) word |= DO_RC_QUEUED;
+    } while (!atomic_compare_exchange_weak_explicit(&obj->ref_count, &old, word,
+                                                    memory_order_acq_rel, memory_order_relaxed));
+    if ((word & DO_RC_QUEUED) && !(old & DO_RC_QUEUED)) brc_queue(obj);
+    return word == DO_RC_MERGED;
+}
+
+DO_DEF size_t do_refcount_merge(void) {
+    return g_brc_thread ? brc_merge_queue(g_brc_thread) : 0;
+}
+
+DO_DEF void do_refcount_thread_exit(void) {
+    do_brc_thread_t* thread = g_brc_thread;
+    if (!thread) return;
+    g_brc_thread = NULL;
+    atomic_store(&thread->exited, 1);
+    brc_merge_queue(thread);
+}
+
+#else
+
+DO_DEF size_t do_refcount_merge(void) {
+    return 0;
+}
+
+DO_DEF void do_refcount_thread_exit(void) {
+}
+
+#endif // DO_BIASED_REFCOUNT
+
+// Drop one reference to o; returns 1 if it was the last
+static int release_reference(do_object o) {
+#if DO_BIASED_REFCOUNT
+    if (o->owner == g_brc_thread) {
+        int local = atomic_load_explicit(&o->ref_local, memory_order_relaxed);
+        if (local > 1) {
+            atomic_store_explicit(&o->ref_local, local - 1, memory_order_relaxed);
+            return 0;
+        }
+        if (local == 1) {
+            atomic_store_explicit(&o->ref_local, 0, memory_order_relaxed);
+            return brc_merge(o, 0);
+        }
+    }
+    return brc_release_shared(o);
+#elif DO_ATOMIC_REFCOUNT
+    // Release orders this thread's writes before the free, acquire orders
+    // the free after everyone else's
+    return atomic_fetch_sub_explicit(&o->ref_count, 1, memory_order_acq_rel) == 1;
+#else
+    return DO_ATOMIC_FETCH_ADD(&o->ref_count, -1) == 1;
+#endif
+}
+
+DO_DEF void do_release(do_object* obj) {
+    if (!obj || !*obj) return;
+    
+    do_object o = *obj;
+    *obj = NULL;
+    if (object_is_immortal(o)) return;
+    
+    if (release_reference(o)) {
+        release_dead_object(o);
+    }
+#if DO_CYCLE_COLLECTOR
+    else {
+        gc_possible_root(o);
+    }
+#endif
+#if DO_BIASED_REFCOUNT
+    if (g_brc_thread && atomic_load_explicit(&g_brc_thread->queue, memory_order_relaxed)) {
+        brc_merge_queue(g_brc_thread);
+    }
+#endif
+}
+
+DO_DEF int do_get_ref_count(do_object obj) {
+    DO_ASSERT(obj != NULL);
+    return object_ref_count(obj);
+}
+
+// Frozen heap objects, all destroyed by do_frozen_cleanup
+static do_object* g_frozen = NULL;  // stb_ds array
+#if DO_ATOMIC_REFCOUNT
+static atomic_int g_frozen_lock;
+#endif
+
+static void freeze_object(do_object obj) {
+    if (obj->flags & DO_OBJECT_FROZEN) return;
+#if DO_CYCLE_COLLECTOR
+    // Its count no longer moves, so it can never be found to be garbage
+    if (obj->gc_root >= 0) gc_remove_root(obj);
+    gc_set_color(obj, DO_GC_BLACK);
+#endif
+    // Marked as a prototype up front so becoming one later writes nothing
+    obj->flags |= DO_OBJECT_FROZEN | DO_OBJECT_PROTOTYPE;
+    if (obj->arena) return;
+    
+#if DO_ATOMIC_REFCOUNT
+    do_spin_lock(&g_frozen_lock);
+#endif
+    arrput(g_frozen, obj);
+#if DO_ATOMIC_REFCOUNT
+    do_spin_unlock(&g_frozen_lock);
+#endif
+}
+
+DO_DEF void do_freeze(do_object obj, int flags) {
+    DO_ASSERT(obj != NULL);
+    DO_ASSERT(!object_is_concurrent(obj));
+    freeze_object(obj);
+    if (flags & DO_FREEZE_PROTOTYPES) {
+        for (do_object proto = obj->prototype; proto; proto = proto->prototype) {
+            freeze_object(proto);
+        }
+    }
+}
+
+DO_DEF int do_is_frozen(do_object obj) {
+    DO_ASSERT(obj != NULL);
+    return (obj->flags & DO_OBJECT_FROZEN) != 0;
+}
+
+DO_DEF void do_frozen_cleanup(void) {
+#if DO_ATOMIC_REFCOUNT
+    do_spin_lock(&g_frozen_lock);
+#endif
+    do_object* frozen = g_frozen;
+    g_frozen = NULL;
+#if DO_ATOMIC_REFCOUNT
+    do_spin_unlock(&g_frozen_lock);
+#endif
+    
+    // Drop everything the objects hold before freeing any of them: value
+    // releases may still reach other frozen objects, and see them frozen
+    if (frozen) bump_proto_epoch();
+    for (int i = 0; i < arrlen(frozen); i++) {
+        do_object o = frozen[i];
+        if (o->prototype) do_release(&o->prototype);
+        free_properties(o);
+    }
+    do_drain_releases(SIZE_MAX);
+    for (int i = 0; i < arrlen(frozen); i++) {
+        free_object(frozen[i]);
+    }
+    arrfree(frozen);
+}
+
+/* =============================================================================
+ * PROTOTYPE CHAIN IMPLEMENTATION
+ * ============================================================================= */
+
+DO_DEF int do_set_prototype(do_object obj, do_object prototype) {
+    DO_ASSERT(obj != NULL);
+    DO_ASSERT(!object_is_concurrent(obj));
+    if (obj->flags & DO_OBJECT_FROZEN) return DO_ERROR_FROZEN;
+    
+    if (prototype == NULL) {
+        if (obj->prototype) {
+            release_prototype(obj);
+            note_chain_change(obj);
+        }
+        return DO_SUCCESS;
+    }
+    
+    // Check for cycles
+    do_object current = prototype;
+    while (current != NULL) {
+        if (current == obj) {
+            return DO_ERROR_CYCLE;
+        }
+        current = current->prototype;
+    }
+    
+    // Release old prototype and retain new one
+    if (obj->prototype) {
+        release_prototype(obj);
+    }
+    mark_prototype(prototype);
+    obj->prototype = retain_for(obj, prototype);
+    note_chain_change(obj);
+    
+    return DO_SUCCESS;
+}
+
+DO_DEF do_object do_get_prototype(do_object obj) {
+    DO_ASSERT(obj != NULL);
+    return obj->prototype;
+}
+
+/* =============================================================================
+ * ARENA OBJECT IMPLEMENTATION
+ * ============================================================================= */
+
+DO_DEF do_arena do_arena_create(size_t chunk_size) {
+    if (chunk_size == 0) chunk_size = DO_ARENA_CHUNK_SIZE;
+    
+    do_arena arena = (do_arena)DO_MALLOC(sizeof(struct do_arena_t));
+    if (!arena) return NULL;
+    
+    arena->chunks = arena_new_chunk(chunk_size);
+    if (!arena->chunks) {
+        DO_FREE(arena);
+        return NULL;
+    }
+    arena->chunk_size = chunk_size;
+    arena->shapes = NULL;
+    arena->held = NULL;
+#if DO_INTERN_CONTEXT
+    arena->keys = NULL;
+#endif
+    arena->used_as_prototype = 0;
+#if DO_SNAPSHOT
+    arena->borrowed = NULL;
+    arena->borrowed_size = 0;
+#endif
+    return arena;
+}
+
+DO_DEF do_object do_arena_create_object(do_arena arena, do_object prototype) {
+    DO_ASSERT(arena != NULL);
+    
+    do_object obj = (do_object)arena_alloc(arena, sizeof(do_object_t));
+    if (!obj) return NULL;
+    
+    init_ref_count(obj, NULL);
+    obj->prototype = NULL;
+    obj->release_fn = NULL;
+    obj->shape = &g_root_shape;
+    obj->properties.slots = NULL;
+    obj->is_hashed = 0;
+    obj->flags = 0;
+    obj->property_count = 0;
+    obj->slot_capacity = 0;
+    obj->arena = arena;
+    obj->share = NULL;
+    obj->allocator = NULL;
+#if DO_CYCLE_COLLECTOR
+    obj->trace_fn = NULL;
+    obj->gc_root = -1;
+#endif
+    
+    if (prototype) {
+        mark_prototype(prototype);
+        obj->prototype = retain_for(obj, prototype);
+    }
+    
+    return obj;
+}
+
+// Release everything the arena holds on its objects' behalf
+static void arena_release_resources(do_arena arena) {
+    for (ptrdiff_t i = 0; i < hmlen(arena->shapes); i++) {
+        shape_release(arena->shapes[i].key);
+    }
+    hmfree(arena->shapes);
+    
+    for (ptrdiff_t i = 0; i < hmlen(arena->held); i++) {
+        do_release(&arena->held[i].key);
+    }
+    hmfree(arena->held);
+    
+#if DO_INTERN_CONTEXT
+    for (ptrdiff_t i = 0; i < hmlen(arena->keys); i++) {
+        key_release(arena->keys[i].key);
+    }
+    hmfree(arena->keys);
+#endif
+    
+    // Cached lookups may name arena objects whose addresses get reused
+    if (arena->used_as_prototype) {
+        bump_proto_epoch();
+        arena->used_as_prototype = 0;
+    }
+}
+
+DO_DEF void do_arena_reset(do_arena arena) {
+    DO_ASSERT(arena != NULL);
+    
+    arena_release_resources(arena);
+    
+    // Keep the head chunk (always a regular-sized one) and rewind it
+    do_arena_chunk_t* chunk = arena->chunks->next;
+    while (chunk) {
+        do_arena_chunk_t* next = chunk->next;
+        DO_FREE(chunk);
+        chunk = next;
+    }
+    arena->chunks->next = NULL;
+    arena->chunks->used = 0;
+}
+
+DO_DEF void do_arena_destroy(do_arena* arena) {
+    if (!arena || !*arena) return;
+    
+    do_arena a = *arena;
+    *arena = NULL;
+    
+    arena_release_resources(a);
+    
+    do_arena_chunk_t* chunk = a->chunks;
+    while (chunk) {
+        do_arena_chunk_t* next = chunk->next;
+        DO_FREE(chunk);
+        chunk = next;
+    }
+    DO_FREE(a);
+}
+
+/* =============================================================================
+ * PROPERTY ACCESS IMPLEMENTATION
+ * ============================================================================= */
+
+static void* find_own_property(do_object obj, const char* key) {
+#if DO_CONCURRENT_OBJECTS
+    if (object_is_concurrent(obj)) return concurrent_find(obj, key);
+#endif
+    if (obj->is_hashed) {
+        do_property_t* prop = find_hash_property(obj->properties.table, key);
+        return prop ? property_data(prop) : NULL;
+    } else {
+        int slot = find_shape_slot(obj->shape, key);
+        return slot >= 0 ? property_data(&obj->properties.slots[slot]) : NULL;
+    }
+}
+
+DO_DEF void* do_get(do_object obj, const char* key) {
+    DO_ASSERT(obj != NULL);
+    if (key == NULL) return NULL;  // Handle NULL key gracefully
+    
+    const char* interned_key = do_string_intern(key);
+    if (!interned_key) return NULL;
+    
+    return do_get_interned(obj, interned_key);
+}
+
+// Search the chain starting at `start` (inclusive). Reports the holder and
+// its slot (-1 for hashed holders) so callers can cache the result.
+static void* find_in_chain(do_object start, const char* key, do_object* holder, int* slot) {
+    int levels = 0;
+    for (do_object current = start; current; current = current->prototype) {
+        levels++;
+        if (current->is_hashed) {
+            do_property_t* prop = find_hash_property(current->properties.table, key);
+            if (prop) {
+                DO_STAT_WALK(levels);
+                *holder = current;
+                *slot = -1;
+                return property_data(prop);
+            }
+        } else {
+            int index = find_shape_slot(current->shape, key);
+            if (index >= 0) {
+                DO_STAT_WALK(levels);
+                *holder = current;
+                *slot = index;
+                return property_data(&current->properties.slots[index]);
+            }
+        }
+    }
+    if (levels > 0) DO_STAT_WALK(levels);
+    *holder = NULL;
+    *slot = -1;
+    return NULL;
+}
+
+// Value of a cached (holder, slot) lookup result
+static void* holder_data(do_object holder, const char* key, int slot) {
+    if (!holder) return NULL;
+    if (slot < 0) {
+        do_property_t* prop = find_hash_property(holder->properties.table, key);
+        return prop ? property_data(prop) : NULL;
+    }
+    return property_data(&holder->properties.slots[slot]);
+}
+
+#if DO_PROTO_CACHE_SIZE > 0
+
+typedef struct {
+    do_object start;     // First prototype searched
+    const char* key;
+    do_object holder;    // NULL caches "not found"
+    int slot;
+    uint64_t epoch;
+} proto_cache_entry_t;
+
+// Per-thread, so lookups never contend; validity is tied to the global epoch
+static DO_THREAD_LOCAL proto_cache_entry_t g_proto_cache[DO_PROTO_CACHE_SIZE];
+
+static void* proto_cache_lookup(do_object start, const char* key) {
+    uintptr_t h = ((uintptr_t)start >> 4) ^ ((uintptr_t)key >> 3);
+    proto_cache_entry_t* entry = &g_proto_cache[(h ^ (h >> 11)) & (DO_PROTO_CACHE_SIZE - 1)];
+    uint64_t epoch = proto_epoch();
+    
+    if (entry->epoch == epoch && entry->start == start && entry->key == key) {
+        DO_STAT_ADD(proto_cache_hits, 1);
+        return holder_data(entry->holder, key, entry->slot);
+    }
+    
+    DO_STAT_ADD(proto_cache_misses, 1);
+    void* data = find_in_chain(start, key, &entry->holder, &entry->slot);
+    entry->start = start;
+    entry->key = key;
+    entry->epoch = epoch;
+    return data;
+}
+
+#endif
+
+DO_DEF void* do_get_interned(do_object obj, const char* interned_key) {
+    DO_ASSERT(obj != NULL);
+    DO_ASSERT(interned_key != NULL);
+    
+    DO_STAT_ADD(gets, 1);
+    
+    // Search own properties first
+    void* data = find_own_property(obj, interned_key);
+    if (data || !obj->prototype) {
+        DO_STAT_ADD(get_own_hits, data != NULL);
+        DO_STAT_ADD(get_misses, data == NULL);
+        return data;
+    }
+    
+    // Search prototype chain
+#if DO_PROTO_CACHE_SIZE > 0
+    data = proto_cache_lookup(obj->prototype, interned_key);
+#else
+    do_object holder;
+    int slot;
+    data = find_in_chain(obj->prototype, interned_key, &holder, &slot);
+#endif
+    DO_STAT_ADD(get_proto_hits, data != NULL);
+    DO_STAT_ADD(get_misses, data == NULL);
+    return data;
+}
+
+DO_DEF int do_set(do_object obj, const char* key, const void* data, size_t size) {
+    DO_ASSERT(obj != NULL);
+    DO_ASSERT(key != NULL);
+    DO_ASSERT(data != NULL);
+    
+    const char* interned_key = do_string_intern(key);
+    if (!interned_key) return DO_ERROR_MEMORY;
+    
+    return do_set_interned(obj, interned_key, data, size);
+}
+
+DO_DEF void* do_set_reserve(do_object obj, const char* key, size_t size) {
+    DO_ASSERT(obj != NULL);
+    DO_ASSERT(key != NULL);
+    
+    const char* interned_key = do_string_intern(key);
+    if (!interned_key) return NULL;
+    
+    return do_set_reserve_interned(obj, interned_key, size);
+}
+
+DO_DEF void* do_get_mut(do_object obj, const char* key) {
+    DO_ASSERT(obj != NULL);
+    DO_ASSERT(key != NULL);
+    
+    // A key that was never interned cannot be an own property
+    const char* interned_key = do_string_find_interned(key);
+    if (!interned_key) return NULL;
+    
+    return do_get_mut_interned(obj, interned_key);
+}
+
+// Store a copy of data under key, or with data == NULL make the property
+// `size` bytes of uninitialized storage and return it through out
+static int put_property(do_object obj, const char* interned_key, const void* data, size_t size, void** out) {
+    DO_ASSERT(!object_is_concurrent(obj));  // Values are copied into new versions, never written in place
+    DO_STAT_ADD(sets, 1);
+    if (obj->flags & DO_OBJECT_FROZEN) return DO_ERROR_FROZEN;
+    if (unshare_properties(obj) != DO_SUCCESS) return DO_ERROR_MEMORY;
+    
+    if (obj->is_hashed) {
+        return set_hash_property(obj, interned_key, data, size, out);
+    }
+    
+    // Check if property already exists
+    int slot = find_shape_slot(obj->shape, interned_key);
+    if (slot >= 0) {
+        // Update existing property - release old value
+        return write_property_value(obj, &obj->properties.slots[slot], data, size, out);
+    }
+    
+    // Large objects switch to hash table instead of growing the shape
+    if (obj->property_count > DO_HASH_THRESHOLD) {
+        if (upgrade_to_hash(obj, 0) != DO_SUCCESS) return DO_ERROR_MEMORY;
+        return set_hash_property(obj, interned_key, data, size, out);
+    }
+    
+    // Add new property: transition to the shape with this key appended
+    if (reserve_slots(obj, obj->shape->slot_count + 1) != DO_SUCCESS) return DO_ERROR_MEMORY;
+    
+    do_shape_t* next = shape_add_key(obj->shape, interned_key);
+    if (!next) {
+        // Megamorphic (or out of memory) - fall back to dictionary mode
+        if (upgrade_to_hash(obj, 0) != DO_SUCCESS) return DO_ERROR_MEMORY;
+        return set_hash_property(obj, interned_key, data, size, out);
+    }
+    
+    if (fill_property_value(obj, &obj->properties.slots[obj->shape->slot_count], data, size, out) != DO_SUCCESS) {
+        shape_release(next);
+        return DO_ERROR_MEMORY;
+    }
+    
+    object_shape_release(obj, obj->shape);
+    object_shape_acquired(obj, next);
+    obj->shape = next;
+    obj->property_count++;
+    note_layout_change(obj);
+    
+    return DO_SUCCESS;
+}
+
+DO_DEF int do_set_interned(do_object obj, const char* interned_key, const void* data, size_t size) {
+    DO_ASSERT(obj != NULL);
+    DO_ASSERT(interned_key != NULL);
+    DO_ASSERT(data != NULL);
+    
+#if DO_CONCURRENT_OBJECTS
+    if (object_is_concurrent(obj)) {
+        int changed;
+        DO_STAT_ADD(sets, 1);
+        return concurrent_update(obj, &interned_key, &data, &size, 1, &changed);
+    }
+#endif
+    return put_property(obj, interned_key, data, size, NULL);
+}
+
+DO_DEF void* do_set_reserve_interned(do_object obj, const char* interned_key, size_t size) {
+    DO_ASSERT(obj != NULL);
+    DO_ASSERT(interned_key != NULL);
     
-    size_t hash = do_hash_string(str);
-    int len = arrlen(g_intern_table);
+    void* storage = NULL;
+    if (put_property(obj, interned_key, NULL, size, &storage) != DO_SUCCESS) return NULL;
+    return storage;
+}
+
+DO_DEF void* do_get_mut_interned(do_object obj, const char* interned_key) {
+    DO_ASSERT(obj != NULL);
+    DO_ASSERT(interned_key != NULL);
+    DO_ASSERT(!object_is_concurrent(obj));
     
-    for (int i = 0; i < len; i++) {
-        if (g_intern_table[i].hash == hash && strcmp(g_intern_table[i].str, str) == 0) {
-            return g_intern_table[i].str;
-        }
+    if (obj->flags & DO_OBJECT_FROZEN) return NULL;
+    if (obj->share && find_own_property(obj, interned_key)) {
+        if (unshare_properties(obj) != DO_SUCCESS) return NULL;
     }
+    return find_own_property(obj, interned_key);
+}
+
+DO_DEF int do_has(do_object obj, const char* key) {
+    DO_ASSERT(obj != NULL);
+    if (key == NULL) return 0;  // Handle NULL key gracefully
     
-    return NULL;
+    const char* interned_key = do_string_intern(key);
+    if (!interned_key) return 0;
+    
+    return do_has_interned(obj, interned_key);
 }
 
-DO_DEF void do_string_intern_cleanup(void) {
-    if (g_intern_table) {
-        int len = arrlen(g_intern_table);
-        for (int i = 0; i < len; i++) {
-            DO_FREE(g_intern_table[i].str);
-        }
-        arrfree(g_intern_table);
-        g_intern_table = NULL;
+DO_DEF int do_has_interned(do_object obj, const char* interned_key) {
+    DO_ASSERT(obj != NULL);
+    DO_ASSERT(interned_key != NULL);
+    
+#if DO_CONCURRENT_OBJECTS
+    if (object_is_concurrent(obj)) return concurrent_has(obj, interned_key);
+#endif
+    return do_get_interned(obj, interned_key) != NULL;
+}
+
+DO_DEF int do_has_own(do_object obj, const char* key) {
+    DO_ASSERT(obj != NULL);
+    DO_ASSERT(key != NULL);
+    
+    const char* interned_key = do_string_intern(key);
+    if (!interned_key) return 0;
+    
+#if DO_CONCURRENT_OBJECTS
+    if (object_is_concurrent(obj)) return concurrent_has(obj, interned_key);
+#endif
+    return find_own_property(obj, interned_key) != NULL;
+}
+
+DO_DEF int do_delete(do_object obj, const char* key) {
+    DO_ASSERT(obj != NULL);
+    if (key == NULL) return 0;  // Handle NULL key gracefully
+    
+    const char* interned_key = do_string_intern(key);
+    if (!interned_key) return 0;
+    
+    return do_delete_interned(obj, interned_key);
+}
+
+// Shape for the current layout with slot `removed` taken out, rebuilt by
+// replaying the remaining keys from the root. NULL if a step fails.
+static do_shape_t* shape_without_slot(const do_shape_t* shape, int removed) {
+    do_shape_t* result = &g_root_shape;
+    for (int i = 0; i < shape->slot_count; i++) {
+        if (i == removed) continue;
+        do_shape_t* next = shape_add_key(result, shape->keys[i]);
+        shape_release(result);
+        if (!next) return NULL;
+        result = next;
     }
+    return result;
 }
 
-#endif // DO_STRING_INTERNING
+static int delete_hash_property(do_object obj, const char* interned_key) {
+    do_hash_table_t* table = obj->properties.table;
+    int64_t slot = table_find_slot(table, interned_key);
+    if (slot < 0) return 0;
+    
+    // Found - delete it
+    release_property_value(obj, &table->entries[table->index[slot]].value);
+    table_erase_slot(obj, table, (uint32_t)slot);
+    obj->property_count--;
+    note_layout_change(obj);
+    return 1;
+}
+
+DO_DEF int do_delete_interned(do_object obj, const char* interned_key) {
+    DO_ASSERT(obj != NULL);
+    DO_ASSERT(interned_key != NULL);
+    
+    if (obj->flags & DO_OBJECT_FROZEN) return 0;
+#if DO_CONCURRENT_OBJECTS
+    if (object_is_concurrent(obj)) {
+        int deleted;
+        if (concurrent_update(obj, &interned_key, NULL, NULL, 1, &deleted) != DO_SUCCESS) return 0;
+        return deleted;
+    }
+#endif
+    if (obj->share) {
+        if (!find_own_property(obj, interned_key)) return 0;
+        if (unshare_properties(obj) != DO_SUCCESS) return 0;
+    }
+    
+    if (obj->is_hashed) {
+        int deleted = delete_hash_property(obj, interned_key);
+        if (deleted) shrink_hash_storage(obj);
+        return deleted;
+    }
+    
+    do_shape_t* shape = obj->shape;
+    int slot = find_shape_slot(shape, interned_key);
+    if (slot < 0) return 0;
+    
+    // Removing the newest key steps back to the parent shape; removing any
+    // other key re-derives the shape of the remaining keys in order
+    do_shape_t* next;
+    if (slot == shape->slot_count - 1) {
+        next = shape->parent;
+        shape_retain(next);
+    } else {
+        next = shape_without_slot(shape, slot);
+        if (!next) {
+            if (upgrade_to_hash(obj, 0) != DO_SUCCESS) return 0;
+            return delete_hash_property(obj, interned_key);
+        }
+    }
+    
+    // Found - delete it
+    do_property_t* slots = obj->properties.slots;
+    release_property_value(obj, &slots[slot]);
+    memmove(&slots[slot], &slots[slot + 1], (size_t)(shape->slot_count - slot - 1) * sizeof(do_property_t));
+    
+    object_shape_acquired(obj, next);
+    obj->shape = next;
+    object_shape_release(obj, shape);
+    obj->property_count--;
+    note_layout_change(obj);
+    shrink_slots(obj);
+    return 1;
+}
 
 /* =============================================================================
- * PROPERTY STORAGE IMPLEMENTATION (using dynamic arrays)
+ * TYPED VALUE IMPLEMENTATION
  * ============================================================================= */
 
-// Find property in linear array  
-static do_property_t* find_linear_property(do_property_t* props, const char* key) {
-    if (!props) return NULL;
+#if DO_TAGGED_VALUES
+
+static do_property_t* find_own_property_value(do_object obj, const char* key) {
+    DO_ASSERT(!object_is_concurrent(obj));  // Versions store no type tags
+    if (obj->is_hashed) return find_hash_property(obj->properties.table, key);
+    int slot = find_shape_slot(obj->shape, key);
+    return slot >= 0 ? &obj->properties.slots[slot] : NULL;
+}
+
+// Nearest property named key along the chain, or NULL
+static do_property_t* find_chain_property_value(do_object obj, const char* key) {
+    DO_ASSERT(obj != NULL);
+    DO_ASSERT(key != NULL);
     
-    int len = arrlen(props);
-    for (int i = 0; i < len; i++) {
-        if (props[i].key == key) {  // Pointer equality for interned strings
-            return &props[i];
-        }
+    for (do_object current = obj; current; current = current->prototype) {
+        do_property_t* prop = find_own_property_value(current, key);
+        if (prop) return prop;
     }
     return NULL;
 }
 
-// Hash table optimization using interned string keys for maximum performance
-#define PROPERTY_HASH(p) ((uintptr_t)(p.key) >> 3)  // Fast pointer-based hash
-#define PROPERTY_EQUAL(a,b) ((a.key) == (b.key))   // Pointer equality for interned strings
+static const do_property_t* find_typed_value(do_object obj, const char* key, int type) {
+    const do_property_t* prop = find_chain_property_value(obj, key);
+    return prop && prop->type == (uint32_t)type ? prop : NULL;
+}
 
-// Hash map property access using stb_ds
-static do_property_t* find_hash_property(do_hash_entry_t* props, const char* key) {
-    if (!props) return NULL;
+// Store 8 bytes of payload inline, tagged with type
+static int set_typed_value(do_object obj, const char* interned_key, int type, const void* payload) {
+    DO_ASSERT(obj != NULL);
+    DO_ASSERT(interned_key != NULL);
+    
+    void* storage = NULL;
+    int result = put_property(obj, interned_key, NULL, 8, &storage);
+    if (result != DO_SUCCESS) return result;
+    memcpy(storage, payload, 8);
     
-    // Use stb_ds hash map get - returns pointer to the hash entry
-    do_hash_entry_t* entry = hmgetp_null(props, key);
-    return entry ? &entry->value : NULL;
+    // Inline storage is part of the property itself
+    do_property_t* prop = (do_property_t*)(void*)((unsigned char*)storage - offsetof(do_property_t, data));
+    prop->type = (uint32_t)type;
+    return DO_SUCCESS;
 }
 
-static int set_hash_property(do_object obj, const char* key, const void* data, size_t size) {
-    // Check if property already exists
-    do_property_t* existing = find_hash_property(obj->properties.hash_props, key);
+DO_DEF int do_set_i64(do_object obj, const char* interned_key, int64_t value) {
+    return set_typed_value(obj, interned_key, DO_TYPE_I64, &value);
+}
+
+DO_DEF int do_set_f64(do_object obj, const char* interned_key, double value) {
+    return set_typed_value(obj, interned_key, DO_TYPE_F64, &value);
+}
+
+DO_DEF int do_set_ptr(do_object obj, const char* interned_key, void* value) {
+    return set_typed_value(obj, interned_key, DO_TYPE_PTR, &value);
+}
+
+DO_DEF int do_set_obj(do_object obj, const char* interned_key, do_object value) {
+    // Retain first: the value being replaced may hold the last reference
+    if (value) retain_for(obj, value);
+    int result = set_typed_value(obj, interned_key, DO_TYPE_OBJ, &value);
+    if (result != DO_SUCCESS) {
+        if (value && !obj->arena) do_release(&value);  // An arena keeps its reference
+        return result;
+    }
+    obj->flags |= DO_OBJECT_VALUE_REFS;
+    return DO_SUCCESS;
+}
+
+DO_DEF int do_get_i64(do_object obj, const char* interned_key, int64_t* value) {
+    DO_ASSERT(value != NULL);
+    const do_property_t* prop = find_typed_value(obj, interned_key, DO_TYPE_I64);
+    if (!prop) return 0;
+    memcpy(value, prop->data.bytes, sizeof(*value));
+    return 1;
+}
+
+DO_DEF int do_get_f64(do_object obj, const char* interned_key, double* value) {
+    DO_ASSERT(value != NULL);
+    const do_property_t* prop = find_typed_value(obj, interned_key, DO_TYPE_F64);
+    if (!prop) return 0;
+    memcpy(value, prop->data.bytes, sizeof(*value));
+    return 1;
+}
+
+DO_DEF void* do_get_ptr(do_object obj, const char* interned_key) {
+    const do_property_t* prop = find_typed_value(obj, interned_key, DO_TYPE_PTR);
+    return prop ? *(void* const*)(const void*)prop->data.bytes : NULL;
+}
+
+DO_DEF do_object do_get_obj(do_object obj, const char* interned_key) {
+    const do_property_t* prop = find_typed_value(obj, interned_key, DO_TYPE_OBJ);
+    return prop ? property_object(prop) : NULL;
+}
+
+DO_DEF int do_get_type(do_object obj, const char* interned_key) {
+    const do_property_t* prop = find_chain_property_value(obj, interned_key);
+    return prop ? (int)prop->type : DO_TYPE_NONE;
+}
+
+#endif // DO_TAGGED_VALUES
+
+/* =============================================================================
+ * INLINE CACHE IMPLEMENTATION
+ * ============================================================================= */
+
+#if DO_STRING_INTERNING
+
+DO_DEF void* do_get_cached(do_object obj, const char* interned_key, do_ic_t* ic) {
+    DO_ASSERT(obj != NULL);
+    DO_ASSERT(interned_key != NULL);
+    DO_ASSERT(ic != NULL);
     
-    if (existing) {
-        // Update existing property - release old value
-        if (obj->release_fn && existing->data) {
-            obj->release_fn(existing->data);
+#if DO_CONCURRENT_OBJECTS
+    // Concurrent objects have no slots to cache
+    if (object_is_concurrent(obj)) return do_get_interned(obj, interned_key);
+#endif
+    
+    // A matching receiver shape proves the receiver stores the key in the
+    // cached slot (own entry) or lacks it (inherited entry); the epoch then
+    // vouches for everything from the prototype up
+    if (ic->key == interned_key && !obj->is_hashed && obj->shape->id == ic->shape_id) {
+        if (!ic->holder) {
+            ic->hits++;
+            DO_STAT_ADD(ic_hits, 1);
+            return property_data(&obj->properties.slots[ic->slot]);
         }
-        if (existing->data) {
-            DO_FREE(existing->data);
+        if (obj->prototype == ic->start && ic->epoch == proto_epoch()) {
+            ic->hits++;
+            DO_STAT_ADD(ic_hits, 1);
+            return holder_data(ic->holder, interned_key, ic->slot);
         }
-        
-        existing->data = DO_MALLOC(size);
-        if (!existing->data) return DO_ERROR_MEMORY;
-        
-        memcpy(existing->data, data, size);
-        existing->size = size;
-        return DO_SUCCESS;
-    } else {
-        // New property
-        do_property_t new_prop;
-        new_prop.key = key;
-        new_prop.data = DO_MALLOC(size);
-        if (!new_prop.data) return DO_ERROR_MEMORY;
-        
-        memcpy(new_prop.data, data, size);
-        new_prop.size = size;
-        
-        do_hash_entry_t new_entry = { key, new_prop };
-        hmput(obj->properties.hash_props, key, new_entry.value);
-        obj->property_count++;
-        return DO_SUCCESS;
     }
-}
-
-static void upgrade_to_hash(do_object obj) {
-    if (obj->is_hashed) return;
     
-    do_property_t* linear_props = obj->properties.linear_props;
-    if (!linear_props) return;
+    ic->misses++;
+    DO_STAT_ADD(ic_misses, 1);
+    ic->key = NULL;
     
-    int len = arrlen(linear_props);
-    if (len <= DO_HASH_THRESHOLD) return;
+    if (obj->is_hashed) {
+        return do_get_interned(obj, interned_key);
+    }
     
-    // Initialize empty stb_ds hash map
-    obj->properties.hash_props = NULL;
-    obj->is_hashed = 1;
-    obj->property_count = 0;  // Reset count, will be rebuilt during migration
-    
-    // Move properties to hash table
-    for (int i = 0; i < len; i++) {
-        do_property_t* prop = &linear_props[i];
-        if (set_hash_property(obj, prop->key, prop->data, prop->size) != DO_SUCCESS) {
-            // Failed to migrate - restore linear
-            hmfree(obj->properties.hash_props);
-            obj->is_hashed = 0;
-            obj->properties.linear_props = linear_props;
-            obj->property_count = len;  // Restore original count
-            return;
-        }
-        // Don't free the data here as it was moved to hash table
-        prop->data = NULL;
+    int slot = find_shape_slot(obj->shape, interned_key);
+    if (slot >= 0) {
+        ic->key = interned_key;
+        ic->shape_id = obj->shape->id;
+        ic->holder = NULL;
+        ic->slot = slot;
+        return property_data(&obj->properties.slots[slot]);
+    }
+    
+    uint64_t epoch = proto_epoch();
+    do_object holder;
+    void* data = find_in_chain(obj->prototype, interned_key, &holder, &slot);
+    if (holder) {
+        ic->key = interned_key;
+        ic->shape_id = obj->shape->id;
+        ic->start = obj->prototype;
+        ic->holder = holder;
+        ic->slot = slot;
+        ic->epoch = epoch;
+    }
+    return data;
+}
+
+DO_DEF int do_set_cached(do_object obj, const char* interned_key, const void* data, size_t size, do_ic_t* ic) {
+    DO_ASSERT(obj != NULL);
+    DO_ASSERT(interned_key != NULL);
+    DO_ASSERT(data != NULL);
+    DO_ASSERT(ic != NULL);
+    
+#if DO_CONCURRENT_OBJECTS
+    if (object_is_concurrent(obj)) return do_set_interned(obj, interned_key, data, size);
+#endif
+    if (ic->key == interned_key && !ic->holder && !obj->is_hashed && obj->shape->id == ic->shape_id) {
+        if (obj->flags & DO_OBJECT_FROZEN) return DO_ERROR_FROZEN;
+        if (unshare_properties(obj) != DO_SUCCESS) return DO_ERROR_MEMORY;
+        ic->hits++;
+        DO_STAT_ADD(ic_hits, 1);
+        return replace_property_value(obj, &obj->properties.slots[ic->slot], data, size);
     }
     
-    // Successfully migrated - free the linear array
-    arrfree(linear_props);
+    ic->misses++;
+    DO_STAT_ADD(ic_misses, 1);
+    int result = do_set_interned(obj, interned_key, data, size);
+    if (result == DO_SUCCESS && !obj->is_hashed) {
+        ic->key = interned_key;
+        ic->shape_id = obj->shape->id;
+        ic->holder = NULL;
+        ic->slot = find_shape_slot(obj->shape, interned_key);
+    }
+    return result;
 }
 
 /* =============================================================================
- * CORE OBJECT IMPLEMENTATION
+ * BATCH IMPLEMENTATION
  * ============================================================================= */
 
-DO_DEF do_object do_create(void (*release_fn)(void*)) {
-    do_object obj = (do_object)DO_MALLOC(sizeof(do_object_t));
-    if (!obj) return NULL;
+// Room for `count` own properties in the storage a shape-mode object with
+// that many keys would end up in, so it skips the interim upgrade
+static int reserve_properties(do_object obj, int count) {
+    if (obj->is_hashed) return table_reserve(obj, &obj->properties.table, (uint32_t)count);
     
-    DO_ATOMIC_STORE(&obj->ref_count, 1);
-    obj->prototype = NULL;
-    obj->release_fn = release_fn;
-    obj->properties.linear_props = NULL;
-    obj->is_hashed = 0;
-    obj->property_count = 0;
+    // Past DO_HASH_THRESHOLD + 1 keys a shape-mode object upgrades on the
+    // next insert, so decide up front
+    if (count > DO_HASH_THRESHOLD + 1) return upgrade_to_hash(obj, count);
+    return reserve_slots(obj, count);
+}
+
+DO_DEF int do_reserve_properties(do_object obj, int count) {
+    DO_ASSERT(obj != NULL);
+    DO_ASSERT(count >= 0);
     
-    return obj;
+    if (obj->flags & DO_OBJECT_FROZEN) return DO_ERROR_FROZEN;
+    if (object_is_concurrent(obj)) return DO_SUCCESS;  // Every write sizes its own version
+    if (count <= obj->property_count) return DO_SUCCESS;
+    if (unshare_properties(obj) != DO_SUCCESS) return DO_ERROR_MEMORY;
+    return reserve_properties(obj, count);
 }
 
-DO_DEF do_object do_create_with_prototype(do_object prototype, void (*release_fn)(void*)) {
-    do_object obj = do_create(release_fn);
-    if (!obj) return NULL;
+DO_DEF int do_set_many(do_object obj, const char* const* interned_keys, const void* const* values,
+                       const size_t* sizes, int count) {
+    DO_ASSERT(obj != NULL);
+    DO_ASSERT(count == 0 || (interned_keys && values && sizes));
     
-    if (prototype) {
-        obj->prototype = do_retain(prototype);
+    if (obj->flags & DO_OBJECT_FROZEN) return DO_ERROR_FROZEN;
+#if DO_CONCURRENT_OBJECTS
+    if (object_is_concurrent(obj)) {
+        // The whole batch becomes visible at once, in one new version
+        int changed;
+        DO_STAT_ADD(sets, count);
+        return concurrent_update(obj, interned_keys, values, sizes, count, &changed);
     }
+#endif
+    if (unshare_properties(obj) != DO_SUCCESS) return DO_ERROR_MEMORY;
     
-    return obj;
+    int added = count;
+    if (!obj->is_hashed) {
+        added = 0;
+        for (int i = 0; i < count; i++) {
+            if (find_shape_slot(obj->shape, interned_keys[i]) < 0) added++;
+        }
+    }
+    if (reserve_properties(obj, obj->property_count + added) != DO_SUCCESS) return DO_ERROR_MEMORY;
+    
+    for (int i = 0; i < count; i++) {
+        DO_ASSERT(values[i] != NULL);
+        int result = put_property(obj, interned_keys[i], values[i], sizes[i], NULL);
+        if (result != DO_SUCCESS) return result;
+    }
+    return DO_SUCCESS;
 }
 
-DO_DEF do_object do_retain(do_object obj) {
+DO_DEF int do_get_many(do_object obj, const char* const* interned_keys, void** values, int count) {
     DO_ASSERT(obj != NULL);
-#if DO_ATOMIC_REFCOUNT
-    (void)DO_ATOMIC_FETCH_ADD(&obj->ref_count, 1);
-#else
-    DO_ATOMIC_FETCH_ADD_VOID(&obj->ref_count, 1);
+    DO_ASSERT(count == 0 || (interned_keys && values));
+    
+#if DO_CONCURRENT_OBJECTS
+    if (object_is_concurrent(obj)) return concurrent_get_many(obj, interned_keys, values, count);
 #endif
-    return obj;
+    int found = 0;
+    for (int i = 0; i < count; i++) {
+        values[i] = do_get_interned(obj, interned_keys[i]);
+        if (values[i]) found++;
+    }
+    return found;
 }
 
-static void free_properties(do_object obj) {
-    if (obj->is_hashed) {
-        if (obj->properties.hash_props) {
-            // Free each property's data using stb_ds hash map
-            for (int i = 0; i < hmlen(obj->properties.hash_props); i++) {
-                do_property_t* prop = &obj->properties.hash_props[i].value;
-                if (prop->data) {
-                    if (obj->release_fn) {
-                        obj->release_fn(prop->data);
-                    }
-                    DO_FREE(prop->data);
-                }
-            }
-            hmfree(obj->properties.hash_props);
-        }
-    } else {
-        if (obj->properties.linear_props) {
-            int len = arrlen(obj->properties.linear_props);
-            for (int i = 0; i < len; i++) {
-                do_property_t* prop = &obj->properties.linear_props[i];
-                if (prop->data) {
-                    if (obj->release_fn) {
-                        obj->release_fn(prop->data);
-                    }
-                    DO_FREE(prop->data);
-                }
-            }
-            arrfree(obj->properties.linear_props);
-        }
+// Shape for the current layout without the slots set in `removed`,
+// replayed from the root like shape_without_slot. NULL if a step fails.
+static do_shape_t* shape_without_slots(const do_shape_t* shape, uint64_t removed) {
+    do_shape_t* result = &g_root_shape;
+    for (int i = 0; i < shape->slot_count; i++) {
+        if (removed & ((uint64_t)1 << i)) continue;
+        do_shape_t* next = shape_add_key(result, shape->keys[i]);
+        shape_release(result);
+        if (!next) return NULL;
+        result = next;
     }
+    return result;
 }
 
-DO_DEF void do_release(do_object* obj) {
-    if (!obj || !*obj) return;
+DO_DEF int do_delete_many(do_object obj, const char* const* interned_keys, int count) {
+    DO_ASSERT(obj != NULL);
+    DO_ASSERT(count == 0 || interned_keys);
     
-    do_object o = *obj;
-    *obj = NULL;
+    if (obj->flags & DO_OBJECT_FROZEN) return 0;
+#if DO_CONCURRENT_OBJECTS
+    if (object_is_concurrent(obj)) {
+        int deleted;
+        if (concurrent_update(obj, interned_keys, NULL, NULL, count, &deleted) != DO_SUCCESS) return 0;
+        return deleted;
+    }
+#endif
+    if (unshare_properties(obj) != DO_SUCCESS) return 0;
     
-    int old_count = DO_ATOMIC_FETCH_ADD(&o->ref_count, -1);
-    if (old_count == 1) {
-        // Last reference - cleanup
-        if (o->prototype) {
-            do_release(&o->prototype);
+    int deleted = 0;
+    do_shape_t* shape = obj->shape;
+    
+    // Hashed objects delete in place; layouts too wide for the slot mask
+    // take the one-at-a-time path
+    if (obj->is_hashed || shape->slot_count > 64) {
+        for (int i = 0; i < count; i++) {
+            deleted += do_delete_interned(obj, interned_keys[i]);
+        }
+        return deleted;
+    }
+    
+    uint64_t removed = 0;
+    for (int i = 0; i < count; i++) {
+        int slot = find_shape_slot(shape, interned_keys[i]);
+        if (slot >= 0 && !(removed & ((uint64_t)1 << slot))) {
+            removed |= (uint64_t)1 << slot;
+            deleted++;
+        }
+    }
+    if (deleted == 0) return 0;
+    
+    do_shape_t* next = shape_without_slots(shape, removed);
+    if (!next) {
+        if (upgrade_to_hash(obj, 0) != DO_SUCCESS) return 0;
+        for (int i = 0; i < count; i++) {
+            delete_hash_property(obj, interned_keys[i]);
+        }
+        return deleted;
+    }
+    
+    // Release the removed values and compact the survivors in slot order
+    do_property_t* slots = obj->properties.slots;
+    int kept = 0;
+    for (int i = 0; i < shape->slot_count; i++) {
+        if (removed & ((uint64_t)1 << i)) {
+            release_property_value(obj, &slots[i]);
+        } else {
+            slots[kept++] = slots[i];
         }
-        
-        free_properties(o);
-        DO_FREE(o);
     }
+    
+    object_shape_acquired(obj, next);
+    obj->shape = next;
+    object_shape_release(obj, shape);
+    obj->property_count -= deleted;
+    note_layout_change(obj);
+    shrink_slots(obj);
+    return deleted;
 }
 
-DO_DEF int do_get_ref_count(do_object obj) {
-    DO_ASSERT(obj != NULL);
-    return DO_ATOMIC_LOAD(&obj->ref_count);
-}
+#endif // DO_STRING_INTERNING
 
 /* =============================================================================
- * PROTOTYPE CHAIN IMPLEMENTATION
+ * CYCLE COLLECTOR IMPLEMENTATION
  * ============================================================================= */
 
-DO_DEF int do_set_prototype(do_object obj, do_object prototype) {
-    DO_ASSERT(obj != NULL);
+#if DO_CYCLE_COLLECTOR
+
+// Synchronous trial deletion (Bacon & Rajan, "Concurrent Cycle Collection
+// in Reference Counted Systems", 2001), run one buffered candidate at a
+// time so steps can stop between candidates. For a candidate:
+//   mark gray    - subtract every reference internal to its reachable graph
+//   scan         - objects left with a count are externally referenced: they
+//                  and everything they reach are restored (black); the rest
+//                  are white
+//   collect      - white objects get their internal references back and are
+//                  then cleared together, so their release_fn and prototype
+//                  releases drop the references the ordinary way
+// A traversal always finishes, leaving every examined object black or
+// freed, so nothing carries over between steps but the candidate buffer.
+// Graphs are walked with explicit stacks; long chains do not recurse.
+// Storage shared by do_clone is not traced: its references are owned once
+// for all sharers, so they count as external and keep their targets alive.
+
+typedef struct {
+    do_object* stack;     // stb_ds array of objects to process
+    size_t work;          // Objects visited so far in this step
+} gc_state_t;
+
+// References in one value: DO_TYPE_OBJ values directly, untyped ones
+// through the trace_fn
+static void gc_trace_value(do_object obj, do_property_t* prop, do_visit_fn visit, gc_state_t* gc) {
+#if DO_TAGGED_VALUES
+    if (prop->type != DO_TYPE_BYTES) {
+        if (prop->type == DO_TYPE_OBJ && property_object(prop)) visit(property_object(prop), gc);
+        return;
+    }
+#endif
+    if (obj->trace_fn) obj->trace_fn(property_data(prop), prop->size, visit, gc);
+}
+
+static void gc_trace_children(do_object obj, do_visit_fn visit, gc_state_t* gc) {
+    if (obj->prototype) visit(obj->prototype, gc);
+    if (!(obj->trace_fn || (obj->flags & DO_OBJECT_VALUE_REFS)) || obj->share) return;
     
-    if (prototype == NULL) {
-        if (obj->prototype) {
-            do_release(&obj->prototype);
+    if (obj->is_hashed) {
+        do_hash_table_t* table = obj->properties.table;
+        for (uint32_t i = 0; table && i < table->used; i++) {
+            if (table->entries[i].key) gc_trace_value(obj, &table->entries[i].value, visit, gc);
+        }
+    } else {
+        for (int i = 0; i < obj->shape->slot_count; i++) {
+            gc_trace_value(obj, &obj->properties.slots[i], visit, gc);
         }
-        return DO_SUCCESS;
     }
-    
-    // Check for cycles
-    do_object current = prototype;
-    while (current != NULL) {
-        if (current == obj) {
-            return DO_ERROR_CYCLE;
+}
+
+static void gc_push(gc_state_t* gc, do_object obj) {
+    arrput(gc->stack, obj);
+}
+
+static void gc_visit_mark_gray(do_object child, void* context) {
+    if (!child || object_is_immortal(child)) return;
+    object_ref_adjust(child, -1);
+    if (gc_color(child) != DO_GC_GRAY) {
+        gc_set_color(child, DO_GC_GRAY);
+        gc_push((gc_state_t*)context, child);
+    }
+}
+
+static void gc_visit_scan_black(do_object child, void* context) {
+    if (!child || object_is_immortal(child)) return;
+    object_ref_adjust(child, 1);
+    if (gc_color(child) != DO_GC_BLACK) {
+        gc_set_color(child, DO_GC_BLACK);
+        gc_push((gc_state_t*)context, child);
+    }
+}
+
+static void gc_visit_scan(do_object child, void* context) {
+    if (!child || object_is_immortal(child)) return;
+    if (gc_color(child) == DO_GC_GRAY) gc_push((gc_state_t*)context, child);
+}
+
+static void gc_visit_collect(do_object child, void* context) {
+    if (!child || object_is_immortal(child)) return;
+    object_ref_adjust(child, 1);
+    if (gc_color(child) == DO_GC_WHITE && !(child->flags & DO_OBJECT_GC_FREE)) {
+        gc_push((gc_state_t*)context, child);
+    }
+}
+
+// Pop until the stack is back at `base`, calling visit on the children of each
+static void gc_drain(gc_state_t* gc, size_t base, do_visit_fn visit) {
+    while ((size_t)arrlen(gc->stack) > base) {
+        do_object obj = arrpop(gc->stack);
+        gc->work++;
+        gc_trace_children(obj, visit, gc);
+    }
+}
+
+static void gc_mark_gray(gc_state_t* gc, do_object root) {
+    gc_set_color(root, DO_GC_GRAY);
+    gc_push(gc, root);
+    gc_drain(gc, 0, gc_visit_mark_gray);
+}
+
+static void gc_scan(gc_state_t* gc, do_object root) {
+    gc_push(gc, root);
+    while (arrlen(gc->stack) > 0) {
+        do_object obj = arrpop(gc->stack);
+        if (gc_color(obj) != DO_GC_GRAY) continue;  // Reached twice
+        gc->work++;
+        if (object_ref_count(obj) > 0) {
+            // Externally referenced: restore it and everything it reaches,
+            // above the objects still waiting to be scanned
+            size_t base = (size_t)arrlen(gc->stack);
+            gc_set_color(obj, DO_GC_BLACK);
+            gc_push(gc, obj);
+            gc_drain(gc, base, gc_visit_scan_black);
+        } else {
+            gc_set_color(obj, DO_GC_WHITE);
+            gc_trace_children(obj, gc_visit_scan, gc);
         }
-        current = current->prototype;
     }
+}
+
+// Gather the white objects reachable from root, giving back the references
+// they hold (internal and to live objects) so clearing can drop them normally
+static do_object* gc_collect_white(gc_state_t* gc, do_object root) {
+    do_object* garbage = NULL;
+    if (gc_color(root) != DO_GC_WHITE) return NULL;
+    
+    gc_push(gc, root);
+    while (arrlen(gc->stack) > 0) {
+        do_object obj = arrpop(gc->stack);
+        if (obj->flags & DO_OBJECT_GC_FREE) continue;  // Reached twice
+        gc->work++;
+        obj->flags |= DO_OBJECT_GC_FREE;
+        if (obj->gc_root >= 0) gc_remove_root(obj);
+        arrput(garbage, obj);
+        gc_trace_children(obj, gc_visit_collect, gc);
+    }
+    return garbage;
+}
+
+// Drop the properties and prototype of a garbage object, leaving it empty
+static void gc_clear(do_object obj) {
+    note_layout_change(obj);
+    free_properties(obj);
+    obj->shape = &g_root_shape;
+    obj->properties.slots = NULL;
+    obj->is_hashed = 0;
+    obj->property_count = 0;
+    obj->slot_capacity = 0;
+    if (obj->prototype) release_prototype(obj);
+}
+
+DO_DEF void do_set_trace_fn(do_object obj, do_trace_fn trace_fn) {
+    DO_ASSERT(obj != NULL);
+    obj->trace_fn = trace_fn;
+}
+
+DO_DEF size_t do_collect_cycles(size_t budget) {
+    gc_state_t gc = { NULL, 0 };
+    size_t freed = 0;
     
-    // Release old prototype and retain new one
-    if (obj->prototype) {
-        do_release(&obj->prototype);
+    while (arrlen(g_cycle_roots) > 0 && gc.work < budget) {
+        do_object root = arrpop(g_cycle_roots);
+        root->gc_root = -1;
+        if (gc_color(root) != DO_GC_PURPLE) continue;  // Proven live since buffered
+        
+        gc_mark_gray(&gc, root);
+        gc_scan(&gc, root);
+        do_object* garbage = gc_collect_white(&gc, root);
+        
+        // Every reference is back in place: hold one more on each object so
+        // none is freed before all are cleared, then let them go
+        for (int i = 0; i < arrlen(garbage); i++) do_retain(garbage[i]);
+        for (int i = 0; i < arrlen(garbage); i++) gc_clear(garbage[i]);
+        for (int i = 0; i < arrlen(garbage); i++) {
+            DO_ASSERT(object_ref_count(garbage[i]) == 1);
+            do_release(&garbage[i]);
+        }
+        freed += (size_t)arrlen(garbage);
+        arrfree(garbage);
     }
-    obj->prototype = do_retain(prototype);
     
-    return DO_SUCCESS;
+    arrfree(gc.stack);
+    if (arrlen(g_cycle_roots) == 0) arrfree(g_cycle_roots);
+    return freed;
 }
 
-DO_DEF do_object do_get_prototype(do_object obj) {
-    DO_ASSERT(obj != NULL);
-    return obj->prototype;
+DO_DEF size_t do_cycle_candidates(void) {
+    return (size_t)arrlen(g_cycle_roots);
 }
 
+#endif // DO_CYCLE_COLLECTOR
+
 /* =============================================================================
- * PROPERTY ACCESS IMPLEMENTATION
+ * INTERN CONTEXT IMPLEMENTATION
  * ============================================================================= */
 
-static void* find_own_property(do_object obj, const char* key) {
-    if (obj->is_hashed) {
-        do_property_t* prop = find_hash_property(obj->properties.hash_props, key);
-        return prop ? prop->data : NULL;
-    } else {
-        do_property_t* prop = find_linear_property(obj->properties.linear_props, key);
-        return prop ? prop->data : NULL;
+#if DO_INTERN_CONTEXT
+
+DO_DEF do_context do_context_create(const do_allocator_t* allocator) {
+    do_context ctx = (do_context)DO_MALLOC(sizeof(struct do_context_t));
+    if (!ctx) return NULL;
+    
+    atomic_init(&ctx->table, NULL);
+    atomic_init(&ctx->erasing, 0);
+    atomic_init(&ctx->sweeps, 0);
+    ctx->allocator = allocator;
+    atomic_init(&ctx->lock, 0);
+    ctx->key_count = 0;
+    ctx->key_bytes = 0;
+    ctx->keys_reclaimed = 0;
+    ctx->retired = NULL;
+    ctx->swept = NULL;
+    return ctx;
+}
+
+// Free the superseded tables stamped `oldest` or earlier
+static void free_context_tables(do_context ctx, uint64_t oldest) {
+    for (context_table_t** link = &ctx->retired; *link;) {
+        context_table_t* table = *link;
+        if (table->retired_epoch <= oldest) {
+            *link = table->retired;
+            DO_FREE(table);
+        } else {
+            link = &table->retired;
+        }
     }
 }
 
-DO_DEF void* do_get(do_object obj, const char* key) {
-    DO_ASSERT(obj != NULL);
-    if (key == NULL) return NULL;  // Handle NULL key gracefully
-    
-    const char* interned_key = do_string_intern(key);
-    if (!interned_key) return NULL;
-    
-    return do_get_interned(obj, interned_key);
+// Free the condemned strings stamped `oldest` or earlier
+static size_t free_swept_strings(do_context ctx, uint64_t oldest) {
+    size_t count = 0;
+    for (context_swept_t** link = &ctx->swept; *link;) {
+        context_swept_t* swept = *link;
+        if (swept->epoch <= oldest) {
+            *link = swept->next;
+            for (size_t i = 0; i < swept->count; i++) intern_free_string(swept->keys[i]);
+            count += swept->count;
+            DO_FREE(swept);
+        } else {
+            link = &swept->next;
+        }
+    }
+    return count;
 }
 
-DO_DEF void* do_get_interned(do_object obj, const char* interned_key) {
-    DO_ASSERT(obj != NULL);
-    DO_ASSERT(interned_key != NULL);
+DO_DEF void do_context_destroy(do_context* ctx) {
+    if (!ctx || !*ctx) return;
     
-    // Search own properties first
-    void* data = find_own_property(obj, interned_key);
-    if (data) return data;
+    do_context c = *ctx;
+    *ctx = NULL;
+    if (g_context == c) g_context = NULL;
     
-    // Search prototype chain
-    do_object current = obj->prototype;
-    while (current) {
-        data = find_own_property(current, interned_key);
-        if (data) return data;
-        current = current->prototype;
+    context_table_t* table = atomic_load_explicit(&c->table, memory_order_relaxed);
+    for (size_t i = 0; table && i < table->capacity; i++) {
+        char* key = atomic_load_explicit(&table->slots[i].str, memory_order_relaxed);
+        if (!key) continue;
+        DO_ASSERT(atomic_load_explicit(&key_header(key)->refs, memory_order_relaxed) == 0);
+        intern_free_string(key);
     }
+    size_t swept = free_swept_strings(c, UINT64_MAX);
     
-    return NULL;  // Not found
+    // Cached lookups may name freed keys whose addresses get reused
+    if (c->key_count > 0 || swept > 0) bump_proto_epoch();
+    DO_FREE(table);
+    free_context_tables(c, UINT64_MAX);
+    DO_FREE(c);
 }
 
-DO_DEF int do_set(do_object obj, const char* key, const void* data, size_t size) {
-    DO_ASSERT(obj != NULL);
-    DO_ASSERT(key != NULL);
-    DO_ASSERT(data != NULL);
-    
-    const char* interned_key = do_string_intern(key);
-    if (!interned_key) return DO_ERROR_MEMORY;
-    
-    return do_set_interned(obj, interned_key, data, size);
+DO_DEF do_context do_context_bind(do_context ctx) {
+    do_context previous = g_context;
+    g_context = ctx;
+    return previous;
 }
 
-DO_DEF int do_set_interned(do_object obj, const char* interned_key, const void* data, size_t size) {
-    DO_ASSERT(obj != NULL);
-    DO_ASSERT(interned_key != NULL);
-    DO_ASSERT(data != NULL);
+DO_DEF size_t do_context_sweep(do_context ctx) {
+    DO_ASSERT(ctx != NULL);
     
-    if (obj->is_hashed) {
-        return set_hash_property(obj, interned_key, data, size);
-    } else {
-        // Check if we need to upgrade to hash table first
-        if (obj->property_count >= DO_HASH_THRESHOLD) {
-            upgrade_to_hash(obj);
-            if (obj->is_hashed) {
-                return set_hash_property(obj, interned_key, data, size);
-            }
-        }
-        
-        // Use linear storage
-        // properties.linear_props is a stb_ds array, no need to initialize
-        
-        // Check if property already exists
-        int len = arrlen(obj->properties.linear_props);
+    do_spin_lock(&ctx->lock);
+    
+    // Earlier sweeps' leftovers that no read section can still reach
+    uint64_t oldest = rcu_oldest_epoch();
+    size_t released = free_swept_strings(ctx, oldest);
+    free_context_tables(ctx, oldest);
+    
+    size_t interval = atomic_fetch_add_explicit(&ctx->sweeps, 1, memory_order_relaxed);
+    context_table_t* table = atomic_load_explicit(&ctx->table, memory_order_relaxed);
+    context_swept_t* swept = NULL;
+    size_t freed = 0;
+    if (table && ctx->key_count > 0) {
+        swept = (context_swept_t*)DO_MALLOC(sizeof(context_swept_t) + ctx->key_count * sizeof(char*));
+    }
+    if (swept) {
+        unsigned erasing = atomic_load_explicit(&ctx->erasing, memory_order_relaxed);
+        atomic_store_explicit(&ctx->erasing, erasing + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
         
-        for (int i = 0; i < len; i++) {
-            do_property_t* prop = &obj->properties.linear_props[i];
-            if (prop->key == interned_key) {
-                // Update existing property - release old value
-                if (obj->release_fn && prop->data) {
-                    obj->release_fn(prop->data);
-                }
-                if (prop->data) {
-                    DO_FREE(prop->data);
+        // Erasing can move a later entry into slot i, so look at it again
+        for (size_t i = 0; i < table->capacity;) {
+            char* key = atomic_load_explicit(&table->slots[i].str, memory_order_relaxed);
+            do_key_header_t* header = key ? key_header(key) : NULL;
+            size_t seen = header ? atomic_load_explicit(&header->last_sweep, memory_order_relaxed) : 0;
+            int condemned = 0;
+            // Not interned since the last sweep, nor by a lookup that saw this one start
+            while (header && seen != interval && seen != interval + 1 &&
+                   atomic_load_explicit(&header->refs, memory_order_acquire) == 0) {
+                if (atomic_compare_exchange_weak_explicit(&header->last_sweep, &seen, DO_KEY_SWEPT,
+                                                          memory_order_relaxed, memory_order_relaxed)) {
+                    condemned = 1;
+                    break;
                 }
-                
-                prop->data = DO_MALLOC(size);
-                if (!prop->data) return DO_ERROR_MEMORY;
-                
-                memcpy(prop->data, data, size);
-                prop->size = size;
-                return DO_SUCCESS;
             }
+            if (!condemned) {
+                i++;
+                continue;
+            }
+            
+            ctx->key_count--;
+            ctx->key_bytes -= header->length + 1;
+            context_erase_slot(table, i);
+            swept->keys[freed++] = key;
         }
+        atomic_store_explicit(&ctx->erasing, erasing + 2, memory_order_release);
         
-        // Add new property
-        do_property_t new_prop;
-        new_prop.key = interned_key;
-        new_prop.data = DO_MALLOC(size);
-        if (!new_prop.data) return DO_ERROR_MEMORY;
-        
-        memcpy(new_prop.data, data, size);
-        new_prop.size = size;
-        
-        arrput(obj->properties.linear_props, new_prop);
-        obj->property_count++;
-        
-        return DO_SUCCESS;
+        if (freed > 0) {
+            swept->epoch = rcu_advance();
+            swept->count = freed;
+            swept->next = ctx->swept;
+            ctx->swept = swept;
+        } else {
+            DO_FREE(swept);
+        }
     }
-}
-
-DO_DEF int do_has(do_object obj, const char* key) {
-    DO_ASSERT(obj != NULL);
-    if (key == NULL) return 0;  // Handle NULL key gracefully
+    ctx->keys_reclaimed += freed;
     
-    const char* interned_key = do_string_intern(key);
-    if (!interned_key) return 0;
-    
-    return do_has_interned(obj, interned_key);
+    do_spin_unlock(&ctx->lock);
+    if (released > 0) bump_proto_epoch();
+    return freed;
 }
 
-DO_DEF int do_has_interned(do_object obj, const char* interned_key) {
-    DO_ASSERT(obj != NULL);
-    DO_ASSERT(interned_key != NULL);
+DO_DEF void do_context_stats(do_context ctx, do_context_stats_t* stats) {
+    DO_ASSERT(ctx != NULL);
+    DO_ASSERT(stats != NULL);
     
-    return do_get_interned(obj, interned_key) != NULL;
+    do_spin_lock(&ctx->lock);
+    stats->keys = ctx->key_count;
+    stats->key_bytes = ctx->key_bytes;
+    stats->keys_reclaimed = ctx->keys_reclaimed;
+    stats->sweeps = atomic_load_explicit(&ctx->sweeps, memory_order_relaxed);
+    do_spin_unlock(&ctx->lock);
 }
 
-DO_DEF int do_has_own(do_object obj, const char* key) {
-    DO_ASSERT(obj != NULL);
-    DO_ASSERT(key != NULL);
-    
-    const char* interned_key = do_string_intern(key);
-    if (!interned_key) return 0;
-    
-    return find_own_property(obj, interned_key) != NULL;
+#endif // DO_INTERN_CONTEXT
+
+/* =============================================================================
+ * SNAPSHOT IMPLEMENTATION
+ * ============================================================================= */
+
+#if DO_SNAPSHOT
+
+#if !DO_STRING_INTERNING
+#error "DO_SNAPSHOT requires DO_STRING_INTERNING"
+#endif
+
+#include <stdio.h>
+#if defined(__unix__) || defined(__APPLE__)
+#define DO_SNAPSHOT_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// File layout, every offset from the start of the file:
+//   header, string offsets (uint64 each), object records, property records,
+//   root indices (uint32 each), NUL-terminated strings, value bytes
+// Objects are numbered so every prototype precedes the objects inheriting
+// from it; values start on DO_SNAPSHOT_ALIGN boundaries.
+
+#define DO_SNAPSHOT_MAGIC "DOSNAP1"
+#define DO_SNAPSHOT_BYTE_ORDER 0x01020304u
+#define DO_SNAPSHOT_ALIGN 16
+
+typedef struct {
+    char magic[8];
+    uint32_t byte_order;            // DO_SNAPSHOT_BYTE_ORDER in the writer's byte order
+    uint32_t string_count;
+    uint32_t object_count;
+    uint32_t property_count;
+    uint32_t root_count;
+    uint32_t reserved;
+    uint64_t strings;
+    uint64_t objects;
+    uint64_t properties;
+    uint64_t roots;
+    uint64_t size;                  // Length of the whole file
+} do_snapshot_header_t;
+
+typedef struct {
+    uint32_t prototype;             // Object index + 1, 0 for none
+    uint32_t first_property;
+    uint32_t property_count;
+    uint32_t reserved;
+} do_snapshot_object_t;
+
+typedef struct {
+    uint32_t key;                   // String index
+    uint32_t type;                  // DO_TYPE_BYTES, DO_TYPE_I64 or DO_TYPE_F64
+    uint64_t size;
+    uint64_t data;                  // Offset of the value bytes
+} do_snapshot_property_t;
+
+struct do_snapshot_t {
+    do_arena arena;                 // Holds every object
+    do_object* roots;
+    int root_count;
+    const unsigned char* image;     // The file, read-only; heap-sized values point into it
+    size_t image_size;
+};
+
+#define snapshot_align(offset) (((offset) + DO_SNAPSHOT_ALIGN - 1) & ~(uint64_t)(DO_SNAPSHOT_ALIGN - 1))
+
+// Scalar tags survive the round trip; pointer and object values load as bytes
+static uint32_t snapshot_value_type(do_object obj, const char* key) {
+#if DO_TAGGED_VALUES
+    uint32_t type = find_own_property_value(obj, key)->type;
+    return type == DO_TYPE_I64 || type == DO_TYPE_F64 ? type : DO_TYPE_BYTES;
+#else
+    (void)obj;
+    (void)key;
+    return DO_TYPE_BYTES;
+#endif
 }
 
-DO_DEF int do_delete(do_object obj, const char* key) {
-    DO_ASSERT(obj != NULL);
-    if (key == NULL) return 0;  // Handle NULL key gracefully
+DO_DEF int do_snapshot_write(const char* path, const do_object* roots, int count) {
+    DO_ASSERT(path != NULL);
+    DO_ASSERT(count == 0 || roots != NULL);
     
-    const char* interned_key = do_string_intern(key);
-    if (!interned_key) return 0;
+    struct { do_object key; uint32_t value; }* numbers = NULL;      // stb_ds map: object -> index
+    struct { const char* key; uint32_t value; }* key_numbers = NULL; // stb_ds map: key -> index
+    do_object* objects = NULL;
+    do_object* chain = NULL;
+    const char** strings = NULL;
+    do_snapshot_object_t* records = NULL;
+    do_snapshot_property_t* properties = NULL;
+    const void** values = NULL;
+    uint32_t* root_numbers = NULL;
+#if DO_CONCURRENT_OBJECTS
+    // Values of concurrent objects are read from their current version,
+    // which must stay alive until they are copied into the image
+    do_rcu_read_lock();
+#endif
     
-    return do_delete_interned(obj, interned_key);
-}
-
-DO_DEF int do_delete_interned(do_object obj, const char* interned_key) {
-    DO_ASSERT(obj != NULL);
-    DO_ASSERT(interned_key != NULL);
+    // Number each root after the unnumbered part of its prototype chain
+    for (int i = 0; i < count; i++) {
+        DO_ASSERT(roots[i] != NULL);
+        for (do_object o = roots[i]; o && hmgeti(numbers, o) < 0; o = o->prototype) arrput(chain, o);
+        while (arrlen(chain) > 0) {
+            do_object o = arrpop(chain);
+            hmput(numbers, o, (uint32_t)arrlen(objects));
+            arrput(objects, o);
+        }
+        arrput(root_numbers, hmget(numbers, roots[i]));
+    }
     
-    if (obj->is_hashed) {
-        if (!obj->properties.hash_props) return 0;
+    uint64_t data_size = 0;
+    for (int i = 0; i < arrlen(objects); i++) {
+        do_object o = objects[i];
+        do_snapshot_object_t record = { 0, (uint32_t)arrlen(properties), 0, 0 };
+        if (o->prototype) record.prototype = hmget(numbers, o->prototype) + 1;
         
-        // Find and delete from stb_ds hash map
-        do_hash_entry_t* entry = hmgetp_null(obj->properties.hash_props, interned_key);
-        if (entry) {
-            // Found - delete it
-            do_property_t* prop = &entry->value;
-            if (obj->release_fn && prop->data) {
-                obj->release_fn(prop->data);
-            }
-            if (prop->data) {
-                DO_FREE(prop->data);
+        // Concurrent objects have no iterator; their version lists the keys
+#if DO_CONCURRENT_OBJECTS
+        const do_version_t* version = object_is_concurrent(o) ? current_version(o) : NULL;
+#endif
+        do_iter_t it;
+        if (!object_is_concurrent(o)) do_iter_init(&it, o, DO_ITER_OWN);
+        for (int entry = 0;; entry++) {
+            const char* key;
+            const void* value;
+            size_t size;
+            uint32_t type = DO_TYPE_BYTES;
+#if DO_CONCURRENT_OBJECTS
+            if (version) {
+                if (entry == version->count) break;
+                key = version->keys[entry];
+                value = version->values[entry].data;
+                size = version->values[entry].size;
+            } else
+#endif
+            {
+                if (!do_iter_next(&it)) break;
+                key = it.key;
+                value = it.value;
+                size = it.size;
+                type = snapshot_value_type(o, key);
             }
             
-            hmdel(obj->properties.hash_props, interned_key);
-            obj->property_count--;
-            return 1;
-        }
-        
-        return 0;
-    } else {
-        if (!obj->properties.linear_props) return 0;
-        
-        int len = arrlen(obj->properties.linear_props);
-        
-        for (int i = 0; i < len; i++) {
-            do_property_t* prop = &obj->properties.linear_props[i];
-            if (prop->key == interned_key) {
-                // Found - delete it
-                if (obj->release_fn && prop->data) {
-                    obj->release_fn(prop->data);
-                }
-                if (prop->data) {
-                    DO_FREE(prop->data);
-                }
-                
-                // Remove from array
-                arrdel(obj->properties.linear_props, i);
-                obj->property_count--;
-                return 1;
+            if (hmgeti(key_numbers, key) < 0) {
+                hmput(key_numbers, key, (uint32_t)arrlen(strings));
+                arrput(strings, key);
             }
+            data_size = snapshot_align(data_size);
+            do_snapshot_property_t property = { hmget(key_numbers, key), type, size, data_size };
+            arrput(properties, property);
+            arrput(values, value);
+            data_size += size;
+            record.property_count++;
         }
-        
-        return 0;
+        arrput(records, record);
+    }
+    
+    do_snapshot_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DO_SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.byte_order = DO_SNAPSHOT_BYTE_ORDER;
+    header.string_count = (uint32_t)arrlen(strings);
+    header.object_count = (uint32_t)arrlen(objects);
+    header.property_count = (uint32_t)arrlen(properties);
+    header.root_count = (uint32_t)count;
+    header.strings = sizeof(header);
+    header.objects = header.strings + header.string_count * sizeof(uint64_t);
+    header.properties = header.objects + header.object_count * sizeof(do_snapshot_object_t);
+    header.roots = header.properties + header.property_count * sizeof(do_snapshot_property_t);
+    uint64_t text = header.roots + header.root_count * sizeof(uint32_t);
+    uint64_t data = text;
+    for (int i = 0; i < arrlen(strings); i++) data += do_interned_length(strings[i]) + 1;
+    data = snapshot_align(data);
+    header.size = data + data_size;
+    
+    int result = DO_ERROR_MEMORY;
+    unsigned char* image = (unsigned char*)DO_MALLOC((size_t)header.size);
+    if (image) {
+        memset(image, 0, (size_t)header.size);
+        memcpy(image, &header, sizeof(header));
+        uint64_t* string_offsets = (uint64_t*)(image + header.strings);
+        for (int i = 0; i < arrlen(strings); i++) {
+            size_t length = do_interned_length(strings[i]) + 1;
+            string_offsets[i] = text;
+            memcpy(image + text, strings[i], length);
+            text += length;
+        }
+        for (int i = 0; i < arrlen(properties); i++) {
+            properties[i].data += data;
+            memcpy(image + properties[i].data, values[i], (size_t)properties[i].size);
+        }
+        if (records) memcpy(image + header.objects, records, arrlen(records) * sizeof(*records));
+        if (properties) memcpy(image + header.properties, properties, arrlen(properties) * sizeof(*properties));
+        if (root_numbers) memcpy(image + header.roots, root_numbers, arrlen(root_numbers) * sizeof(*root_numbers));
+    }
+#if DO_CONCURRENT_OBJECTS
+    do_rcu_read_unlock();
+#endif
+    
+    if (image) {
+        FILE* file = fopen(path, "wb");
+        result = DO_ERROR_IO;
+        if (file) {
+            size_t written = fwrite(image, 1, (size_t)header.size, file);
+            if (fclose(file) == 0 && written == header.size) result = DO_SUCCESS;
+        }
+        DO_FREE(image);
+    }
+    
+    hmfree(numbers);
+    hmfree(key_numbers);
+    arrfree(objects);
+    arrfree(chain);
+    arrfree(strings);
+    arrfree(records);
+    arrfree(properties);
+    arrfree(values);
+    arrfree(root_numbers);
+    return result;
+}
+
+// The whole file, read-only; NULL if it cannot be read
+static const unsigned char* snapshot_open(const char* path, size_t* size) {
+#if DO_SNAPSHOT_MMAP
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat info;
+    void* image = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        *size = (size_t)info.st_size;
+        image = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
     }
+    close(fd);
+    return image == MAP_FAILED ? NULL : (const unsigned char*)image;
+#else
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+    unsigned char* image = NULL;
+    long length = 0;
+    if (fseek(file, 0, SEEK_END) == 0 && (length = ftell(file)) > 0 && fseek(file, 0, SEEK_SET) == 0) {
+        image = (unsigned char*)DO_MALLOC((size_t)length);
+        if (image && fread(image, 1, (size_t)length, file) != (size_t)length) {
+            DO_FREE(image);
+            image = NULL;
+        }
+    }
+    fclose(file);
+    *size = (size_t)length;
+    return image;
+#endif
+}
+
+static void snapshot_close(const unsigned char* image, size_t size) {
+#if DO_SNAPSHOT_MMAP
+    munmap((void*)image, size);
+#else
+    (void)size;
+    DO_FREE((void*)image);
+#endif
+}
+
+static int snapshot_range_ok(uint64_t size, uint64_t offset, uint64_t length) {
+    return offset <= size && length <= size - offset;
+}
+
+DO_DEF void do_snapshot_destroy(do_snapshot* snapshot) {
+    if (!snapshot || !*snapshot) return;
+    do_arena_destroy(&(*snapshot)->arena);
+    snapshot_close((*snapshot)->image, (*snapshot)->image_size);
+    DO_FREE((*snapshot)->roots);
+    DO_FREE(*snapshot);
+    *snapshot = NULL;
+}
+
+// Validate the image and build its objects. The snapshot takes over the
+// image; it is closed here on failure.
+static do_snapshot snapshot_build(const unsigned char* image, size_t size) {
+    do_snapshot_header_t header;
+    if (size < sizeof(header)) {
+        snapshot_close(image, size);
+        return NULL;
+    }
+    memcpy(&header, image, sizeof(header));
+    if (memcmp(header.magic, DO_SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.byte_order != DO_SNAPSHOT_BYTE_ORDER || header.size != size ||
+        header.root_count > INT32_MAX ||
+        (header.strings | header.objects | header.properties) % sizeof(uint64_t) != 0 ||
+        header.roots % sizeof(uint32_t) != 0 ||
+        !snapshot_range_ok(size, header.strings, (uint64_t)header.string_count * sizeof(uint64_t)) ||
+        !snapshot_range_ok(size, header.objects, (uint64_t)header.object_count * sizeof(do_snapshot_object_t)) ||
+        !snapshot_range_ok(size, header.properties, (uint64_t)header.property_count * sizeof(do_snapshot_property_t)) ||
+        !snapshot_range_ok(size, header.roots, (uint64_t)header.root_count * sizeof(uint32_t))) {
+        snapshot_close(image, size);
+        return NULL;
+    }
+    const uint64_t* string_offsets = (const uint64_t*)(image + header.strings);
+    const do_snapshot_object_t* records = (const do_snapshot_object_t*)(image + header.objects);
+    const do_snapshot_property_t* properties = (const do_snapshot_property_t*)(image + header.properties);
+    const uint32_t* root_numbers = (const uint32_t*)(image + header.roots);
+    
+    do_snapshot snapshot = (do_snapshot)DO_MALLOC(sizeof(struct do_snapshot_t));
+    if (!snapshot) {
+        snapshot_close(image, size);
+        return NULL;
+    }
+    snapshot->image = image;
+    snapshot->image_size = size;
+    snapshot->arena = do_arena_create(0);
+    snapshot->roots = (do_object*)DO_MALLOC(header.root_count * sizeof(do_object) + 1);
+    snapshot->root_count = (int)header.root_count;
+    if (snapshot->arena) {
+        snapshot->arena->borrowed = image;
+        snapshot->arena->borrowed_size = size;
+    }
+    
+    // One slice of these per object; +1 keeps empty snapshots non-NULL
+    const char** strings = (const char**)DO_MALLOC(header.string_count * sizeof(char*) + 1);
+    do_object* objects = (do_object*)DO_MALLOC(header.object_count * sizeof(do_object) + 1);
+    const char** keys = (const char**)DO_MALLOC(header.property_count * sizeof(char*) + 1);
+    const void** values = (const void**)DO_MALLOC(header.property_count * sizeof(void*) + 1);
+    size_t* sizes = (size_t*)DO_MALLOC(header.property_count * sizeof(size_t) + 1);
+    int ok = snapshot->arena && snapshot->roots && strings && objects && keys && values && sizes;
+    
+    for (uint32_t i = 0; ok && i < header.string_count; i++) {
+        uint64_t offset = string_offsets[i];
+        const char* text = offset < size ? (const char*)image + offset : NULL;
+        const char* end = text ? (const char*)memchr(text, '\0', size - (size_t)offset) : NULL;
+        ok = end && (strings[i] = do_string_intern_n(text, (size_t)(end - text))) != NULL;
+    }
+    for (uint32_t i = 0; ok && i < header.property_count; i++) {
+        const do_snapshot_property_t* property = &properties[i];
+        ok = property->key < header.string_count && snapshot_range_ok(size, property->data, property->size) &&
+             (property->type == DO_TYPE_BYTES ||
+              ((property->type == DO_TYPE_I64 || property->type == DO_TYPE_F64) && property->size == 8));
+        if (!ok) break;
+        keys[i] = strings[property->key];
+        values[i] = image + property->data;
+        sizes[i] = (size_t)property->size;
+    }
+    for (uint32_t i = 0; ok && i < header.object_count; i++) {
+        const do_snapshot_object_t* record = &records[i];
+        ok = record->prototype <= i &&
+             snapshot_range_ok(header.property_count, record->first_property, record->property_count);
+        if (!ok) break;
+        objects[i] = do_arena_create_object(snapshot->arena, record->prototype ? objects[record->prototype - 1] : NULL);
+        ok = objects[i] &&
+             do_set_many(objects[i], keys + record->first_property, values + record->first_property,
+                         sizes + record->first_property, (int)record->property_count) == DO_SUCCESS;
+#if DO_TAGGED_VALUES
+        for (uint32_t j = record->first_property; ok && j < record->first_property + record->property_count; j++) {
+            find_own_property_value(objects[i], keys[j])->type = properties[j].type;
+        }
+#endif
+    }
+    for (uint32_t i = 0; ok && i < header.root_count; i++) {
+        ok = root_numbers[i] < header.object_count;
+        if (ok) snapshot->roots[i] = objects[root_numbers[i]];
+    }
+    for (uint32_t i = 0; ok && i < header.object_count; i++) {
+        do_freeze(objects[i], 0);
+    }
+    
+    DO_FREE((void*)strings);
+    DO_FREE(objects);
+    DO_FREE((void*)keys);
+    DO_FREE((void*)values);
+    DO_FREE(sizes);
+    if (!ok) do_snapshot_destroy(&snapshot);
+    return snapshot;
+}
+
+DO_DEF do_snapshot do_snapshot_map(const char* path) {
+    DO_ASSERT(path != NULL);
+    
+    size_t size = 0;
+    const unsigned char* image = snapshot_open(path, &size);
+    if (!image) return NULL;
+    return snapshot_build(image, size);
 }
 
+DO_DEF int do_snapshot_root_count(do_snapshot snapshot) {
+    DO_ASSERT(snapshot != NULL);
+    return snapshot->root_count;
+}
+
+DO_DEF do_object do_snapshot_root(do_snapshot snapshot, int index) {
+    DO_ASSERT(snapshot != NULL);
+    DO_ASSERT(index >= 0 && index < snapshot->root_count);
+    return snapshot->roots[index];
+}
+
+#endif // DO_SNAPSHOT
+
 /* =============================================================================
  * UTILITY FUNCTIONS IMPLEMENTATION
  * ============================================================================= */
@@ -1138,21 +6391,25 @@ DO_DEF const char** do_get_own_keys(do_object obj) {
     
     const char** keys = NULL;
     
+#if DO_CONCURRENT_OBJECTS
+    if (object_is_concurrent(obj)) {
+        do_rcu_read_lock();
+        const do_version_t* version = current_version(obj);
+        for (int i = 0; i < version->count; i++) arrput(keys, version->keys[i]);
+        do_rcu_read_unlock();
+        return keys;
+    }
+#endif
     if (obj->is_hashed) {
-        // Hash map iteration using stb_ds
-        if (obj->properties.hash_props) {
-            for (int i = 0; i < hmlen(obj->properties.hash_props); i++) {
-                arrput(keys, obj->properties.hash_props[i].key);
-            }
+        // Entries are in insertion order, with holes where keys were deleted
+        do_hash_table_t* table = obj->properties.table;
+        for (uint32_t i = 0; table && i < table->used; i++) {
+            if (table->entries[i].key) arrput(keys, table->entries[i].key);
         }
     } else {
-        // Linear array iteration  
-        if (obj->properties.linear_props) {
-            int len = arrlen(obj->properties.linear_props);
-            for (int i = 0; i < len; i++) {
-                const char* key = obj->properties.linear_props[i].key;
-                arrput(keys, key);
-            }
+        // Slot order is insertion order
+        for (int i = 0; i < obj->shape->slot_count; i++) {
+            arrput(keys, obj->shape->keys[i]);
         }
     }
     
@@ -1166,68 +6423,195 @@ DO_DEF const char** do_get_own_keys(do_object obj) {
 DO_DEF const char** do_get_all_keys(do_object obj) {
     DO_ASSERT(obj != NULL);
     
+    if (object_is_concurrent(obj)) return do_get_own_keys(obj);  // Never has a prototype
+    
     const char** all_keys = NULL;
+    do_iter_t iter;
+    do_iter_init(&iter, obj, DO_ITER_INHERITED);
+    while (do_iter_next(&iter)) {
+        arrput(all_keys, iter.key);
+    }
     
-    // Walk prototype chain from most derived to base
-    do_object current = obj;
-    while (current != NULL) {
-        // Get keys from current object  
-        const char** own_keys = do_get_own_keys(current);
+    return all_keys;
+}
+
+DO_DEF void do_iter_init(do_iter_t* iter, do_object obj, int flags) {
+    DO_ASSERT(iter != NULL);
+    DO_ASSERT(obj != NULL);
+    DO_ASSERT(!object_is_concurrent(obj));
+    
+    iter->key = NULL;
+    iter->value = NULL;
+    iter->size = 0;
+    iter->holder = obj;
+    iter->start = obj;
+    iter->flags = flags;
+    iter->index = 0;
+}
+
+// Whether an object between start (inclusive) and holder (exclusive) has
+// key, hiding holder's property. Lookups are O(1) per level, so enumerating
+// a chain stays linear in its total keys for a given depth.
+static int iter_shadowed(do_object start, do_object holder, const char* key) {
+    for (do_object current = start; current != holder; current = current->prototype) {
+        if (find_own_property(current, key)) return 1;
+    }
+    return 0;
+}
+
+DO_DEF int do_iter_next(do_iter_t* iter) {
+    DO_ASSERT(iter != NULL);
+    
+    while (iter->holder) {
+        do_object obj = iter->holder;
+        const char* key = NULL;
+        do_property_t* prop = NULL;
         
-        // Add keys that aren't already in all_keys
-        int own_len = arrlen(own_keys);
-        for (int i = 0; i < own_len; i++) {
-            const char* key = own_keys[i];
-            
-            // Check if key already exists (prototype shadowing)
-            int found = 0;
-            int all_len = arrlen(all_keys);
-            for (int j = 0; j < all_len; j++) {
-                if (all_keys[j] == key) {  // Pointer comparison for interned strings
-                    found = 1;
+        if (obj->is_hashed) {
+            do_hash_table_t* table = obj->properties.table;
+            while (table && iter->index < table->used) {
+                do_hash_entry_t* entry = &table->entries[iter->index++];
+                if (entry->key) {
+                    key = entry->key;
+                    prop = &entry->value;
                     break;
                 }
             }
-            
-            if (!found) {
-                arrput(all_keys, key);
-            }
+        } else if (iter->index < (uint32_t)obj->shape->slot_count) {
+            key = obj->shape->keys[iter->index];
+            prop = &obj->properties.slots[iter->index];
+            iter->index++;
         }
         
-        arrfree(own_keys);
-        current = current->prototype;
+        if (!key) {
+            // This level is done - move up the chain or finish
+            iter->holder = (iter->flags & DO_ITER_INHERITED) ? obj->prototype : NULL;
+            iter->index = 0;
+            continue;
+        }
+        if (obj != iter->start && iter_shadowed(iter->start, obj, key)) continue;
+        
+        iter->key = key;
+        iter->value = property_data(prop);
+        iter->size = prop->size;
+        return 1;
     }
     
-    return all_keys;
+    iter->key = NULL;
+    iter->value = NULL;
+    iter->size = 0;
+    return 0;
+}
+
+static size_t value_usage(const do_property_t* prop) {
+    return prop->size > DO_INLINE_SIZE ? prop->data.heap.capacity : 0;
+}
+
+DO_DEF size_t do_memory_usage(do_object obj, int flags) {
+    DO_ASSERT(obj != NULL);
+    
+    size_t total = 0;
+    for (do_object current = obj; current; current = current->prototype) {
+        total += sizeof(do_object_t);
+        if (current->share) total += sizeof(do_share_t);
+#if DO_CONCURRENT_OBJECTS
+        if (object_is_concurrent(current)) {
+            total += concurrent_usage(current);
+            break;
+        }
+#endif
+        if (current->is_hashed) {
+            const do_hash_table_t* table = current->properties.table;
+            if (table) {
+                total += table_bytes(table->capacity);
+                for (uint32_t i = 0; i < table->used; i++) {
+                    if (table->entries[i].key) total += value_usage(&table->entries[i].value);
+                }
+            }
+        } else {
+            total += (size_t)current->slot_capacity * sizeof(do_property_t);
+            for (int i = 0; i < current->shape->slot_count; i++) {
+                total += value_usage(&current->properties.slots[i]);
+            }
+        }
+        if (!(flags & DO_MEMORY_PROTOTYPES)) break;
+    }
+    return total;
 }
 
 DO_DEF int do_property_count(do_object obj) {
     DO_ASSERT(obj != NULL);
+#if DO_CONCURRENT_OBJECTS
+    if (object_is_concurrent(obj)) {
+        do_rcu_read_lock();
+        int count = current_version(obj)->count;
+        do_rcu_read_unlock();
+        return count;
+    }
+#endif
     return obj->property_count;
 }
 
+DO_DEF int do_compact(do_object obj) {
+    DO_ASSERT(obj != NULL);
+    
+    if (obj->flags & DO_OBJECT_FROZEN) return DO_ERROR_FROZEN;
+    if (obj->share || obj->arena) return DO_SUCCESS;  // Nothing a private copy would give back
+    if (object_is_concurrent(obj)) return DO_SUCCESS; // Versions are built exactly sized
+    
+    if (obj->is_hashed) {
+        if (obj->property_count <= DO_HASH_THRESHOLD && downgrade_to_slots(obj) == DO_SUCCESS) {
+            return DO_SUCCESS;
+        }
+        do_hash_table_t* table = obj->properties.table;
+        return table ? table_rebuild(obj, &obj->properties.table, table->count) : DO_SUCCESS;
+    }
+    
+    int count = obj->shape->slot_count;
+    if (obj->slot_capacity == count) return DO_SUCCESS;
+    
+    size_t old_bytes = (size_t)obj->slot_capacity * sizeof(do_property_t);
+    if (count == 0) {
+        object_dealloc(obj, obj->properties.slots, old_bytes);
+        obj->properties.slots = NULL;
+    } else {
+        do_property_t* slots = (do_property_t*)object_resize(obj, obj->properties.slots, old_bytes,
+                                                             (size_t)count * sizeof(do_property_t));
+        if (!slots) return DO_ERROR_MEMORY;
+        obj->properties.slots = slots;
+    }
+    obj->slot_capacity = count;
+    return DO_SUCCESS;
+}
+
 DO_DEF void do_foreach_property(do_object obj,
                                 void (*callback)(const char* key, void* data, size_t size, void* context),
                                 void* context) {
     DO_ASSERT(obj != NULL);
     DO_ASSERT(callback != NULL);
     
+#if DO_CONCURRENT_OBJECTS
+    if (object_is_concurrent(obj)) {
+        // One snapshot for the whole walk; the callback may write to obj
+        do_rcu_read_lock();
+        const do_version_t* version = current_version(obj);
+        for (int i = 0; i < version->count; i++) {
+            callback(version->keys[i], version->values[i].data, version->values[i].size, context);
+        }
+        do_rcu_read_unlock();
+        return;
+    }
+#endif
     if (obj->is_hashed) {
-        if (obj->properties.hash_props) {
-            // Iterate through stb_ds hash map
-            for (int i = 0; i < hmlen(obj->properties.hash_props); i++) {
-                do_property_t* prop = &obj->properties.hash_props[i].value;
-                callback(obj->properties.hash_props[i].key, prop->data, prop->size, context);
-            }
+        do_hash_table_t* table = obj->properties.table;
+        for (uint32_t i = 0; table && i < table->used; i++) {
+            do_hash_entry_t* entry = &table->entries[i];
+            if (entry->key) callback(entry->key, property_data(&entry->value), entry->value.size, context);
         }
     } else {
-        if (obj->properties.linear_props) {
-            int len = arrlen(obj->properties.linear_props);
-            
-            for (int i = 0; i < len; i++) {
-                do_property_t* prop = &obj->properties.linear_props[i];
-                callback(prop->key, prop->data, prop->size, context);
-            }
+        for (int i = 0; i < obj->shape->slot_count; i++) {
+            do_property_t* prop = &obj->properties.slots[i];
+            callback(obj->shape->keys[i], property_data(prop), prop->size, context);
         }
     }
 }
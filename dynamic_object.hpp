@@ -0,0 +1,377 @@
+/**
+ * @file dynamic_object.hpp
+ * @brief C++17 wrapper for dynamic_object.h
+ *
+ * Header-only and declaration-only: the library itself is still compiled
+ * from a C translation unit that defines DO_IMPLEMENTATION, and do_object_t
+ * is opaque here, so C++ code never depends on its layout. Provides
+ * - dobj::Object, an owning handle: copies retain, moves transfer the
+ *   reference without touching the count, destruction releases
+ * - get<T>/get_mut<T>/value<T>/set<T> templates over trivially copyable
+ *   types, sized and aligned at compile time
+ * - dobj::Key<"name"> (C++20), a key hashed at compile time and interned
+ *   once, on first use, through do_string_intern_hashed
+ *
+ * Usage:
+ * #include "dynamic_object.hpp"
+ *
+ * dobj::Object point = dobj::Object::create();
+ * point.set(dobj::Key<"x">{}, 3.0);
+ * double x = point.value<double>(dobj::Key<"x">{}).value_or(0.0);
+ */
+
+#ifndef DYNAMIC_OBJECT_HPP
+#define DYNAMIC_OBJECT_HPP
+
+#include "dynamic_object.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if __cplusplus < 201703L && (!defined(_MSVC_LANG) || _MSVC_LANG < 201703L)
+#error "dynamic_object.hpp requires C++17"
+#endif
+
+#if !DO_STRING_INTERNING
+#error "dynamic_object.hpp requires DO_STRING_INTERNING"
+#endif
+
+namespace dobj {
+
+/**
+ * @brief Interned key pointer, passed straight to the *_interned entry points
+ * @note Build one with dobj::intern, or let a dobj::Key convert to it
+ */
+struct InternedKey {
+    const char* ptr;
+};
+
+/**
+ * @brief Intern a key once for repeated use
+ * @return The interned key; its ptr is NULL on allocation failure
+ */
+inline InternedKey intern(std::string_view text) {
+    return InternedKey{ do_string_intern_n(text.data(), text.size()) };
+}
+
+namespace detail {
+
+// Every property value is at least this aligned: inline storage is aligned
+// for long long and double, heap buffers come from malloc, the pool or an
+// arena
+inline constexpr std::size_t value_alignment = alignof(long long) > alignof(double) ? alignof(long long)
+                                                                                     : alignof(double);
+
+// Compile-time form of do_string_hash
+constexpr std::size_t string_hash(const char* str, std::size_t len) {
+    std::size_t hash = DO_STRING_HASH_INIT;
+    for (std::size_t i = 0; i < len; i++) hash = DO_STRING_HASH_STEP(hash, str[i]);
+    return hash;
+}
+
+// Cached pointer of one dobj::Key, linked so intern_cleanup can forget it
+struct KeySlot {
+    std::atomic<const char*> interned{ nullptr };
+    KeySlot* next = nullptr;
+};
+
+inline std::atomic<KeySlot*> key_slots{ nullptr };
+
+inline void register_key_slot(KeySlot* slot) {
+    slot->next = key_slots.load(std::memory_order_relaxed);
+    while (!key_slots.compare_exchange_weak(slot->next, slot, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+    }
+}
+
+// Interned pointer for any accepted key type, NULL if interning failed
+inline const char* key_ptr(InternedKey key) { return key.ptr; }
+inline const char* key_ptr(const char* key) { return key ? do_string_intern(key) : nullptr; }
+inline const char* key_ptr(std::string_view key) { return do_string_intern_n(key.data(), key.size()); }
+
+template <class T>
+constexpr void check_value_type() {
+    static_assert(std::is_trivially_copyable_v<T>, "property values are stored and read as raw bytes");
+}
+
+} // namespace detail
+
+/**
+ * @brief Free the intern table (do_string_intern_cleanup) and forget every
+ *        pointer cached by dobj::Key
+ * @note Use this instead of do_string_intern_cleanup once any Key has been
+ *       used; the keys are interned again on their next use
+ */
+inline void intern_cleanup() {
+    do_string_intern_cleanup();
+    for (detail::KeySlot* slot = detail::key_slots.load(std::memory_order_acquire); slot; slot = slot->next) {
+        slot->interned.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+
+/**
+ * @brief String literal usable as a template argument (for dobj::Key)
+ */
+template <std::size_t N>
+struct FixedString {
+    char chars[N] = {};
+
+    constexpr FixedString(const char (&str)[N]) {
+        for (std::size_t i = 0; i < N; i++) chars[i] = str[i];
+    }
+
+    constexpr std::size_t size() const { return N - 1; }
+};
+
+/**
+ * @brief Compile-time key: hashed by the compiler, interned on first use
+ * @note `obj.get<int>(dobj::Key<"length">{})` costs one load of the cached
+ *       pointer after the first call. Like DO_REGISTER_KEYS pointers, the
+ *       cache does not survive do_string_intern_cleanup (use
+ *       dobj::intern_cleanup). Keys always live in the global table, even
+ *       when first used with a DO_INTERN_CONTEXT context bound
+ */
+template <FixedString Name>
+struct Key {
+    static constexpr std::string_view text{ Name.chars, Name.size() };
+    static constexpr std::size_t hash = detail::string_hash(Name.chars, Name.size());
+
+    static_assert(text.find('\0') == std::string_view::npos, "keys cannot contain NUL bytes");
+
+    /**
+     * @brief The interned pointer, NULL only if interning ran out of memory
+     */
+    static const char* get() {
+        const char* interned = slot.interned.load(std::memory_order_acquire);
+        return interned ? interned : resolve();
+    }
+
+    operator InternedKey() const { return InternedKey{ get() }; }
+
+private:
+    static inline detail::KeySlot slot;
+
+    static const char* resolve() {
+        static const bool registered = (detail::register_key_slot(&slot), true);
+        (void)registered;
+#if DO_INTERN_CONTEXT
+        // The pointer is cached for every thread, so it must not be a
+        // context's key: those can be swept and belong to one tenant
+        do_context bound = do_context_bind(nullptr);
+#endif
+        const char* interned = do_string_intern_hashed(Name.chars, Name.size(), hash);
+#if DO_INTERN_CONTEXT
+        do_context_bind(bound);
+#endif
+        slot.interned.store(interned, std::memory_order_release);
+        return interned;
+    }
+};
+
+#endif
+
+/**
+ * @brief Owning handle to a do_object
+ *
+ * Holds one reference. Copying retains, moving hands the reference over
+ * without refcount traffic, and the destructor releases. A default
+ * constructed (or moved-from) handle is empty; property access on an empty
+ * handle is an error, as with a NULL do_object.
+ *
+ * Keys may be a const char* or std::string_view (interned per call, like
+ * do_get), an InternedKey, or a dobj::Key.
+ */
+class Object {
+public:
+    Object() noexcept = default;
+
+    Object(const Object& other) noexcept : obj_(other.obj_ ? do_retain(other.obj_) : nullptr) {}
+    Object(Object&& other) noexcept : obj_(std::exchange(other.obj_, nullptr)) {}
+
+    Object& operator=(const Object& other) noexcept {
+        Object(other).swap(*this);
+        return *this;
+    }
+
+    Object& operator=(Object&& other) noexcept {
+        Object(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    ~Object() {
+        if (obj_) do_release(&obj_);
+    }
+
+    /**
+     * @brief New object (do_create); empty on allocation failure
+     */
+    static Object create(void (*release_fn)(void*) = nullptr) {
+        return adopt(do_create(release_fn));
+    }
+
+    /**
+     * @brief New object inheriting from prototype (do_create_with_prototype)
+     */
+    static Object create(const Object& prototype, void (*release_fn)(void*) = nullptr) {
+        return adopt(do_create_with_prototype(prototype.obj_, release_fn));
+    }
+
+    /**
+     * @brief Take over a reference the caller owns, e.g. from do_create
+     */
+    static Object adopt(do_object obj) noexcept {
+        Object result;
+        result.obj_ = obj;
+        return result;
+    }
+
+    /**
+     * @brief Add a reference to a borrowed object, e.g. from do_get_prototype
+     */
+    static Object retain(do_object obj) noexcept {
+        return adopt(obj ? do_retain(obj) : nullptr);
+    }
+
+    /**
+     * @brief The wrapped object, still owned by this handle
+     */
+    do_object handle() const noexcept { return obj_; }
+
+    /**
+     * @brief Give up the reference without releasing it; the handle becomes empty
+     */
+    do_object detach() noexcept { return std::exchange(obj_, nullptr); }
+
+    void reset() noexcept { Object().swap(*this); }
+    void swap(Object& other) noexcept { std::swap(obj_, other.obj_); }
+    explicit operator bool() const noexcept { return obj_ != nullptr; }
+
+    friend bool operator==(const Object& a, const Object& b) noexcept { return a.obj_ == b.obj_; }
+    friend bool operator!=(const Object& a, const Object& b) noexcept { return a.obj_ != b.obj_; }
+
+    /**
+     * @brief Copy-on-write copy of the own properties (do_clone)
+     */
+    Object clone() const { return adopt(do_clone(obj_)); }
+
+    Object prototype() const { return retain(do_get_prototype(obj_)); }
+    int set_prototype(const Object& prototype) { return do_set_prototype(obj_, prototype.obj_); }
+    int property_count() const { return do_property_count(obj_); }
+
+    /**
+     * @brief Read-only pointer to the stored value (searches the prototype chain)
+     * @return The value, or NULL if missing
+     * @note Zero-copy like do_get: valid until the property is written or
+     *       deleted. The bytes may be shared with clones or belong to a
+     *       prototype or frozen object, so write through get_mut. Types
+     *       aligned beyond what property storage guarantees must be read
+     *       with value<T>
+     */
+    template <class T, class K>
+    const T* get(const K& key) const {
+        detail::check_value_type<T>();
+        static_assert(alignof(T) <= detail::value_alignment, "over-aligned type: read it with value<T>");
+        const char* interned = detail::key_ptr(key);
+        return interned ? static_cast<const T*>(do_get_interned(obj_, interned)) : nullptr;
+    }
+
+    /**
+     * @brief Writable pointer to an own property's value (do_get_mut_interned)
+     * @return The value, or NULL if missing, inherited or the object is frozen
+     * @note Unshares the properties of a clone first, so writes never reach
+     *       the object it was cloned from. Valid under the same rules as get
+     */
+    template <class T, class K>
+    T* get_mut(const K& key) {
+        detail::check_value_type<T>();
+        static_assert(alignof(T) <= detail::value_alignment, "over-aligned type: write it with set");
+        const char* interned = detail::key_ptr(key);
+        return interned ? static_cast<T*>(do_get_mut_interned(obj_, interned)) : nullptr;
+    }
+
+    /**
+     * @brief Copy of the stored value, or nullopt if missing
+     */
+    template <class T, class K>
+    std::optional<T> value(const K& key) const {
+        detail::check_value_type<T>();
+        const char* interned = detail::key_ptr(key);
+        const void* data = interned ? do_get_interned(obj_, interned) : nullptr;
+        if (!data) return std::nullopt;
+        if constexpr (alignof(T) <= detail::value_alignment) {
+            return *static_cast<const T*>(data);
+        } else {
+            T result;
+            std::memcpy(&result, data, sizeof(T));
+            return result;
+        }
+    }
+
+    /**
+     * @brief Store a copy of value's bytes (do_set_interned with sizeof(T))
+     * @return DO_SUCCESS or a DO_ERROR_* code
+     * @note Values of up to DO_INLINE_SIZE bytes are kept in the property
+     *       slot, larger ones in a heap buffer
+     */
+    template <class T, class K>
+    int set(const K& key, const T& value) {
+        detail::check_value_type<T>();
+        const char* interned = detail::key_ptr(key);
+        if (!interned) return DO_ERROR_MEMORY;
+        return do_set_interned(obj_, interned, &value, sizeof(T));
+    }
+
+    template <class K>
+    bool has(const K& key) const {
+        const char* interned = detail::key_ptr(key);
+        return interned && do_has_interned(obj_, interned);
+    }
+
+    /**
+     * @brief Delete an own property (do_delete_interned)
+     * @return true if it existed
+     */
+    template <class K>
+    bool erase(const K& key) {
+        const char* interned = detail::key_ptr(key);
+        return interned && do_delete_interned(obj_, interned);
+    }
+
+#if DO_TAGGED_VALUES
+    /**
+     * @brief Store a reference to another object (do_set_obj)
+     * @note The property keeps its own reference until overwritten or deleted
+     */
+    template <class K>
+    int set(const K& key, const Object& value) {
+        const char* interned = detail::key_ptr(key);
+        if (!interned) return DO_ERROR_MEMORY;
+        return do_set_obj(obj_, interned, value.obj_);
+    }
+
+    /**
+     * @brief Object stored with set(key, Object), empty if missing or not an object
+     */
+    template <class K>
+    Object get_object(const K& key) const {
+        const char* interned = detail::key_ptr(key);
+        return interned ? retain(do_get_obj(obj_, interned)) : Object();
+    }
+#endif
+
+private:
+    do_object obj_ = nullptr;
+};
+
+inline void swap(Object& a, Object& b) noexcept { a.swap(b); }
+
+} // namespace dobj
+
+#endif // DYNAMIC_OBJECT_HPP
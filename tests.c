@@ -68,6 +68,9 @@ void setUp(void) {
 }
 
 void tearDown(void) {
+    // Destroy whatever a test left queued (no-op without DO_DEFERRED_RELEASE)
+    do_drain_releases(SIZE_MAX);
+    do_frozen_cleanup();
     // Clean up string interning table after each test
     do_string_intern_cleanup();
 }
@@ -130,6 +133,105 @@ void test_string_intern_cleanup(void) {
     // The important thing is cleanup didn't crash and we can still intern strings
 }
 
+void test_string_intern_many_keys(void) {
+    // Enough distinct keys to force several rehashes of the intern table
+    enum { NUM_KEYS = 5000 };
+    static const char* interned[NUM_KEYS];
+    char key[32];
+    
+    for (int i = 0; i < NUM_KEYS; i++) {
+        snprintf(key, sizeof(key), "key_%d", i);
+        interned[i] = do_string_intern(key);
+        TEST_ASSERT_NOT_NULL(interned[i]);
+    }
+    
+    // Pointers handed out before growth must remain valid and canonical
+    for (int i = 0; i < NUM_KEYS; i++) {
+        snprintf(key, sizeof(key), "key_%d", i);
+        TEST_ASSERT_EQUAL_STRING(key, interned[i]);
+        TEST_ASSERT_EQUAL_PTR(interned[i], do_string_intern(key));
+        TEST_ASSERT_EQUAL_PTR(interned[i], do_string_find_interned(key));
+    }
+    
+    TEST_ASSERT_NULL(do_string_find_interned("key_missing"));
+}
+
+void test_string_intern_slices(void) {
+    // Slices of a larger buffer need no terminator
+    const char* source = "width=10 height=20";
+    const char* width = do_string_intern_n(source, 5);
+    TEST_ASSERT_EQUAL_STRING("width", width);
+    TEST_ASSERT_EQUAL_PTR(width, do_string_intern("width"));
+    TEST_ASSERT_EQUAL_PTR(width, do_string_intern_n(source, 5));
+    TEST_ASSERT_NOT_EQUAL(width, do_string_intern_n(source, 4));
+    
+    // A hash accumulated while scanning matches do_string_hash
+    size_t hash = DO_STRING_HASH_INIT;
+    size_t len = 0;
+    for (const char* p = source + 9; *p != '='; p++, len++) hash = DO_STRING_HASH_STEP(hash, *p);
+    TEST_ASSERT_EQUAL_UINT(do_string_hash(source + 9, len), hash);
+    const char* height = do_string_intern_hashed(source + 9, len, hash);
+    TEST_ASSERT_EQUAL_STRING("height", height);
+    TEST_ASSERT_EQUAL_PTR(height, do_string_find_interned("height"));
+    
+    // Length and hash are kept next to the string
+    TEST_ASSERT_EQUAL_UINT(6, do_interned_length(height));
+    TEST_ASSERT_EQUAL_UINT(hash, do_interned_hash(height));
+    TEST_ASSERT_EQUAL_UINT(0, do_interned_length(do_string_intern_n(source, 0)));
+    TEST_ASSERT_EQUAL_STRING("", do_string_intern(""));
+}
+
+#if DO_INTERN_CONCURRENT
+#include <pthread.h>
+
+// Key count is prime so every per-thread stride visits all keys
+enum { CONCURRENT_THREADS = 8, CONCURRENT_KEYS = 2003 };
+static const char* concurrent_results[CONCURRENT_THREADS][CONCURRENT_KEYS];
+
+static void* concurrent_intern_worker(void* arg) {
+    int thread = (int)(intptr_t)arg;
+    char key[32];
+    
+    // Each thread walks the keys in a different order so inserts collide
+    for (int n = 0; n < CONCURRENT_KEYS; n++) {
+        int i = (n * (2 * thread + 1) + thread * 97) % CONCURRENT_KEYS;
+        snprintf(key, sizeof(key), "shared_%d", i);
+        concurrent_results[thread][i] = do_string_intern(key);
+    }
+    // Second pass exercises the lock-free (and cached) hit path
+    for (int i = 0; i < CONCURRENT_KEYS; i++) {
+        snprintf(key, sizeof(key), "shared_%d", i);
+        if (do_string_intern(key) != concurrent_results[thread][i]) {
+            concurrent_results[thread][i] = NULL;
+        }
+    }
+    return NULL;
+}
+
+void test_string_intern_concurrent(void) {
+    pthread_t threads[CONCURRENT_THREADS];
+    
+    for (int t = 0; t < CONCURRENT_THREADS; t++) {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[t], NULL, concurrent_intern_worker, (void*)(intptr_t)t));
+    }
+    for (int t = 0; t < CONCURRENT_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    
+    // Every thread must have observed the same canonical pointer per key
+    char key[32];
+    for (int i = 0; i < CONCURRENT_KEYS; i++) {
+        snprintf(key, sizeof(key), "shared_%d", i);
+        const char* expected = do_string_find_interned(key);
+        TEST_ASSERT_NOT_NULL(expected);
+        TEST_ASSERT_EQUAL_STRING(key, expected);
+        for (int t = 0; t < CONCURRENT_THREADS; t++) {
+            TEST_ASSERT_EQUAL_PTR(expected, concurrent_results[t][i]);
+        }
+    }
+}
+#endif
+
 /* =============================================================================
  * OBJECT CREATION AND LIFECYCLE TESTS
  * ============================================================================= */
@@ -156,6 +258,7 @@ void test_object_create_with_prototype(void) {
     TEST_ASSERT_EQUAL_INT(1, do_get_ref_count(obj));
     
     do_release(&obj);
+    do_drain_releases(SIZE_MAX);  // Destroys now in DO_DEFERRED_RELEASE builds
     TEST_ASSERT_EQUAL_INT(1, do_get_ref_count(proto)); // Back to 1
     
     do_release(&proto);
@@ -182,6 +285,212 @@ void test_object_reference_counting(void) {
     do_release(&obj);
 }
 
+#if DO_BIASED_REFCOUNT
+#include <pthread.h>
+
+static void* release_on_thread(void* arg) {
+    do_object obj = (do_object)arg;
+    do_release(&obj);
+    return NULL;
+}
+
+static void* retain_on_thread(void* arg) {
+    do_retain((do_object)arg);
+    return NULL;
+}
+
+static void* retain_twice_and_exit(void* arg) {
+    do_object obj = do_create(test_release_fn);
+    DO_SET(obj, "value", 7);
+    do_retain(obj);
+    *(do_object*)arg = obj;  // Two references for the caller
+    do_refcount_thread_exit();
+    return NULL;
+}
+
+static void run_on_thread(void* (*fn)(void*), void* arg) {
+    pthread_t thread;
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&thread, NULL, fn, arg));
+    pthread_join(thread, NULL);
+}
+
+void test_biased_refcount_threads(void) {
+    reset_release_counter();
+    
+    // The creating thread counts without touching the shared count
+    do_object obj = do_create(test_release_fn);
+    DO_SET(obj, "value", 1);
+    do_object a = do_retain(obj);
+    do_object b = do_retain(obj);
+    TEST_ASSERT_EQUAL_INT(3, do_get_ref_count(obj));
+    TEST_ASSERT_EQUAL_INT(0, atomic_load(&obj->ref_count));
+    
+    // References given away and released elsewhere queue it for a merge
+    run_on_thread(release_on_thread, a);
+    run_on_thread(release_on_thread, b);
+    TEST_ASSERT_EQUAL_INT(1, do_get_ref_count(obj));
+    TEST_ASSERT_EQUAL_UINT(1, do_refcount_merge());
+    TEST_ASSERT_EQUAL_UINT(0, do_refcount_merge());
+    TEST_ASSERT_EQUAL_INT(0, release_call_count);
+    do_release(&obj);
+    do_drain_releases(SIZE_MAX);  // Destroys now in DO_DEFERRED_RELEASE builds
+    TEST_ASSERT_EQUAL_INT(1, release_call_count);
+    
+    // Outlived by another thread's reference: the owner merges, the other frees
+    obj = do_create(test_release_fn);
+    DO_SET(obj, "value", 2);
+    do_object kept = obj;
+    run_on_thread(retain_on_thread, kept);
+    do_release(&obj);
+    TEST_ASSERT_EQUAL_INT(1, do_get_ref_count(kept));
+    run_on_thread(release_on_thread, kept);
+    do_drain_releases(SIZE_MAX);  // Destroys now in DO_DEFERRED_RELEASE builds
+    TEST_ASSERT_EQUAL_INT(2, release_call_count);
+    
+    // Objects of an exited thread are merged by whoever releases them
+    do_object orphan = NULL;
+    run_on_thread(retain_twice_and_exit, &orphan);
+    do_object second = orphan;
+    do_release(&orphan);
+    TEST_ASSERT_EQUAL_INT(1, do_get_ref_count(second));
+    TEST_ASSERT_EQUAL_INT(2, release_call_count);
+    do_release(&second);
+    do_drain_releases(SIZE_MAX);  // Destroys now in DO_DEFERRED_RELEASE builds
+    TEST_ASSERT_EQUAL_INT(3, release_call_count);
+    TEST_ASSERT_EQUAL_INT(7, last_released_value);
+}
+#endif
+
+#if DO_CONCURRENT_OBJECTS
+#include <pthread.h>
+
+enum { RCU_READERS = 4, RCU_ROUNDS = 2000 };
+
+typedef struct {
+    do_object obj;
+    atomic_int done;
+    atomic_int torn;  // Batch reads that saw a pair from two different writes
+} rcu_shared_t;
+
+static void* rcu_reader_worker(void* arg) {
+    rcu_shared_t* shared = (rcu_shared_t*)arg;
+    const char* keys[2] = {do_string_intern("a"), do_string_intern("b")};
+    void* values[2];
+    while (!atomic_load(&shared->done)) {
+        do_rcu_read_lock();
+        if (do_get_many(shared->obj, keys, values, 2) != 2 || *(int*)values[0] != *(int*)values[1]) {
+            atomic_fetch_add(&shared->torn, 1);
+        }
+        do_rcu_read_unlock();
+    }
+    return NULL;
+}
+
+void test_concurrent_objects(void) {
+    reset_release_counter();
+    do_object obj = do_create_concurrent(test_release_fn);
+    TEST_ASSERT_NOT_NULL(obj);
+    
+    // Single-threaded semantics match a plain object
+    DO_SET(obj, "x", 1);
+    DO_SET(obj, "y", 2);
+    TEST_ASSERT_TRUE(do_has(obj, "x"));
+    TEST_ASSERT_TRUE(do_has_own(obj, "y"));
+    TEST_ASSERT_EQUAL_INT(2, do_property_count(obj));
+    do_rcu_read_lock();
+    int* held = (int*)do_get(obj, "x");
+    TEST_ASSERT_EQUAL_INT(1, *held);
+    
+    // A replaced value stays readable until the section that saw it ends
+    DO_SET(obj, "x", 10);
+    TEST_ASSERT_EQUAL_INT(1, *held);
+    TEST_ASSERT_EQUAL_INT(10, DO_GET(obj, "x", int));
+    do_rcu_read_unlock();
+    do_rcu_synchronize();
+    TEST_ASSERT_EQUAL_INT(1, release_call_count);
+    TEST_ASSERT_EQUAL_INT(1, last_released_value);
+    
+    TEST_ASSERT_EQUAL_INT(1, do_delete(obj, "y"));
+    TEST_ASSERT_EQUAL_INT(0, do_delete(obj, "y"));
+    TEST_ASSERT_FALSE(do_has(obj, "y"));
+    do_rcu_synchronize();
+    TEST_ASSERT_EQUAL_INT(2, release_call_count);
+    
+    // Past DO_HASH_THRESHOLD keys versions carry an index; batches publish once
+    char key[32];
+    const char* keys[40];
+    int values[40];
+    const void* ptrs[40];
+    size_t sizes[40];
+    for (int i = 0; i < 40; i++) {
+        snprintf(key, sizeof(key), "k%d", i);
+        keys[i] = do_string_intern(key);
+        values[i] = 100 + i;
+        ptrs[i] = &values[i];
+        sizes[i] = sizeof(int);
+    }
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_many(obj, keys, ptrs, sizes, 40));
+    TEST_ASSERT_EQUAL_INT(41, do_property_count(obj));
+    do_rcu_read_lock();
+    for (int i = 0; i < 40; i++) {
+        TEST_ASSERT_EQUAL_INT(100 + i, *(int*)do_get_interned(obj, keys[i]));
+    }
+    TEST_ASSERT_NULL(do_get(obj, "missing"));
+    do_rcu_read_unlock();
+    
+    const char** own = do_get_own_keys(obj);
+    TEST_ASSERT_EQUAL_INT(41, arrlen(own));
+    TEST_ASSERT_EQUAL_PTR(do_string_intern("x"), own[0]);
+    TEST_ASSERT_EQUAL_PTR(keys[39], own[40]);
+    arrfree(own);
+    
+    TEST_ASSERT_EQUAL_INT(20, do_delete_many(obj, keys, 20));
+    TEST_ASSERT_EQUAL_INT(21, do_property_count(obj));
+    do_rcu_read_lock();
+    TEST_ASSERT_NULL(do_get_interned(obj, keys[0]));
+    TEST_ASSERT_EQUAL_INT(139, *(int*)do_get_interned(obj, keys[39]));
+    do_rcu_read_unlock();
+    do_rcu_synchronize();
+    TEST_ASSERT_EQUAL_INT(22, release_call_count);
+    
+    // Every remaining value is released exactly once
+    do_release(&obj);
+    do_drain_releases(SIZE_MAX);  // Destroys now in DO_DEFERRED_RELEASE builds
+    do_rcu_synchronize();
+    TEST_ASSERT_EQUAL_INT(43, release_call_count);
+    
+    // Readers never see half of a batch while a writer keeps replacing it
+    rcu_shared_t shared;
+    shared.obj = do_create_concurrent(NULL);
+    atomic_init(&shared.done, 0);
+    atomic_init(&shared.torn, 0);
+    const char* pair[2] = {do_string_intern("a"), do_string_intern("b")};
+    int round = 0;
+    const void* pair_values[2] = {&round, &round};
+    size_t pair_sizes[2] = {sizeof(int), sizeof(int)};
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_many(shared.obj, pair, pair_values, pair_sizes, 2));
+    
+    pthread_t readers[RCU_READERS];
+    for (int t = 0; t < RCU_READERS; t++) {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&readers[t], NULL, rcu_reader_worker, &shared));
+    }
+    for (round = 1; round <= RCU_ROUNDS; round++) {
+        TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_many(shared.obj, pair, pair_values, pair_sizes, 2));
+    }
+    atomic_store(&shared.done, 1);
+    for (int t = 0; t < RCU_READERS; t++) {
+        pthread_join(readers[t], NULL);
+    }
+    TEST_ASSERT_EQUAL_INT(0, atomic_load(&shared.torn));
+    do_rcu_read_lock();
+    TEST_ASSERT_EQUAL_INT(RCU_ROUNDS, DO_GET(shared.obj, "b", int));
+    do_rcu_read_unlock();
+    do_release(&shared.obj);
+    do_drain_releases(SIZE_MAX);
+    do_rcu_synchronize();
+}
+#endif
+
 void test_object_create_with_release_fn(void) {
     do_object obj = create_managed_object();
     
@@ -193,6 +502,7 @@ void test_object_create_with_release_fn(void) {
     do_set(obj, "test", &value, sizeof(value));
     
     do_release(&obj);
+    do_drain_releases(SIZE_MAX);  // Destroys now in DO_DEFERRED_RELEASE builds
     
     // Release function should have been called
     TEST_ASSERT_EQUAL_INT(1, release_call_count);
@@ -236,6 +546,7 @@ void test_property_update_existing(void) {
     TEST_ASSERT_EQUAL_INT(99, *retrieved);
     
     do_release(&obj);
+    do_drain_releases(SIZE_MAX);  // Destroys now in DO_DEFERRED_RELEASE builds
     TEST_ASSERT_EQUAL_INT(2, release_call_count); // New value released
     TEST_ASSERT_EQUAL_INT(99, last_released_value);
 }
@@ -273,6 +584,101 @@ void test_property_different_types(void) {
     do_release(&obj);
 }
 
+void test_property_inline_and_heap_values(void) {
+    do_object obj = create_test_object();
+    
+    // Values at and just past the inline limit, plus a large payload
+    unsigned char small[DO_INLINE_SIZE];
+    unsigned char medium[DO_INLINE_SIZE + 1];
+    unsigned char large[1024];
+    memset(small, 0x11, sizeof(small));
+    memset(medium, 0x22, sizeof(medium));
+    memset(large, 0x33, sizeof(large));
+    
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set(obj, "small", small, sizeof(small)));
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set(obj, "medium", medium, sizeof(medium)));
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set(obj, "large", large, sizeof(large)));
+    
+    TEST_ASSERT_EQUAL_MEMORY(small, do_get(obj, "small"), sizeof(small));
+    TEST_ASSERT_EQUAL_MEMORY(medium, do_get(obj, "medium"), sizeof(medium));
+    TEST_ASSERT_EQUAL_MEMORY(large, do_get(obj, "large"), sizeof(large));
+    
+    // Updates crossing the inline/heap boundary in both directions
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set(obj, "small", large, sizeof(large)));
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set(obj, "large", small, sizeof(small)));
+    TEST_ASSERT_EQUAL_MEMORY(large, do_get(obj, "small"), sizeof(large));
+    TEST_ASSERT_EQUAL_MEMORY(small, do_get(obj, "large"), sizeof(small));
+    
+    // Re-setting a property from its own current value must be safe
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set(obj, "medium", do_get(obj, "medium"), sizeof(medium)));
+    TEST_ASSERT_EQUAL_MEMORY(medium, do_get(obj, "medium"), sizeof(medium));
+    
+    // Inline slots keep scalar alignment
+    TEST_ASSERT_EQUAL_INT(0, (uintptr_t)do_get(obj, "large") % sizeof(double));
+    
+    do_release(&obj);
+}
+
+void test_property_reserve_and_get_mut(void) {
+    do_object obj = create_managed_object();
+    
+    // Counters updated in place, with no release and no copy
+    int* counter = (int*)do_set_reserve(obj, "counter", sizeof(int));
+    TEST_ASSERT_NOT_NULL(counter);
+    *counter = 0;
+    for (int i = 0; i < 10; i++) {
+        (*(int*)do_get_mut(obj, "counter"))++;
+    }
+    TEST_ASSERT_EQUAL_INT(10, DO_GET(obj, "counter", int));
+    TEST_ASSERT_EQUAL_INT(0, release_call_count);
+    
+    // Heap buffers are reused by writes that fit, released when replaced
+    unsigned char payload[64];
+    memset(payload, 0x44, sizeof(payload));
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set(obj, "buffer", payload, sizeof(payload)));
+    void* buffer = do_get(obj, "buffer");
+    memset(payload, 0x55, sizeof(payload));
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set(obj, "buffer", payload, sizeof(payload)));
+    TEST_ASSERT_EQUAL_PTR(buffer, do_get(obj, "buffer"));
+    TEST_ASSERT_EQUAL_MEMORY(payload, buffer, sizeof(payload));
+    TEST_ASSERT_EQUAL_PTR(buffer, do_set_reserve(obj, "buffer", 48));
+    TEST_ASSERT_EQUAL_INT(2, release_call_count);
+    
+    unsigned char* grown = (unsigned char*)do_set_reserve(obj, "buffer", 256);
+    TEST_ASSERT_NOT_NULL(grown);
+    memset(grown, 0x66, 256);
+    TEST_ASSERT_EQUAL_INT(0x66, ((unsigned char*)do_get(obj, "buffer"))[255]);
+    TEST_ASSERT_EQUAL_INT(3, release_call_count);
+    
+    // Overlapping sources are copied aside, not written over themselves
+    unsigned char* current = (unsigned char*)do_get(obj, "buffer");
+    current[8] = 0x77;
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set(obj, "buffer", current + 8, 128));
+    TEST_ASSERT_EQUAL_INT(0x77, ((unsigned char*)do_get(obj, "buffer"))[0]);
+    TEST_ASSERT_EQUAL_INT(0x66, ((unsigned char*)do_get(obj, "buffer"))[127]);
+    
+    // Only own properties are writable
+    do_object child = do_create_with_prototype(obj, NULL);
+    TEST_ASSERT_NOT_NULL(do_get(child, "counter"));
+    TEST_ASSERT_NULL(do_get_mut(child, "counter"));
+    TEST_ASSERT_NULL(do_get_mut(child, "never_interned_key"));
+    
+    // Reserved storage of new keys in hashed objects lands in the table
+    char key[32];
+    for (int i = 0; i <= DO_HASH_THRESHOLD + 1; i++) {
+        snprintf(key, sizeof(key), "filler_%d", i);
+        DO_SET(child, key, i);
+    }
+    TEST_ASSERT_TRUE(child->is_hashed);
+    int* fresh = (int*)do_set_reserve(child, "fresh", sizeof(int));
+    *fresh = 99;
+    TEST_ASSERT_EQUAL_PTR(fresh, do_get_mut(child, "fresh"));
+    TEST_ASSERT_EQUAL_INT(99, DO_GET(child, "fresh", int));
+    
+    do_release(&child);
+    do_release(&obj);
+}
+
 void test_property_has_and_delete(void) {
     do_object obj = create_managed_object();
     
@@ -347,6 +753,28 @@ void test_interned_macros(void) {
     do_release(&obj);
 }
 
+#define TEST_KEYS(X) X(width) X(height)
+DO_DECLARE_KEYS(test_keys, TEST_KEYS);
+
+void test_static_key_table(void) {
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, DO_REGISTER_KEYS(test_keys));
+    TEST_ASSERT_EQUAL_PTR(do_string_intern("width"), DO_KEY(width));
+    TEST_ASSERT_EQUAL_PTR(do_string_intern("height"), DO_KEY(height));
+    
+    do_object obj = create_test_object();
+    int width = 640;
+    DO_SET_INTERNED(obj, DO_KEY(width), width);
+    TEST_ASSERT_EQUAL_INT(640, DO_GET(obj, "width", int));
+    TEST_ASSERT_FALSE(do_has_interned(obj, DO_KEY(height)));
+    do_release(&obj);
+    do_drain_releases(SIZE_MAX);  // Destroys now in DO_DEFERRED_RELEASE builds
+    
+    // Registration survives a table reset once repeated
+    do_string_intern_cleanup();
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, DO_REGISTER_KEYS(test_keys));
+    TEST_ASSERT_EQUAL_PTR(do_string_find_interned("height"), DO_KEY(height));
+}
+
 /* =============================================================================
  * PROTOTYPE CHAIN TESTS
  * ============================================================================= */
@@ -512,6 +940,1324 @@ void test_linear_to_hash_upgrade(void) {
     do_release(&obj);
 }
 
+void test_hash_delete_churn(void) {
+    do_object obj = create_test_object();
+    char key[32];
+    for (int i = 0; i < 40; i++) {
+        snprintf(key, sizeof(key), "stable_%d", i);
+        DO_SET(obj, key, i);
+    }
+    TEST_ASSERT_TRUE(obj->is_hashed);
+    
+    // Every cycle leaves a deleted control byte; lookups of absent keys
+    // must still find an empty slot to stop at
+    for (int i = 0; i < 2000; i++) {
+        snprintf(key, sizeof(key), "tmp_%d", i);
+        DO_SET(obj, key, i);
+        TEST_ASSERT_TRUE(do_delete(obj, key));
+        TEST_ASSERT_FALSE(do_has(obj, key));
+    }
+    const do_hash_table_t* table = obj->properties.table;
+    uint32_t empty = 0;
+    for (uint32_t i = 0; i < table->capacity; i++) empty += table->ctrl[i] == DO_CTRL_EMPTY;
+    TEST_ASSERT_TRUE(empty >= table->capacity / 8);
+    TEST_ASSERT_EQUAL_INT(40, obj->property_count);
+    TEST_ASSERT_EQUAL_INT(39, DO_GET(obj, "stable_39", int));
+    TEST_ASSERT_TRUE(table->capacity <= 128);  // Rebuilt, not grown without bound
+    
+    do_release(&obj);
+}
+
+void test_hash_downgrade_and_compact(void) {
+    do_object obj = create_test_object();
+    char key[32];
+    for (int i = 0; i < 8 * DO_HASH_THRESHOLD; i++) {
+        snprintf(key, sizeof(key), "queue_%d", i);
+        DO_SET(obj, key, i);
+    }
+    TEST_ASSERT_TRUE(obj->is_hashed);
+    size_t full = do_memory_usage(obj, DO_MEMORY_OWN);
+    
+    // Draining the table shrinks it, then moves the rest back to slots
+    int left = DO_HASH_DOWNGRADE_THRESHOLD + 1;
+    for (int i = 0; i < 8 * DO_HASH_THRESHOLD - left; i++) {
+        snprintf(key, sizeof(key), "queue_%d", i);
+        TEST_ASSERT_TRUE(do_delete(obj, key));
+        if (obj->property_count == DO_HASH_THRESHOLD) {
+            TEST_ASSERT_TRUE(obj->is_hashed);  // Hysteresis: still well above the downgrade point
+            TEST_ASSERT_TRUE(do_memory_usage(obj, DO_MEMORY_OWN) < full);
+        }
+    }
+    TEST_ASSERT_TRUE(obj->is_hashed);
+    snprintf(key, sizeof(key), "queue_%d", 8 * DO_HASH_THRESHOLD - left);
+    TEST_ASSERT_TRUE(do_delete(obj, key));
+    TEST_ASSERT_FALSE(obj->is_hashed);
+    TEST_ASSERT_EQUAL_INT(left - 1, obj->property_count);
+    
+    // Survivors keep their values and insertion order
+    do_iter_t it;
+    do_iter_init(&it, obj, DO_ITER_OWN);
+    for (int i = 8 * DO_HASH_THRESHOLD - left + 1; i < 8 * DO_HASH_THRESHOLD; i++) {
+        TEST_ASSERT_TRUE(do_iter_next(&it));
+        snprintf(key, sizeof(key), "queue_%d", i);
+        TEST_ASSERT_EQUAL_STRING(key, it.key);
+        TEST_ASSERT_EQUAL_INT(i, *(int*)it.value);
+    }
+    TEST_ASSERT_FALSE(do_iter_next(&it));
+    
+    // do_compact fits slots exactly and takes mid-sized tables back to slots
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_compact(obj));
+    TEST_ASSERT_EQUAL_INT(obj->property_count, obj->slot_capacity);
+    for (int i = 0; i < DO_HASH_THRESHOLD + 4; i++) {
+        snprintf(key, sizeof(key), "again_%d", i);
+        DO_SET(obj, key, i);
+    }
+    TEST_ASSERT_TRUE(obj->is_hashed);
+    for (int i = 0; i < 8; i++) {
+        snprintf(key, sizeof(key), "again_%d", i);
+        do_delete(obj, key);
+    }
+    TEST_ASSERT_TRUE(obj->is_hashed);
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_compact(obj));
+    TEST_ASSERT_FALSE(obj->is_hashed);
+    TEST_ASSERT_EQUAL_INT(DO_HASH_THRESHOLD, obj->property_count);
+    snprintf(key, sizeof(key), "again_%d", DO_HASH_THRESHOLD + 3);
+    TEST_ASSERT_EQUAL_INT(DO_HASH_THRESHOLD + 3, DO_GET(obj, key, int));
+    
+    do_release(&obj);
+}
+
+void test_shapes_shared_by_key_order(void) {
+    do_object a = create_test_object();
+    do_object b = create_test_object();
+    do_object c = create_test_object();
+    int x = 1, y = 2;
+    
+    DO_SET(a, "x", x);
+    DO_SET(a, "y", y);
+    DO_SET(b, "x", x + 10);
+    DO_SET(b, "y", y + 10);
+    DO_SET(c, "y", y);
+    DO_SET(c, "x", x);
+    
+    // Same keys in the same order share one layout; other orders do not
+    TEST_ASSERT_FALSE(a->is_hashed);
+    TEST_ASSERT_EQUAL_PTR(a->shape, b->shape);
+    TEST_ASSERT_NOT_EQUAL(a->shape, c->shape);
+    TEST_ASSERT_EQUAL_INT(2, a->shape->slot_count);
+    TEST_ASSERT_EQUAL_INT(11, DO_GET(b, "x", int));
+    TEST_ASSERT_EQUAL_INT(2, DO_GET(c, "y", int));
+    
+    // Updating a value keeps the shape
+    do_shape_t* before = a->shape;
+    DO_SET(a, "x", 100);
+    TEST_ASSERT_EQUAL_PTR(before, a->shape);
+    TEST_ASSERT_EQUAL_INT(100, DO_GET(a, "x", int));
+    
+    do_release(&a);
+    do_release(&b);
+    do_release(&c);
+}
+
+void test_property_table_large(void) {
+    enum { COUNT = 5000 };
+    do_object obj = create_managed_object();
+    char key[32];
+    for (int i = 0; i < COUNT; i++) {
+        snprintf(key, sizeof(key), "global_%d", i);
+        DO_SET(obj, key, i);
+    }
+    TEST_ASSERT_TRUE(obj->is_hashed);
+    TEST_ASSERT_EQUAL_INT(COUNT, do_property_count(obj));
+    
+    // Delete every third key, then check hits, misses and tombstone reuse
+    for (int i = 0; i < COUNT; i += 3) {
+        snprintf(key, sizeof(key), "global_%d", i);
+        TEST_ASSERT_EQUAL_INT(1, do_delete(obj, key));
+    }
+    TEST_ASSERT_EQUAL_INT((COUNT * 2) / 3, do_property_count(obj));
+    for (int i = 0; i < COUNT; i++) {
+        snprintf(key, sizeof(key), "global_%d", i);
+        if (i % 3 == 0) {
+            TEST_ASSERT_FALSE(do_has_own(obj, key));
+        } else {
+            TEST_ASSERT_EQUAL_INT(i, DO_GET(obj, key, int));
+        }
+    }
+    for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < COUNT; i += 3) {
+            snprintf(key, sizeof(key), "global_%d", i);
+            DO_SET(obj, key, -i);
+            TEST_ASSERT_EQUAL_INT(1, do_delete(obj, key));
+        }
+    }
+    
+    // Iteration keeps insertion order and skips deleted entries
+    DO_SET(obj, "global_0", 0);
+    const char** keys = do_get_own_keys(obj);
+    TEST_ASSERT_EQUAL_INT(do_property_count(obj), (int)arrlen(keys));
+    TEST_ASSERT_EQUAL_STRING("global_1", keys[0]);
+    TEST_ASSERT_EQUAL_STRING("global_2", keys[1]);
+    TEST_ASSERT_EQUAL_STRING("global_4", keys[2]);
+    TEST_ASSERT_EQUAL_STRING("global_0", keys[arrlen(keys) - 1]);
+    arrfree(keys);
+    
+    reset_release_counter();
+    int live = do_property_count(obj);
+    do_release(&obj);
+    do_drain_releases(SIZE_MAX);  // Destroys now in DO_DEFERRED_RELEASE builds
+    TEST_ASSERT_EQUAL_INT(live, release_call_count);
+}
+
+void test_shapes_lookup_every_slot(void) {
+    // The slot scan works in vector-width steps plus a scalar tail, so check
+    // hits at every position and misses for every layout width
+    do_object obj = create_test_object();
+    const char* keys[DO_HASH_THRESHOLD + 1];
+    char name[32];
+    for (int count = 0; count <= DO_HASH_THRESHOLD; count++) {
+        for (int i = 0; i < count; i++) {
+            TEST_ASSERT_EQUAL_INT(i, *(int*)do_get_interned(obj, keys[i]));
+        }
+        TEST_ASSERT_NULL(do_get(obj, "absent"));
+        
+        snprintf(name, sizeof(name), "slot_%d", count);
+        keys[count] = do_string_intern(name);
+        DO_SET(obj, name, count);
+    }
+    TEST_ASSERT_FALSE(obj->is_hashed);
+    
+    do_release(&obj);
+}
+
+void test_shapes_delete_transitions(void) {
+    do_object obj = create_managed_object();
+    do_object expected = create_test_object();
+    int v1 = 1, v2 = 2, v3 = 3;
+    
+    do_set(obj, "a", &v1, sizeof(v1));
+    do_shape_t* shape_a = obj->shape;
+    do_set(obj, "b", &v2, sizeof(v2));
+    do_set(obj, "c", &v3, sizeof(v3));
+    
+    // Deleting the newest key returns to the parent layout
+    TEST_ASSERT_EQUAL_INT(1, do_delete(obj, "c"));
+    TEST_ASSERT_EQUAL_INT(3, last_released_value);
+    TEST_ASSERT_EQUAL_PTR(shape_a, obj->shape->parent);
+    
+    // Deleting an older key compacts slots onto the shape of the rest
+    do_set(obj, "c", &v3, sizeof(v3));
+    TEST_ASSERT_EQUAL_INT(1, do_delete(obj, "a"));
+    do_set(expected, "b", &v2, sizeof(v2));
+    do_set(expected, "c", &v3, sizeof(v3));
+    TEST_ASSERT_EQUAL_PTR(expected->shape, obj->shape);
+    TEST_ASSERT_FALSE(obj->is_hashed);
+    TEST_ASSERT_NULL(do_get(obj, "a"));
+    TEST_ASSERT_EQUAL_INT(2, DO_GET(obj, "b", int));
+    TEST_ASSERT_EQUAL_INT(3, DO_GET(obj, "c", int));
+    TEST_ASSERT_EQUAL_INT(2, do_property_count(obj));
+    
+    do_release(&obj);
+    do_release(&expected);
+}
+
+void test_shapes_megamorphic_fallback(void) {
+    enum { NUM_OBJECTS = DO_SHAPE_MAX_TRANSITIONS + 1 };
+    do_object objects[NUM_OBJECTS];
+    char key[32];
+    
+    // Every object shares "base" and then adds a distinct key
+    for (int i = 0; i < NUM_OBJECTS; i++) {
+        objects[i] = create_test_object();
+        DO_SET(objects[i], "base", i);
+        snprintf(key, sizeof(key), "unique_%d", i);
+        DO_SET(objects[i], key, i);
+    }
+    
+    for (int i = 0; i < DO_SHAPE_MAX_TRANSITIONS; i++) {
+        TEST_ASSERT_FALSE(objects[i]->is_hashed);
+    }
+    
+    // The transition that would exceed the fan-out limit goes to dictionary mode
+    do_object last = objects[NUM_OBJECTS - 1];
+    TEST_ASSERT_TRUE(last->is_hashed);
+    TEST_ASSERT_EQUAL_INT(NUM_OBJECTS - 1, DO_GET(last, "base", int));
+    snprintf(key, sizeof(key), "unique_%d", NUM_OBJECTS - 1);
+    TEST_ASSERT_EQUAL_INT(NUM_OBJECTS - 1, DO_GET(last, key, int));
+    
+    for (int i = 0; i < NUM_OBJECTS; i++) {
+        do_release(&objects[i]);
+    }
+}
+
+void test_inline_cache_own_and_inherited(void) {
+    do_object base = create_test_object();
+    do_object mid = do_create_with_prototype(base, NULL);
+    do_object obj = do_create_with_prototype(mid, NULL);
+    const char* method = do_string_intern("method");
+    const char* field = do_string_intern("field");
+    do_ic_t method_ic = DO_IC_INIT;
+    do_ic_t field_ic = DO_IC_INIT;
+    
+    DO_SET(base, "method", 7);
+    DO_SET(obj, "field", 1);
+    
+    // First lookups miss and fill the caches, repeats hit
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_INT(7, *(int*)do_get_cached(obj, method, &method_ic));
+        TEST_ASSERT_EQUAL_INT(1, *(int*)do_get_cached(obj, field, &field_ic));
+    }
+    TEST_ASSERT_EQUAL_UINT(1, method_ic.misses);
+    TEST_ASSERT_EQUAL_UINT(2, method_ic.hits);
+    TEST_ASSERT_EQUAL_PTR(base, method_ic.holder);
+    TEST_ASSERT_EQUAL_UINT(2, field_ic.hits);
+    
+    // Shadowing in the middle of the chain bumps the prototype epoch and misses
+    DO_SET(mid, "method", 8);
+    TEST_ASSERT_EQUAL_INT(8, *(int*)do_get_cached(obj, method, &method_ic));
+    TEST_ASSERT_EQUAL_UINT(2, method_ic.misses);
+    TEST_ASSERT_EQUAL_INT(8, *(int*)do_get_cached(obj, method, &method_ic));
+    TEST_ASSERT_EQUAL_UINT(3, method_ic.hits);
+    
+    // Value updates keep the layout, so cached slots see the new value
+    DO_SET(mid, "method", 9);
+    TEST_ASSERT_EQUAL_INT(9, *(int*)do_get_cached(obj, method, &method_ic));
+    TEST_ASSERT_EQUAL_UINT(4, method_ic.hits);
+    
+    // A different receiver with the same layout hits the same cache
+    do_object other = do_create_with_prototype(mid, NULL);
+    DO_SET(other, "field", 2);
+    TEST_ASSERT_EQUAL_INT(2, *(int*)do_get_cached(other, field, &field_ic));
+    TEST_ASSERT_EQUAL_UINT(3, field_ic.hits);
+    
+    // Missing keys are reported, not cached
+    do_ic_t missing_ic = DO_IC_INIT;
+    TEST_ASSERT_NULL(do_get_cached(obj, do_string_intern("missing"), &missing_ic));
+    
+    // Linking, cloning and re-linking objects no chain runs through leaves
+    // inherited entries valid
+    uint64_t epoch = proto_epoch();
+    size_t misses = method_ic.misses;
+    for (int i = 0; i < 4; i++) {
+        do_object instance = do_create_with_prototype(mid, NULL);
+        DO_SET(instance, "field", i);  // Same layout as obj
+        do_object copy = do_clone(instance);
+        TEST_ASSERT_EQUAL_INT(9, *(int*)do_get_cached(instance, method, &method_ic));
+        TEST_ASSERT_EQUAL_INT(9, *(int*)do_get_cached(copy, method, &method_ic));
+        do_release(&copy);
+        do_release(&instance);
+    }
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_prototype(other, base));
+    TEST_ASSERT_EQUAL_INT(9, *(int*)do_get_cached(obj, method, &method_ic));
+    TEST_ASSERT_EQUAL_UINT(misses, method_ic.misses);
+    TEST_ASSERT_TRUE(epoch == proto_epoch());
+    
+    // Re-linking a prototype changes its heirs' chains
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_prototype(mid, NULL));
+    TEST_ASSERT_TRUE(epoch != proto_epoch());
+    TEST_ASSERT_EQUAL_INT(9, *(int*)do_get_cached(obj, method, &method_ic));
+    TEST_ASSERT_EQUAL_UINT(misses + 1, method_ic.misses);
+    
+    do_release(&other);
+    do_release(&obj);
+    do_release(&mid);
+    do_release(&base);
+}
+
+void test_inline_cache_set_and_hashed(void) {
+    do_object obj = create_managed_object();
+    const char* counter = do_string_intern("counter");
+    do_ic_t set_ic = DO_IC_INIT;
+    do_ic_t get_ic = DO_IC_INIT;
+    
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_cached(obj, counter, &i, sizeof(i), &set_ic));
+    }
+    TEST_ASSERT_EQUAL_INT(4, DO_GET(obj, "counter", int));
+    TEST_ASSERT_EQUAL_UINT(1, set_ic.misses);
+    TEST_ASSERT_EQUAL_UINT(4, set_ic.hits);
+    TEST_ASSERT_EQUAL_INT(4, release_call_count);  // Each overwrite released the old value
+    
+    // Hashed objects always take the full lookup but stay correct
+    char key[32];
+    for (int i = 0; i <= DO_HASH_THRESHOLD + 1; i++) {
+        snprintf(key, sizeof(key), "filler_%d", i);
+        DO_SET(obj, key, i);
+    }
+    TEST_ASSERT_TRUE(obj->is_hashed);
+    int value = 42;
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_cached(obj, counter, &value, sizeof(value), &set_ic));
+    TEST_ASSERT_EQUAL_INT(42, *(int*)do_get_cached(obj, counter, &get_ic));
+    TEST_ASSERT_EQUAL_INT(42, *(int*)do_get_cached(obj, counter, &get_ic));
+    TEST_ASSERT_EQUAL_UINT(0, get_ic.hits);
+    TEST_ASSERT_EQUAL_UINT(2, get_ic.misses);
+    
+    do_release(&obj);
+}
+
+#if DO_POOL_ALLOCATOR
+void test_pool_allocator_reuse(void) {
+    // A released header and its property blocks are handed straight back
+    // to the next object of the same shape
+    do_object first = do_create(NULL);
+    char big[48] = "pooled heap value";
+    DO_SET(first, "x", 1);
+    do_set(first, "big", big, sizeof(big));
+    do_object first_addr = first;
+    void* first_big = do_get(first, "big");
+    do_release(&first);
+    do_drain_releases(SIZE_MAX);  // Destroys now in DO_DEFERRED_RELEASE builds
+    
+    do_object second = do_create(NULL);
+    TEST_ASSERT_EQUAL_PTR(first_addr, second);
+    DO_SET(second, "x", 2);
+    do_set(second, "big", big, sizeof(big));
+    TEST_ASSERT_EQUAL_PTR(first_big, do_get(second, "big"));
+    TEST_ASSERT_EQUAL_STRING("pooled heap value", (const char*)do_get(second, "big"));
+    TEST_ASSERT_EQUAL_INT(2, DO_GET(second, "x", int));
+    
+    // Values above DO_POOL_MAX_BLOCK bypass the pool but still round-trip
+    char* huge = (char*)calloc(DO_POOL_MAX_BLOCK * 2, 1);
+    huge[DO_POOL_MAX_BLOCK] = 'z';
+    do_set(second, "huge", huge, DO_POOL_MAX_BLOCK * 2);
+    TEST_ASSERT_EQUAL_CHAR('z', ((char*)do_get(second, "huge"))[DO_POOL_MAX_BLOCK]);
+    free(huge);
+    
+    do_release(&second);
+    do_pool_trim();
+}
+#endif
+
+#if DO_STATS
+void test_stats_counters(void) {
+    do_stats_t before, after;
+    do_object proto = create_test_object();
+    DO_SET(proto, "inherited", 1);
+    do_object child = do_create_with_prototype(proto, NULL);
+    DO_SET(child, "own", 2);
+    const char* own = do_string_intern("own");
+    const char* inherited = do_string_intern("inherited");
+    const char* missing = do_string_intern("stats_missing");
+    
+    do_stats_reset();
+    do_stats_snapshot(&before);
+    TEST_ASSERT_EQUAL_UINT64(0, before.gets);
+    
+    TEST_ASSERT_NOT_NULL(do_get_interned(child, own));
+    TEST_ASSERT_NOT_NULL(do_get_interned(child, inherited));
+    TEST_ASSERT_NULL(do_get_interned(child, missing));
+    do_stats_snapshot(&after);
+    TEST_ASSERT_EQUAL_UINT64(3, after.gets);
+    TEST_ASSERT_EQUAL_UINT64(1, after.get_own_hits);
+    TEST_ASSERT_EQUAL_UINT64(1, after.get_proto_hits);
+    TEST_ASSERT_EQUAL_UINT64(1, after.get_misses);
+    TEST_ASSERT_EQUAL_UINT64(2, after.chain_walks[0]);  // One level each, cached or not
+    
+    // Upgrading to a property table, and objects and bytes coming and going
+    do_object large = do_create(NULL);
+    char key[32];
+    for (int i = 0; i < DO_HASH_THRESHOLD + 2; i++) {
+        snprintf(key, sizeof(key), "stats_%d", i);
+        DO_SET(large, key, i);
+    }
+    do_stats_snapshot(&after);
+    TEST_ASSERT_EQUAL_UINT64(1, after.hash_upgrades);
+    TEST_ASSERT_EQUAL_UINT64(DO_HASH_THRESHOLD + 2, after.sets);
+    TEST_ASSERT_EQUAL_UINT64(1, after.objects_created);
+    TEST_ASSERT_EQUAL_UINT64(before.live_objects + 1, after.live_objects);
+    TEST_ASSERT_TRUE(after.live_bytes > before.live_bytes);
+    TEST_ASSERT_TRUE(after.intern_inserts >= DO_HASH_THRESHOLD + 2);
+    TEST_ASSERT_EQUAL_UINT64(before.intern_strings + after.intern_inserts, after.intern_strings);
+    
+    do_release(&large);
+    do_drain_releases(SIZE_MAX);  // Destroys now in DO_DEFERRED_RELEASE builds
+    do_stats_snapshot(&after);
+    TEST_ASSERT_EQUAL_UINT64(1, after.objects_destroyed);
+    TEST_ASSERT_EQUAL_UINT64(before.live_objects, after.live_objects);
+    TEST_ASSERT_EQUAL_UINT64(before.live_bytes, after.live_bytes);
+    TEST_ASSERT_EQUAL_UINT64(after.bytes_allocated, after.bytes_freed);
+    
+    // Reset clears events, not gauges
+    do_stats_reset();
+    do_stats_snapshot(&after);
+    TEST_ASSERT_EQUAL_UINT64(0, after.gets);
+    TEST_ASSERT_EQUAL_UINT64(0, after.hash_upgrades);
+    TEST_ASSERT_EQUAL_UINT64(before.live_objects, after.live_objects);
+    
+    do_release(&child);
+    do_release(&proto);
+}
+#endif
+
+void test_clone_copy_on_write(void) {
+    do_object proto = create_test_object();
+    DO_SET(proto, "kind", 1);
+    do_object source = do_create_with_prototype(proto, test_release_fn);
+    char payload[64] = "shared until written";
+    DO_SET(source, "a", 10);
+    DO_SET(source, "b", 20);
+    do_set(source, "payload", payload, sizeof(payload));
+    
+    // Clones share storage, layout and prototype with the source
+    do_object clone = do_clone(source);
+    do_object other = do_clone(source);
+    TEST_ASSERT_NOT_NULL(clone);
+    TEST_ASSERT_EQUAL_PTR(source->properties.slots, clone->properties.slots);
+    TEST_ASSERT_EQUAL_PTR(source->shape, clone->shape);
+    TEST_ASSERT_EQUAL_PTR(proto, do_get_prototype(clone));
+    TEST_ASSERT_EQUAL_INT(1, DO_GET(clone, "kind", int));
+    TEST_ASSERT_EQUAL_INT(20, DO_GET(clone, "b", int));
+    TEST_ASSERT_EQUAL_INT(3, do_property_count(clone));
+    
+    // The first write takes a private copy; the others are unaffected
+    DO_SET(clone, "a", 11);
+    TEST_ASSERT_TRUE(source->properties.slots != clone->properties.slots);
+    TEST_ASSERT_EQUAL_INT(11, DO_GET(clone, "a", int));
+    TEST_ASSERT_EQUAL_INT(10, DO_GET(source, "a", int));
+    TEST_ASSERT_EQUAL_INT(10, DO_GET(other, "a", int));
+    TEST_ASSERT_EQUAL_STRING(payload, (const char*)do_get(clone, "payload"));
+    TEST_ASSERT_TRUE(do_get(clone, "payload") != do_get(source, "payload"));
+    TEST_ASSERT_EQUAL_INT(1, release_call_count);  // Only the clone's old "a"
+    
+    // Deletes and writable pointers copy too
+    TEST_ASSERT_EQUAL_INT(1, do_delete(other, "b"));
+    TEST_ASSERT_TRUE(do_has_own(source, "b"));
+    *(int*)do_get_mut(source, "a") = 12;
+    TEST_ASSERT_EQUAL_INT(12, DO_GET(source, "a", int));
+    
+    // Shared storage is released once, by whichever clone lets go last
+    do_object unmodified = do_clone(source);
+    reset_release_counter();
+    do_release(&source);
+    TEST_ASSERT_EQUAL_INT(0, release_call_count);
+    do_release(&unmodified);
+    do_drain_releases(SIZE_MAX);  // Destroys now in DO_DEFERRED_RELEASE builds
+    TEST_ASSERT_EQUAL_INT(3, release_call_count);
+    
+    // Hashed storage is shared the same way
+    do_object big = create_test_object();
+    char key[32];
+    for (int i = 0; i <= DO_HASH_THRESHOLD + 1; i++) {
+        snprintf(key, sizeof(key), "field_%d", i);
+        DO_SET(big, key, i);
+    }
+    do_object big_clone = do_clone(big);
+    TEST_ASSERT_TRUE(big_clone->is_hashed);
+    TEST_ASSERT_EQUAL_INT(3, DO_GET(big_clone, "field_3", int));
+    DO_SET(big, "field_3", 33);
+    TEST_ASSERT_EQUAL_INT(3, DO_GET(big_clone, "field_3", int));
+    TEST_ASSERT_EQUAL_INT(33, DO_GET(big, "field_3", int));
+    
+    // Arena objects are copied to the heap right away
+    do_arena arena = do_arena_create(0);
+    do_object scratch = do_arena_create_object(arena, proto);
+    DO_SET(scratch, "x", 5);
+    do_object kept = do_clone(scratch);
+    do_arena_destroy(&arena);
+    TEST_ASSERT_EQUAL_INT(5, DO_GET(kept, "x", int));
+    TEST_ASSERT_EQUAL_INT(1, DO_GET(kept, "kind", int));
+    
+    do_release(&kept);
+    do_release(&big_clone);
+    do_release(&big);
+    do_release(&other);
+    do_release(&clone);
+    do_release(&proto);
+}
+
+void test_freeze_objects(void) {
+    reset_release_counter();
+    do_object base = do_create(test_release_fn);
+    DO_SET(base, "kind", 1);
+    do_object proto = do_create_with_prototype(base, test_release_fn);
+    DO_SET(proto, "size", 2);
+    do_object chain_ref = proto;
+    do_freeze(proto, DO_FREEZE_PROTOTYPES);
+    TEST_ASSERT_TRUE(do_is_frozen(proto));
+    TEST_ASSERT_TRUE(do_is_frozen(base));
+    
+    // Reference counts stand still, and releasing does not free
+    int count = do_get_ref_count(proto);
+    TEST_ASSERT_EQUAL_PTR(proto, do_retain(proto));
+    do_release(&chain_ref);
+    do_release(&base);
+    TEST_ASSERT_NULL(chain_ref);
+    TEST_ASSERT_EQUAL_INT(count, do_get_ref_count(proto));
+    TEST_ASSERT_EQUAL_INT(1, DO_GET(proto, "kind", int));
+    
+    // Every way of writing is refused
+    int value = 3;
+    const char* size_key = do_string_intern("size");
+    const void* values[] = { &value };
+    size_t sizes[] = { sizeof(value) };
+    do_ic_t ic = { 0 };
+    TEST_ASSERT_EQUAL_INT(DO_ERROR_FROZEN, do_set(proto, "size", &value, sizeof(value)));
+    TEST_ASSERT_EQUAL_INT(DO_ERROR_FROZEN, do_set(proto, "new", &value, sizeof(value)));
+    TEST_ASSERT_EQUAL_INT(DO_ERROR_FROZEN, do_set_many(proto, &size_key, values, sizes, 1));
+    TEST_ASSERT_EQUAL_INT(DO_ERROR_FROZEN, do_set_cached(proto, size_key, &value, sizeof(value), &ic));
+    TEST_ASSERT_EQUAL_INT(DO_ERROR_FROZEN, do_set_prototype(proto, NULL));
+    TEST_ASSERT_NULL(do_set_reserve(proto, "size", sizeof(int)));
+    TEST_ASSERT_NULL(do_get_mut(proto, "size"));
+    TEST_ASSERT_EQUAL_INT(0, do_delete(proto, "size"));
+    TEST_ASSERT_EQUAL_INT(0, do_delete_many(proto, &size_key, 1));
+    TEST_ASSERT_EQUAL_INT(2, DO_GET(proto, "size", int));
+    TEST_ASSERT_EQUAL_INT(1, do_property_count(proto));
+    
+    // Objects built on it, and copies of it, stay ordinary
+    do_object instance = do_create_with_prototype(proto, NULL);
+    do_object copy = do_clone(proto);
+    TEST_ASSERT_FALSE(do_is_frozen(instance));
+    TEST_ASSERT_FALSE(do_is_frozen(copy));
+    TEST_ASSERT_EQUAL_INT(1, DO_GET(instance, "kind", int));
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set(copy, "size", &value, sizeof(value)));
+    TEST_ASSERT_EQUAL_INT(3, DO_GET(copy, "size", int));
+    TEST_ASSERT_EQUAL_INT(2, DO_GET(proto, "size", int));
+    TEST_ASSERT_EQUAL_INT(1, release_call_count);  // The copy's own "size"
+    do_release(&instance);
+    do_release(&copy);
+    do_drain_releases(SIZE_MAX);  // Destroys now in DO_DEFERRED_RELEASE builds
+    TEST_ASSERT_EQUAL_INT(count, do_get_ref_count(proto));
+    
+    // Frozen objects are only freed at cleanup, values released first
+    reset_release_counter();
+    do_frozen_cleanup();
+    TEST_ASSERT_EQUAL_INT(2, release_call_count);
+}
+
+void test_batch_set_get_delete(void) {
+    do_object obj = create_managed_object();
+    const char* keys[20];
+    const void* values[20];
+    size_t sizes[20];
+    int numbers[20];
+    char name[32];
+    for (int i = 0; i < 20; i++) {
+        snprintf(name, sizeof(name), "batch_%d", i);
+        keys[i] = do_string_intern(name);
+        numbers[i] = i * 10;
+        values[i] = &numbers[i];
+        sizes[i] = sizeof(int);
+    }
+    
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_many(obj, keys, values, sizes, 5));
+    TEST_ASSERT_FALSE(obj->is_hashed);
+    TEST_ASSERT_EQUAL_INT(5, obj->property_count);
+    
+    // Lookups fill NULL for missing keys and see inherited ones
+    do_object child = do_create_with_prototype(obj, NULL);
+    DO_SET(child, "batch_7", 7);
+    void* found[8];
+    TEST_ASSERT_EQUAL_INT(6, do_get_many(child, keys, found, 8));
+    TEST_ASSERT_EQUAL_INT(40, *(int*)found[4]);
+    TEST_ASSERT_NULL(found[5]);
+    TEST_ASSERT_EQUAL_INT(7, *(int*)found[7]);
+    
+    // Deleting ignores missing and repeated keys and rebuilds the layout once
+    const char* doomed[] = { keys[1], keys[3], keys[1], keys[9] };
+    TEST_ASSERT_EQUAL_INT(2, do_delete_many(obj, doomed, 4));
+    TEST_ASSERT_EQUAL_INT(2, release_call_count);
+    TEST_ASSERT_EQUAL_INT(3, obj->property_count);
+    TEST_ASSERT_EQUAL_INT(0, DO_GET(obj, "batch_0", int));
+    TEST_ASSERT_EQUAL_INT(20, DO_GET(obj, "batch_2", int));
+    TEST_ASSERT_EQUAL_INT(40, DO_GET(obj, "batch_4", int));
+    TEST_ASSERT_FALSE(do_has_own(obj, "batch_3"));
+    
+    do_object same = create_test_object();
+    DO_SET(same, "batch_0", 0);
+    DO_SET(same, "batch_2", 0);
+    DO_SET(same, "batch_4", 0);
+    TEST_ASSERT_EQUAL_PTR(same->shape, obj->shape);
+    
+    // A batch that crosses the threshold goes to hash storage up front
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_many(same, keys, values, sizes, 20));
+    TEST_ASSERT_TRUE(same->is_hashed);
+    TEST_ASSERT_EQUAL_INT(20, same->property_count);
+    TEST_ASSERT_EQUAL_INT(190, DO_GET(same, "batch_19", int));
+    TEST_ASSERT_EQUAL_INT(10, do_delete_many(same, keys + 10, 10));
+    TEST_ASSERT_EQUAL_INT(10, same->property_count);
+    
+    do_release(&same);
+    do_release(&child);
+    do_release(&obj);
+}
+
+void test_reserve_properties(void) {
+    do_object small = create_test_object();
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_reserve_properties(small, 8));
+    TEST_ASSERT_FALSE(small->is_hashed);
+    TEST_ASSERT_TRUE(small->slot_capacity >= 8);
+    
+    // Objects expected to outgrow slots get a table that needs no rebuild
+    do_object big = create_test_object();
+    DO_SET(big, "first", 0);
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_reserve_properties(big, 4 * DO_HASH_THRESHOLD));
+    TEST_ASSERT_TRUE(big->is_hashed);
+    do_hash_table_t* table = big->properties.table;
+    char key[32];
+    for (int i = 1; i < 4 * DO_HASH_THRESHOLD; i++) {
+        snprintf(key, sizeof(key), "reserved_%d", i);
+        DO_SET(big, key, i);
+    }
+    TEST_ASSERT_EQUAL_PTR(table, big->properties.table);
+    TEST_ASSERT_EQUAL_INT(4 * DO_HASH_THRESHOLD, big->property_count);
+    TEST_ASSERT_EQUAL_INT(0, DO_GET(big, "first", int));
+    
+    do_freeze(small, 0);
+    TEST_ASSERT_EQUAL_INT(DO_ERROR_FROZEN, do_reserve_properties(small, 32));
+    do_release(&big);
+}
+
+#if DO_TAGGED_VALUES
+static int tagged_release_calls = 0;
+
+static void count_tagged_release(void* value) {
+    (void)value;
+    tagged_release_calls++;
+}
+
+void test_tagged_values(void) {
+    tagged_release_calls = 0;
+    do_object obj = do_create(count_tagged_release);
+    const char* count = do_string_intern("count");
+    const char* ratio = do_string_intern("ratio");
+    const char* handle = do_string_intern("handle");
+    const char* child_key = do_string_intern("child");
+    
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_i64(obj, count, INT64_MIN));
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_f64(obj, ratio, 0.25));
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_ptr(obj, handle, &tagged_release_calls));
+    int64_t i = 0;
+    double f = 0;
+    TEST_ASSERT_TRUE(do_get_i64(obj, count, &i));
+    TEST_ASSERT_TRUE(i == INT64_MIN);
+    TEST_ASSERT_TRUE(do_get_f64(obj, ratio, &f));
+    TEST_ASSERT_TRUE(f == 0.25);
+    TEST_ASSERT_EQUAL_PTR(&tagged_release_calls, do_get_ptr(obj, handle));
+    TEST_ASSERT_EQUAL_INT(DO_TYPE_F64, do_get_type(obj, ratio));
+    
+    // Reading with the wrong type misses rather than reinterpreting
+    TEST_ASSERT_FALSE(do_get_f64(obj, count, &f));
+    TEST_ASSERT_FALSE(do_get_i64(obj, handle, &i));
+    TEST_ASSERT_NULL(do_get_obj(obj, handle));
+    TEST_ASSERT_EQUAL_INT(DO_TYPE_NONE, do_get_type(obj, child_key));
+    
+    // Object values hold a reference until overwritten or deleted
+    do_object child = create_test_object();
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_obj(obj, child_key, child));
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_obj(obj, child_key, child));
+    TEST_ASSERT_EQUAL_PTR(child, do_get_obj(obj, child_key));
+    TEST_ASSERT_EQUAL_INT(2, do_get_ref_count(child));
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_i64(obj, child_key, 1));
+    do_drain_releases(SIZE_MAX);
+    TEST_ASSERT_EQUAL_INT(1, do_get_ref_count(child));
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_obj(obj, child_key, child));
+    TEST_ASSERT_TRUE(do_delete_interned(obj, child_key));
+    do_drain_releases(SIZE_MAX);
+    TEST_ASSERT_EQUAL_INT(1, do_get_ref_count(child));
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_obj(obj, child_key, child));
+    
+    // Tags are visible through prototypes and survive copy-on-write clones
+    do_object derived = do_create_with_prototype(obj, NULL);
+    TEST_ASSERT_TRUE(do_get_i64(derived, count, &i));
+    TEST_ASSERT_EQUAL_PTR(child, do_get_obj(derived, child_key));
+    do_object clone = do_clone(obj);
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_f64(clone, ratio, 0.5));  // Unshares
+    TEST_ASSERT_EQUAL_INT(3, do_get_ref_count(child));
+    TEST_ASSERT_EQUAL_PTR(child, do_get_obj(clone, child_key));
+    TEST_ASSERT_EQUAL_INT(DO_TYPE_I64, do_get_type(clone, count));
+    TEST_ASSERT_TRUE(do_get_f64(obj, ratio, &f));
+    TEST_ASSERT_TRUE(f == 0.25);
+    
+    do_release(&clone);
+    do_release(&derived);
+    do_release(&obj);
+    do_drain_releases(SIZE_MAX);
+    TEST_ASSERT_EQUAL_INT(1, do_get_ref_count(child));
+    TEST_ASSERT_EQUAL_INT(0, tagged_release_calls);  // Typed values bypass release_fn
+    
+    // The arena holds one reference per stored heap object until teardown,
+    // however often arena objects store, overwrite or delete it
+    do_arena arena = do_arena_create(0);
+    do_object pinned = do_arena_create_object(arena, NULL);
+    do_object other = do_arena_create_object(arena, NULL);
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_obj(pinned, child_key, child));
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_obj(other, child_key, child));
+    TEST_ASSERT_EQUAL_INT(2, do_get_ref_count(child));
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_i64(pinned, child_key, 1));
+    TEST_ASSERT_TRUE(do_delete_interned(other, child_key));
+    TEST_ASSERT_EQUAL_INT(2, do_get_ref_count(child));
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_obj(pinned, child_key, child));
+    TEST_ASSERT_EQUAL_PTR(child, do_get_obj(pinned, child_key));
+    do_arena_reset(arena);
+    TEST_ASSERT_EQUAL_INT(1, do_get_ref_count(child));
+    pinned = do_arena_create_object(arena, NULL);
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_obj(pinned, child_key, child));
+    do_arena_destroy(&arena);
+    do_drain_releases(SIZE_MAX);
+    TEST_ASSERT_EQUAL_INT(1, do_get_ref_count(child));
+    do_release(&child);
+    
+    // Hashed objects keep tags too, and untyped writes clear them
+    do_object big = create_test_object();
+    char key[32];
+    for (int k = 0; k < DO_HASH_THRESHOLD + 4; k++) {
+        snprintf(key, sizeof(key), "typed_%d", k);
+        TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_i64(big, do_string_intern(key), k));
+    }
+    TEST_ASSERT_TRUE(big->is_hashed);
+    TEST_ASSERT_TRUE(do_get_i64(big, do_string_intern("typed_3"), &i));
+    TEST_ASSERT_TRUE(i == 3);
+    DO_SET(big, "typed_3", 3);
+    TEST_ASSERT_EQUAL_INT(DO_TYPE_BYTES, do_get_type(big, do_string_intern("typed_3")));
+    TEST_ASSERT_FALSE(do_get_i64(big, do_string_intern("typed_3"), &i));
+    do_release(&big);
+    
+#if DO_CYCLE_COLLECTOR
+    // Objects linked through object values are traced without a trace_fn
+    do_object a = create_test_object();
+    do_object b = create_test_object();
+    do_set_obj(a, child_key, b);
+    do_set_obj(b, child_key, a);
+    do_release(&a);
+    do_release(&b);
+    TEST_ASSERT_EQUAL_UINT(2, do_collect_cycles(SIZE_MAX));
+#endif
+}
+#endif
+
+typedef struct {
+    size_t live;
+    size_t limit;
+} test_tenant_t;
+
+static void* tenant_alloc(size_t size, void* context) {
+    test_tenant_t* tenant = (test_tenant_t*)context;
+    if (tenant->live + size > tenant->limit) return NULL;
+    tenant->live += size;
+    return malloc(size);
+}
+
+static void tenant_free(void* ptr, size_t size, void* context) {
+    ((test_tenant_t*)context)->live -= size;
+    free(ptr);
+}
+
+void test_allocator_hooks_and_memory_usage(void) {
+    test_tenant_t tenant = { 0, 1 << 20 };
+    do_allocator_t allocator = { tenant_alloc, NULL, tenant_free, &tenant };
+    
+    do_object proto = create_test_object();
+    DO_SET(proto, "shared", 1);
+    
+    TEST_ASSERT_NULL(do_set_allocator(&allocator));
+    do_object obj = do_create_with_prototype(proto, NULL);
+    DO_SET(obj, "small", 7);
+    char big[100] = "out of line";
+    do_set(obj, "big", big, sizeof(big));
+    TEST_ASSERT_EQUAL_PTR(&allocator, do_set_allocator(NULL));
+    
+    // Everything the object holds came from, and is reported to, the tenant
+    TEST_ASSERT_TRUE(tenant.live >= sizeof(do_object_t) + sizeof(big));
+    TEST_ASSERT_EQUAL_UINT(tenant.live, do_memory_usage(obj, DO_MEMORY_OWN));
+    TEST_ASSERT_EQUAL_UINT(do_memory_usage(obj, DO_MEMORY_OWN) + do_memory_usage(proto, DO_MEMORY_OWN),
+                           do_memory_usage(obj, DO_MEMORY_PROTOTYPES));
+    
+    // Growth into a property table and clones stay with the tenant
+    char key[32];
+    for (int i = 0; i < DO_HASH_THRESHOLD + 8; i++) {
+        snprintf(key, sizeof(key), "tenant_%d", i);
+        DO_SET(obj, key, i);
+    }
+    TEST_ASSERT_TRUE(obj->is_hashed);
+    TEST_ASSERT_EQUAL_UINT(tenant.live, do_memory_usage(obj, DO_MEMORY_OWN));
+    
+    do_object clone = do_clone(obj);
+    TEST_ASSERT_NOT_NULL(clone);
+    DO_SET(clone, "small", 8);  // Unshares into tenant memory
+    TEST_ASSERT_EQUAL_UINT(tenant.live, do_memory_usage(obj, DO_MEMORY_OWN) + do_memory_usage(clone, DO_MEMORY_OWN));
+    
+    // A quota refusal surfaces as an ordinary allocation failure
+    tenant.limit = tenant.live + 16;
+    char huge[256] = {0};
+    TEST_ASSERT_EQUAL_INT(DO_ERROR_MEMORY, do_set(obj, "huge", huge, sizeof(huge)));
+    TEST_ASSERT_FALSE(do_has_own(obj, "huge"));
+    TEST_ASSERT_EQUAL_INT(7, DO_GET(obj, "small", int));
+    
+    do_release(&clone);
+    do_release(&obj);
+    do_drain_releases(SIZE_MAX);  // Destroys now in DO_DEFERRED_RELEASE builds
+    TEST_ASSERT_EQUAL_UINT(0, tenant.live);
+    do_release(&proto);
+}
+
+#if DO_INTERN_CONTEXT
+void test_intern_context_sweep(void) {
+    const char* shared = do_string_intern("ctx_shared");
+    test_tenant_t tenant = { 0, 1 << 20 };
+    do_allocator_t allocator = { tenant_alloc, NULL, tenant_free, &tenant };
+    do_context ctx = do_context_create(&allocator);
+    TEST_ASSERT_NOT_NULL(ctx);
+    
+    TEST_ASSERT_NULL(do_context_bind(ctx));
+    do_object obj = do_create(NULL);
+    DO_SET(obj, "ctx_shared", 1);
+    DO_SET(obj, "ctx_dynamic", 2);
+    const char* dynamic = do_string_find_interned("ctx_dynamic");
+    TEST_ASSERT_EQUAL_PTR(ctx, do_context_bind(NULL));
+    
+    // Global keys are shared; the tenant's own keys stay out of the global table
+    TEST_ASSERT_EQUAL_PTR(shared, obj->shape->keys[0]);
+    TEST_ASSERT_EQUAL_PTR(dynamic, obj->shape->keys[1]);
+    TEST_ASSERT_NULL(do_string_find_interned("ctx_dynamic"));
+    TEST_ASSERT_EQUAL_INT(2, DO_GET_INTERNED(obj, dynamic, int));
+    
+    do_context_stats_t stats;
+    do_context_stats(ctx, &stats);
+    TEST_ASSERT_EQUAL_UINT(1, stats.keys);
+    TEST_ASSERT_TRUE(tenant.live >= sizeof(do_object_t) + stats.key_bytes);
+    
+    // Interning the same text globally later does not hide the tenant's copy
+    const char* global = do_string_intern("ctx_dynamic");
+    TEST_ASSERT_NOT_NULL(global);
+    TEST_ASSERT_TRUE(global != dynamic);
+    do_context_bind(ctx);
+    TEST_ASSERT_EQUAL_PTR(dynamic, do_string_intern("ctx_dynamic"));
+    TEST_ASSERT_EQUAL_PTR(dynamic, do_string_find_interned("ctx_dynamic"));
+    TEST_ASSERT_EQUAL_INT(2, DO_GET(obj, "ctx_dynamic", int));
+    TEST_ASSERT_EQUAL_PTR(shared, do_string_intern("ctx_shared"));
+    do_context_bind(NULL);
+    TEST_ASSERT_EQUAL_PTR(global, do_string_intern("ctx_dynamic"));
+    
+    // Hits and misses in the context never take its lock (holding it here
+    // would make a locked lookup spin forever)
+    do_context_bind(ctx);
+    do_spin_lock(&ctx->lock);
+    TEST_ASSERT_EQUAL_PTR(dynamic, do_string_intern("ctx_dynamic"));
+    TEST_ASSERT_EQUAL_PTR(shared, do_string_find_interned("ctx_shared"));
+    TEST_ASSERT_EQUAL_INT(1, DO_GET(obj, "ctx_shared", int));
+    TEST_ASSERT_NULL(do_string_find_interned("ctx_absent"));
+    do_spin_unlock(&ctx->lock);
+    do_context_bind(NULL);
+    
+    // Registered key tables are global even when registered by a tenant
+    do_context_bind(ctx);
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, DO_REGISTER_KEYS(test_keys));
+    TEST_ASSERT_EQUAL_PTR(ctx, do_context_bind(NULL));
+    TEST_ASSERT_EQUAL_PTR(do_string_find_interned("width"), DO_KEY(width));
+    do_context_stats(ctx, &stats);
+    TEST_ASSERT_EQUAL_UINT(1, stats.keys);
+    
+    // Keys stored in shapes or property tables survive any number of sweeps
+    do_context_bind(ctx);
+    do_object big = do_create(NULL);
+    char key[32];
+    for (int i = 0; i < DO_HASH_THRESHOLD + 4; i++) {
+        snprintf(key, sizeof(key), "ctx_key_%d", i);
+        DO_SET(big, key, i);
+    }
+    do_context_bind(NULL);
+    TEST_ASSERT_TRUE(big->is_hashed);
+    TEST_ASSERT_EQUAL_UINT(0, do_context_sweep(ctx));
+    TEST_ASSERT_EQUAL_UINT(0, do_context_sweep(ctx));
+    TEST_ASSERT_EQUAL_INT(2, DO_GET_INTERNED(obj, dynamic, int));
+    do_context_bind(ctx);
+    TEST_ASSERT_EQUAL_INT(DO_HASH_THRESHOLD + 3, DO_GET(big, key, int));
+    do_context_bind(NULL);
+    
+    // Unstored keys get one interval of grace after their last intern
+    do_context_bind(ctx);
+    TEST_ASSERT_NOT_NULL(do_string_intern("ctx_fresh"));
+    do_context_bind(NULL);
+    TEST_ASSERT_EQUAL_UINT(0, do_context_sweep(ctx));
+    TEST_ASSERT_EQUAL_UINT(1, do_context_sweep(ctx));
+    
+    do_release(&big);
+    do_release(&obj);
+    do_drain_releases(SIZE_MAX);  // Destroys now in DO_DEFERRED_RELEASE builds
+    TEST_ASSERT_EQUAL_UINT(DO_HASH_THRESHOLD + 5, do_context_sweep(ctx));
+    do_context_stats(ctx, &stats);
+    TEST_ASSERT_EQUAL_UINT(0, stats.keys);
+    TEST_ASSERT_EQUAL_UINT(0, stats.key_bytes);
+    TEST_ASSERT_EQUAL_UINT(DO_HASH_THRESHOLD + 6, stats.keys_reclaimed);
+    TEST_ASSERT_EQUAL_UINT(5, stats.sweeps);
+    
+    // Slices resolve in the context; sweeping part of a crowded table
+    // leaves the rest findable
+    do_context_bind(ctx);
+    const char* slice = do_string_intern_n("ctx_slice_tail", 9);
+    TEST_ASSERT_EQUAL_PTR(slice, do_string_find_interned("ctx_slice"));
+    do_object keep = do_create(NULL);
+    for (int i = 0; i < 300; i++) {
+        snprintf(key, sizeof(key), "ctx_crowd_%d", i);
+        if (i % 3 == 0) {
+            DO_SET(keep, key, i);
+        } else {
+            TEST_ASSERT_NOT_NULL(do_string_intern(key));
+        }
+    }
+    do_context_bind(NULL);
+    TEST_ASSERT_NULL(do_string_find_interned("ctx_slice"));
+    TEST_ASSERT_EQUAL_UINT(0, do_context_sweep(ctx));
+    TEST_ASSERT_EQUAL_UINT(201, do_context_sweep(ctx));
+    do_context_bind(ctx);
+    for (int i = 0; i < 300; i += 3) {
+        snprintf(key, sizeof(key), "ctx_crowd_%d", i);
+        TEST_ASSERT_NOT_NULL(do_string_find_interned(key));
+        TEST_ASSERT_EQUAL_INT(i, DO_GET(keep, key, int));
+    }
+    do_context_bind(NULL);
+    do_release(&keep);
+    do_drain_releases(SIZE_MAX);
+    
+    // Condemned strings outlive any sweep while a lookup's read section
+    // that began before them is still open
+    rcu_enter();
+    TEST_ASSERT_EQUAL_UINT(0, do_context_sweep(ctx));
+    TEST_ASSERT_EQUAL_UINT(100, do_context_sweep(ctx));
+    size_t pinned = tenant.live;
+    TEST_ASSERT_EQUAL_UINT(0, do_context_sweep(ctx));
+    TEST_ASSERT_EQUAL_UINT(pinned, tenant.live);
+    rcu_exit();
+    TEST_ASSERT_EQUAL_UINT(0, do_context_sweep(ctx));
+    TEST_ASSERT_TRUE(tenant.live < pinned);
+    
+    do_context_destroy(&ctx);
+    TEST_ASSERT_NULL(ctx);
+    TEST_ASSERT_EQUAL_UINT(0, tenant.live);
+}
+
+#if DO_INTERN_CONCURRENT
+enum { CONTEXT_READERS = 4, CONTEXT_STORED = 64 };
+
+typedef struct {
+    do_context ctx;
+    do_object obj;
+    atomic_int stop;
+    atomic_int failures;
+    atomic_int progress[CONTEXT_READERS];
+} context_readers_t;
+
+static context_readers_t g_context_readers;
+
+static void* context_reader_worker(void* arg) {
+    int thread = (int)(intptr_t)arg;
+    context_readers_t* shared = &g_context_readers;
+    do_context_bind(shared->ctx);
+    char key[32];
+    for (int n = 0; !atomic_load(&shared->stop); n++) {
+        // Stored keys stay findable while sweeps erase the transient ones
+        snprintf(key, sizeof(key), "ctx_stored_%d", n % CONTEXT_STORED);
+        const int* value = (const int*)do_get(shared->obj, key);
+        if (!value || *value != n % CONTEXT_STORED) atomic_fetch_add(&shared->failures, 1);
+        if (do_has(shared->obj, "global_only")) atomic_fetch_add(&shared->failures, 1);
+        snprintf(key, sizeof(key), "ctx_transient_%d_%d", thread, n);
+        if (!do_string_intern(key)) atomic_fetch_add(&shared->failures, 1);
+        atomic_fetch_add(&shared->progress[thread], 1);
+    }
+    do_context_bind(NULL);
+    return NULL;
+}
+
+void test_intern_context_concurrent_sweep(void) {
+    context_readers_t* shared = &g_context_readers;
+    shared->ctx = do_context_create(NULL);
+    TEST_ASSERT_NOT_NULL(shared->ctx);
+    TEST_ASSERT_NOT_NULL(do_string_intern("global_only"));
+    
+    do_context_bind(shared->ctx);
+    shared->obj = do_create(NULL);
+    char key[32];
+    for (int i = 0; i < CONTEXT_STORED; i++) {
+        snprintf(key, sizeof(key), "ctx_stored_%d", i);
+        DO_SET(shared->obj, key, i);
+    }
+    do_context_bind(NULL);
+    atomic_init(&shared->stop, 0);
+    atomic_init(&shared->failures, 0);
+    
+    pthread_t readers[CONTEXT_READERS];
+    for (int t = 0; t < CONTEXT_READERS; t++) {
+        atomic_init(&shared->progress[t], 0);
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&readers[t], NULL, context_reader_worker, (void*)(intptr_t)t));
+    }
+    
+    // Readers make progress between sweeps, so strings and tables are
+    // reclaimed while lookups are in flight
+    size_t reclaimed = 0;
+    for (int sweep = 0; sweep < 50; sweep++) {
+        reclaimed += do_context_sweep(shared->ctx);
+        int seen[CONTEXT_READERS];
+        for (int t = 0; t < CONTEXT_READERS; t++) seen[t] = atomic_load(&shared->progress[t]);
+        for (int t = 0; t < CONTEXT_READERS; t++) {
+            while (atomic_load(&shared->progress[t]) < seen[t] + 2) {
+            }
+        }
+    }
+    atomic_store(&shared->stop, 1);
+    for (int t = 0; t < CONTEXT_READERS; t++) pthread_join(readers[t], NULL);
+    
+    TEST_ASSERT_EQUAL_INT(0, atomic_load(&shared->failures));
+    TEST_ASSERT_TRUE(reclaimed > 0);
+    do_release(&shared->obj);
+    do_drain_releases(SIZE_MAX);  // Destroys now in DO_DEFERRED_RELEASE builds
+    do_context_destroy(&shared->ctx);
+}
+#endif
+#endif
+
+static size_t arena_bytes_used(do_arena arena) {
+    size_t used = 0;
+    for (do_arena_chunk_t* chunk = arena->chunks; chunk; chunk = chunk->next) used += chunk->used;
+    return used;
+}
+
+void test_arena_objects(void) {
+    do_arena arena = do_arena_create(512);
+    TEST_ASSERT_NOT_NULL(arena);
+    
+    do_object proto = create_test_object();
+    DO_SET(proto, "method", 7);
+    do_object heap_obj = create_test_object();
+    DO_SET(heap_obj, "x", 0);
+    DO_SET(heap_obj, "y", 0);
+    
+    // The arena retains a heap prototype once, however many objects use it
+    do_object objs[64];
+    char big[200] = "gets a chunk of its own";
+    for (int i = 0; i < 64; i++) {
+        objs[i] = do_arena_create_object(arena, proto);
+        TEST_ASSERT_NOT_NULL(objs[i]);
+        DO_SET(objs[i], "x", i);
+        DO_SET(objs[i], "y", i * 2);
+        do_set(objs[i], "big", big, sizeof(big));
+    }
+    TEST_ASSERT_EQUAL_INT(2, do_get_ref_count(proto));
+    TEST_ASSERT_EQUAL_INT(7, DO_GET(objs[63], "method", int));
+    TEST_ASSERT_EQUAL_INT(126, DO_GET(objs[63], "y", int));
+    TEST_ASSERT_EQUAL_STRING(big, (const char*)do_get(objs[10], "big"));
+    
+    // Arena and heap objects share the transition tree
+    do_object plain = do_arena_create_object(arena, NULL);
+    DO_SET(plain, "x", 1);
+    DO_SET(plain, "y", 2);
+    TEST_ASSERT_EQUAL_PTR(heap_obj->shape, plain->shape);
+    
+    // Reference counting is a no-op, deletes and hash upgrades still work
+    do_object alias = do_retain(objs[0]);
+    do_release(&alias);
+    TEST_ASSERT_NULL(alias);
+    TEST_ASSERT_EQUAL_INT(1, do_get_ref_count(objs[0]));
+    TEST_ASSERT_EQUAL_INT(1, do_delete(objs[0], "x"));
+    TEST_ASSERT_FALSE(do_has_own(objs[0], "x"));
+    TEST_ASSERT_EQUAL_INT(0, DO_GET(objs[0], "y", int));
+    
+    char key[32];
+    for (int i = 0; i <= DO_HASH_THRESHOLD + 1; i++) {
+        snprintf(key, sizeof(key), "field_%d", i);
+        DO_SET(objs[1], key, i);
+    }
+    TEST_ASSERT_TRUE(objs[1]->is_hashed);
+    TEST_ASSERT_EQUAL_INT(2, DO_GET(objs[1], "y", int));
+    
+    // Deletes keep the table in place rather than rebuilding it in the arena
+    size_t used = arena_bytes_used(arena);
+    for (int i = 0; i < DO_HASH_THRESHOLD; i++) {
+        snprintf(key, sizeof(key), "field_%d", i);
+        TEST_ASSERT_TRUE(do_delete(objs[1], key));
+    }
+    TEST_ASSERT_TRUE(objs[1]->is_hashed);
+    TEST_ASSERT_EQUAL_UINT(used, arena_bytes_used(arena));
+    snprintf(key, sizeof(key), "field_%d", DO_HASH_THRESHOLD + 1);
+    TEST_ASSERT_EQUAL_INT(DO_HASH_THRESHOLD + 1, DO_GET(objs[1], key, int));
+    
+    // Arena objects can be prototypes of each other
+    do_object child = do_arena_create_object(arena, objs[2]);
+    TEST_ASSERT_EQUAL_INT(4, DO_GET(child, "y", int));
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_prototype(child, NULL));
+    TEST_ASSERT_EQUAL_INT(2, do_get_ref_count(proto));
+    
+    // Teardown drops the arena's hold on shared resources
+    do_arena_reset(arena);
+    TEST_ASSERT_EQUAL_INT(1, do_get_ref_count(proto));
+    
+    do_object reused = do_arena_create_object(arena, proto);
+    DO_SET(reused, "x", 5);
+    TEST_ASSERT_EQUAL_INT(7, DO_GET(reused, "method", int));
+    TEST_ASSERT_EQUAL_PTR(heap_obj->shape->parent, reused->shape);
+    
+    do_arena_destroy(&arena);
+    TEST_ASSERT_NULL(arena);
+    TEST_ASSERT_EQUAL_INT(1, do_get_ref_count(proto));
+    
+    do_release(&heap_obj);
+    do_release(&proto);
+}
+
+#if DO_SNAPSHOT
+void test_snapshot_round_trip(void) {
+    const char* path = "do_snapshot_test.bin";
+    char text[64] = "stored out of line, past DO_INLINE_SIZE";
+    char key[32];
+    
+    // Two roots sharing a prototype, and one big enough for a hash table
+    do_object base = create_test_object();
+    DO_SET(base, "kind", 1);
+    do_set(base, "text", text, sizeof(text));
+    do_object first = do_create_with_prototype(base, NULL);
+    do_object second = do_create_with_prototype(base, NULL);
+    DO_SET(first, "x", 10);
+    DO_SET(first, "y", 20);
+    DO_SET(second, "y", 30);
+    DO_SET(second, "x", 40);
+#if DO_TAGGED_VALUES
+    do_set_i64(second, do_string_intern("count"), -7);
+    do_set_f64(base, do_string_intern("scale"), 1.5);
+    do_set_ptr(base, do_string_intern("handle"), text);
+#endif
+    do_object big = create_test_object();
+    for (int i = 0; i < DO_HASH_THRESHOLD * 2; i++) {
+        snprintf(key, sizeof(key), "field_%d", i);
+        DO_SET(big, key, i);
+    }
+#if DO_CONCURRENT_OBJECTS
+    // A concurrent root is saved as its current version
+    do_object shared = do_create_concurrent(NULL);
+    DO_SET(shared, "before", 1);
+    DO_SET(shared, "gone", 2);
+    DO_SET(shared, "after", 3);
+    TEST_ASSERT_TRUE(do_delete(shared, "gone"));
+    do_object roots[] = { first, second, big, shared };
+    enum { ROOTS = 4 };
+#else
+    do_object roots[] = { first, second, big };
+    enum { ROOTS = 3 };
+#endif
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_snapshot_write(path, roots, ROOTS));
+    do_release(&first);
+    do_release(&second);
+    do_release(&base);
+    do_release(&big);
+    
+    do_snapshot snapshot = do_snapshot_map(path);
+    TEST_ASSERT_NOT_NULL(snapshot);
+    TEST_ASSERT_EQUAL_INT(ROOTS, do_snapshot_root_count(snapshot));
+    first = do_snapshot_root(snapshot, 0);
+    second = do_snapshot_root(snapshot, 1);
+    big = do_snapshot_root(snapshot, 2);
+#if DO_CONCURRENT_OBJECTS
+    do_release(&shared);
+    do_rcu_synchronize();
+    shared = do_snapshot_root(snapshot, 3);
+    TEST_ASSERT_TRUE(do_is_frozen(shared));
+    TEST_ASSERT_EQUAL_INT(2, do_property_count(shared));
+    TEST_ASSERT_EQUAL_INT(1, DO_GET(shared, "before", int));
+    TEST_ASSERT_EQUAL_INT(3, DO_GET(shared, "after", int));
+    TEST_ASSERT_FALSE(do_has_own(shared, "gone"));
+#endif
+    base = do_get_prototype(first);
+    TEST_ASSERT_NOT_NULL(base);
+    TEST_ASSERT_EQUAL_PTR(base, do_get_prototype(second));
+    TEST_ASSERT_EQUAL_INT(10, DO_GET(first, "x", int));
+    TEST_ASSERT_EQUAL_INT(30, DO_GET(second, "y", int));
+    TEST_ASSERT_EQUAL_INT(1, DO_GET(second, "kind", int));
+    TEST_ASSERT_EQUAL_STRING(text, (const char*)do_get(first, "text"));
+    
+    // Out-of-line values are read from the mapped file; clones copy them out
+    const unsigned char* stored = (const unsigned char*)do_get(first, "text");
+    TEST_ASSERT_TRUE(stored >= snapshot->image && stored < snapshot->image + snapshot->image_size);
+    do_object copy = do_clone(base);
+    const unsigned char* copied = (const unsigned char*)do_get(copy, "text");
+    TEST_ASSERT_TRUE(copied != stored);
+    TEST_ASSERT_EQUAL_STRING(text, (const char*)copied);
+    do_release(&copy);
+#if DO_TAGGED_VALUES
+    // Scalar tags are kept; pointers load as plain bytes
+    int64_t count = 0;
+    double scale = 0;
+    TEST_ASSERT_TRUE(do_get_i64(second, do_string_intern("count"), &count));
+    TEST_ASSERT_TRUE(count == -7);
+    TEST_ASSERT_TRUE(do_get_f64(second, do_string_intern("scale"), &scale));
+    TEST_ASSERT_TRUE(scale == 1.5);
+    TEST_ASSERT_EQUAL_INT(DO_TYPE_BYTES, do_get_type(base, do_string_intern("handle")));
+    TEST_ASSERT_EQUAL_INT(3, do_property_count(second));
+#else
+    TEST_ASSERT_EQUAL_INT(2, do_property_count(second));
+#endif
+    TEST_ASSERT_EQUAL_INT(DO_HASH_THRESHOLD * 2, do_property_count(big));
+    TEST_ASSERT_EQUAL_INT(DO_HASH_THRESHOLD * 2 - 1, DO_GET(big, key, int));
+    
+    // Frozen, and usable as a prototype for ordinary objects
+    TEST_ASSERT_TRUE(do_is_frozen(base));
+    int value = 5;
+    TEST_ASSERT_EQUAL_INT(DO_ERROR_FROZEN, do_set(first, "x", &value, sizeof(value)));
+    do_object instance = do_create_with_prototype(first, NULL);
+    TEST_ASSERT_EQUAL_INT(20, DO_GET(instance, "y", int));
+    do_release(&instance);
+    do_drain_releases(SIZE_MAX);  // Destroys now in DO_DEFERRED_RELEASE builds
+    do_snapshot_destroy(&snapshot);
+    TEST_ASSERT_NULL(snapshot);
+    
+    // Damaged and missing files are refused
+    FILE* file = fopen(path, "r+b");
+    TEST_ASSERT_NOT_NULL(file);
+    fputc('X', file);
+    fclose(file);
+    TEST_ASSERT_NULL(do_snapshot_map(path));
+    remove(path);
+    TEST_ASSERT_NULL(do_snapshot_map(path));
+    TEST_ASSERT_EQUAL_INT(DO_ERROR_IO, do_snapshot_write("no_such_dir/snapshot.bin", roots, 0));
+}
+#endif
+
+void test_prototype_lookup_invalidation(void) {
+    enum { DEPTH = 8 };
+    do_object chain[DEPTH];
+    const char* method = do_string_intern("method");
+    
+    chain[0] = create_test_object();
+    DO_SET(chain[0], "method", 1);
+    for (int i = 1; i < DEPTH; i++) {
+        chain[i] = do_create_with_prototype(chain[i - 1], NULL);
+        DO_SET(chain[i], "level", i);
+    }
+    do_object leaf = chain[DEPTH - 1];
+    
+    // Repeated lookups (served from the prototype cache when enabled)
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_INT(1, *(int*)do_get_interned(leaf, method));
+        TEST_ASSERT_FALSE(do_has(leaf, "missing"));
+    }
+    
+    // Adding, deleting and relinking prototypes must all be observed
+    DO_SET(chain[4], "method", 4);
+    TEST_ASSERT_EQUAL_INT(4, *(int*)do_get_interned(leaf, method));
+    DO_SET(chain[0], "missing", 0);
+    TEST_ASSERT_TRUE(do_has(leaf, "missing"));
+    do_delete(chain[4], "method");
+    TEST_ASSERT_EQUAL_INT(1, *(int*)do_get_interned(leaf, method));
+    
+    do_object other = create_test_object();
+    DO_SET(other, "method", 99);
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set_prototype(chain[2], other));
+    TEST_ASSERT_EQUAL_INT(99, *(int*)do_get_interned(leaf, method));
+    
+    // Hashed holders go through the same caches
+    char key[32];
+    for (int i = 0; i <= DO_HASH_THRESHOLD + 1; i++) {
+        snprintf(key, sizeof(key), "filler_%d", i);
+        DO_SET(other, key, i);
+    }
+    TEST_ASSERT_TRUE(other->is_hashed);
+    TEST_ASSERT_EQUAL_INT(99, *(int*)do_get_interned(leaf, method));
+    DO_SET(other, "method", 100);
+    TEST_ASSERT_EQUAL_INT(100, *(int*)do_get_interned(leaf, method));
+    
+    do_release(&other);
+    for (int i = DEPTH - 1; i >= 0; i--) {
+        do_release(&chain[i]);
+    }
+}
+
 void test_interned_key_performance(void) {
     do_object obj = create_test_object();
     
@@ -619,6 +2365,73 @@ void test_foreach_callback(const char* key, void* data, size_t size, void* conte
     TEST_ASSERT_EQUAL_INT(12345, *(int*)context);
 }
 
+void test_iter_own_and_inherited(void) {
+    do_object base = create_test_object();
+    DO_SET(base, "a", 1);
+    DO_SET(base, "b", 2);
+    DO_SET(base, "c", 3);
+    do_object middle = do_create_with_prototype(base, NULL);
+    DO_SET(middle, "b", 20);
+    DO_SET(middle, "d", 40);
+    do_object leaf = do_create_with_prototype(middle, NULL);
+    DO_SET(leaf, "c", 300);
+    DO_SET(leaf, "e", 500);
+    
+    // Own properties only, in insertion order
+    do_iter_t it;
+    do_iter_init(&it, middle, DO_ITER_OWN);
+    TEST_ASSERT_TRUE(do_iter_next(&it));
+    TEST_ASSERT_EQUAL_STRING("b", it.key);
+    TEST_ASSERT_EQUAL_INT(20, *(int*)it.value);
+    TEST_ASSERT_EQUAL_UINT(sizeof(int), it.size);
+    TEST_ASSERT_TRUE(do_iter_next(&it));
+    TEST_ASSERT_EQUAL_STRING("d", it.key);
+    TEST_ASSERT_FALSE(do_iter_next(&it));
+    TEST_ASSERT_FALSE(do_iter_next(&it));
+    
+    // Whole chain: each key once, with the value that do_get sees
+    const char* expected_keys[] = { "c", "e", "b", "d", "a" };
+    int expected_values[] = { 300, 500, 20, 40, 1 };
+    do_object expected_holders[] = { leaf, leaf, middle, middle, base };
+    int count = 0;
+    do_iter_init(&it, leaf, DO_ITER_INHERITED);
+    while (do_iter_next(&it)) {
+        TEST_ASSERT_LESS_THAN_INT(5, count);
+        TEST_ASSERT_EQUAL_STRING(expected_keys[count], it.key);
+        TEST_ASSERT_EQUAL_INT(expected_values[count], *(int*)it.value);
+        TEST_ASSERT_EQUAL_PTR(expected_holders[count], it.holder);
+        count++;
+    }
+    TEST_ASSERT_EQUAL_INT(5, count);
+    
+    // Hashed levels skip deleted entries and shadow the same way
+    char key[32];
+    for (int i = 0; i < 40; i++) {
+        snprintf(key, sizeof(key), "wide_%d", i);
+        DO_SET(base, key, i);
+        if (i % 2 == 0) DO_SET(leaf, key, -i);
+    }
+    for (int i = 0; i < 40; i += 4) {
+        snprintf(key, sizeof(key), "wide_%d", i);
+        do_delete(base, key);
+    }
+    TEST_ASSERT_TRUE(base->is_hashed);
+    TEST_ASSERT_TRUE(leaf->is_hashed);
+    
+    const char** all_keys = do_get_all_keys(leaf);
+    TEST_ASSERT_EQUAL_INT(5 + 40, (int)arrlen(all_keys));
+    for (int i = 0; i < arrlen(all_keys); i++) {
+        for (int j = i + 1; j < arrlen(all_keys); j++) {
+            TEST_ASSERT_TRUE(all_keys[i] != all_keys[j]);
+        }
+    }
+    arrfree(all_keys);
+    
+    do_release(&leaf);
+    do_release(&middle);
+    do_release(&base);
+}
+
 void test_foreach_property(void) {
     do_object obj = create_test_object();
     
@@ -728,6 +2541,7 @@ void test_release_function_on_property_update(void) {
     TEST_ASSERT_EQUAL_INT(200, *(int*)do_get(obj, "test"));
     
     do_release(&obj);
+    do_drain_releases(SIZE_MAX);  // Destroys now in DO_DEFERRED_RELEASE builds
     TEST_ASSERT_EQUAL_INT(2, release_call_count);
     TEST_ASSERT_EQUAL_INT(200, last_released_value);
 }
@@ -759,6 +2573,7 @@ void test_release_function_multiple_properties(void) {
     TEST_ASSERT_EQUAL_INT(0, release_call_count);
     
     do_release(&obj);
+    do_drain_releases(SIZE_MAX);  // Destroys now in DO_DEFERRED_RELEASE builds
     
     // All three properties should be released
     TEST_ASSERT_EQUAL_INT(3, release_call_count);
@@ -876,6 +2691,146 @@ void test_object_with_circular_properties(void) {
     do_release(&obj2);
 }
 
+#if DO_CYCLE_COLLECTOR || DO_DEFERRED_RELEASE
+// Properties of these test objects are owned object references
+static void release_object_value(void* value) {
+    do_release((do_object*)value);
+}
+
+// Store an owned reference to target in obj[key]
+static void link_object(do_object obj, const char* key, do_object target) {
+    do_object ref = do_retain(target);
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, do_set(obj, key, &ref, sizeof(ref)));
+}
+#endif
+
+#if DO_CYCLE_COLLECTOR
+static void trace_object_value(void* value, size_t size, do_visit_fn visit, void* context) {
+    if (size == sizeof(do_object)) visit(*(do_object*)value, context);
+}
+
+static do_object create_traced_object(void) {
+    do_object obj = do_create(release_object_value);
+    do_set_trace_fn(obj, trace_object_value);
+    return obj;
+}
+
+void test_cycle_collector(void) {
+    // Two objects holding each other survive their last outside release
+    do_object a = create_traced_object();
+    do_object b = create_traced_object();
+    link_object(a, "peer", b);
+    link_object(b, "peer", a);
+    
+    // An outside object one of them references stays alive
+    do_object shared = create_test_object();
+    link_object(a, "shared", shared);
+    
+    do_object keep = do_retain(a);
+    do_release(&a);
+    do_release(&b);
+    TEST_ASSERT_TRUE(do_cycle_candidates() > 0);
+    TEST_ASSERT_EQUAL_UINT(0, do_collect_cycles(SIZE_MAX));
+    TEST_ASSERT_EQUAL_INT(2, do_get_ref_count(keep));  // keep and b
+    TEST_ASSERT_EQUAL_INT(2, do_get_ref_count(shared));
+    
+    do_release(&keep);
+    TEST_ASSERT_EQUAL_UINT(2, do_collect_cycles(SIZE_MAX));
+    TEST_ASSERT_EQUAL_UINT(0, do_cycle_candidates());
+    TEST_ASSERT_EQUAL_INT(1, do_get_ref_count(shared));
+    do_release(&shared);
+    
+    // A cycle closed through a prototype link, in a hashed object
+    do_object proto = create_traced_object();
+    do_object child = do_create_with_prototype(proto, NULL);
+    char key[32];
+    for (int i = 0; i < DO_HASH_THRESHOLD + 2; i++) {
+        snprintf(key, sizeof(key), "ref_%d", i);
+        link_object(proto, key, child);
+    }
+    TEST_ASSERT_TRUE(proto->is_hashed);
+    do_release(&proto);
+    do_release(&child);
+    TEST_ASSERT_EQUAL_UINT(2, do_collect_cycles(SIZE_MAX));
+}
+
+void test_cycle_collector_incremental(void) {
+    // Rings of three: each step stops once its budget of visits is spent
+    enum { RINGS = 50 };
+    for (int r = 0; r < RINGS; r++) {
+        do_object ring[3];
+        for (int i = 0; i < 3; i++) ring[i] = create_traced_object();
+        for (int i = 0; i < 3; i++) link_object(ring[i], "next", ring[(i + 1) % 3]);
+        for (int i = 0; i < 3; i++) do_release(&ring[i]);
+    }
+    
+    size_t freed = 0;
+    int steps = 0;
+    while (do_cycle_candidates() > 0) {
+        size_t step = do_collect_cycles(10);
+        TEST_ASSERT_TRUE(step <= 6);  // At most one ring past the budget
+        freed += step;
+        steps++;
+        TEST_ASSERT_TRUE(steps <= RINGS * 3);
+    }
+    TEST_ASSERT_TRUE(steps > 1);
+    TEST_ASSERT_EQUAL_UINT(RINGS * 3, freed);
+    
+    // A long chain is walked without recursion
+    do_object head = create_traced_object();
+    do_object tail = head;
+    for (int i = 0; i < 100000; i++) {
+        do_object next = create_traced_object();
+        link_object(tail, "next", next);
+        do_release(&next);
+        tail = (*(do_object*)do_get(tail, "next"));
+    }
+    link_object(tail, "next", head);
+    do_release(&head);
+    TEST_ASSERT_EQUAL_UINT(100001, do_collect_cycles(SIZE_MAX));
+}
+#endif
+
+#if DO_DEFERRED_RELEASE
+void test_deferred_release_drain(void) {
+    // A long chain held through properties and a deep prototype chain:
+    // releasing either head only queues it, draining never recurses
+    do_object head = do_create(release_object_value);
+    do_object tail = head;
+    for (int i = 0; i < 200000; i++) {
+        do_object next = do_create(release_object_value);
+        link_object(tail, "next", next);
+        do_release(&next);
+        tail = *(do_object*)do_get(tail, "next");
+    }
+    do_object leaf = do_create(NULL);
+    for (int i = 0; i < 100000; i++) {
+        do_object child = do_create_with_prototype(leaf, NULL);
+        do_release(&leaf);
+        leaf = child;
+    }
+    TEST_ASSERT_EQUAL_UINT(0, do_drain_releases(SIZE_MAX));
+    
+    reset_release_counter();
+    do_object prototype = do_create(test_release_fn);
+    DO_SET(prototype, "value", 1);
+    do_object instance = do_create_with_prototype(prototype, NULL);
+    do_release(&prototype);
+    do_release(&instance);
+    TEST_ASSERT_EQUAL_INT(0, release_call_count);
+    TEST_ASSERT_EQUAL_UINT(1, do_drain_releases(1));
+    TEST_ASSERT_EQUAL_INT(0, release_call_count);  // The prototype is queued behind it
+    TEST_ASSERT_EQUAL_UINT(1, do_drain_releases(1));
+    TEST_ASSERT_EQUAL_INT(1, release_call_count);
+    
+    do_release(&head);
+    do_release(&leaf);
+    TEST_ASSERT_EQUAL_UINT(10, do_drain_releases(10));
+    TEST_ASSERT_EQUAL_UINT(200001 + 100001 - 10, do_drain_releases(SIZE_MAX));
+    TEST_ASSERT_EQUAL_UINT(0, do_drain_releases(SIZE_MAX));
+}
+#endif
+
 /* =============================================================================
  * METHOD SUPPORT TESTS 
  * ============================================================================= */
@@ -1380,11 +3335,22 @@ int main(void) {
     RUN_TEST(test_string_intern_basic);
     RUN_TEST(test_string_find_interned);
     RUN_TEST(test_string_intern_cleanup);
+    RUN_TEST(test_string_intern_many_keys);
+    RUN_TEST(test_string_intern_slices);
+#if DO_INTERN_CONCURRENT
+    RUN_TEST(test_string_intern_concurrent);
+#endif
     
     // Object creation and lifecycle tests
     RUN_TEST(test_object_create_basic);
     RUN_TEST(test_object_create_with_prototype);
     RUN_TEST(test_object_reference_counting);
+#if DO_BIASED_REFCOUNT
+    RUN_TEST(test_biased_refcount_threads);
+#endif
+#if DO_CONCURRENT_OBJECTS
+    RUN_TEST(test_concurrent_objects);
+#endif
     RUN_TEST(test_object_create_with_release_fn);
     
     // Property access tests
@@ -1392,10 +3358,13 @@ int main(void) {
     RUN_TEST(test_property_update_existing);
     RUN_TEST(test_property_different_types);
     RUN_TEST(test_property_has_and_delete);
+    RUN_TEST(test_property_inline_and_heap_values);
+    RUN_TEST(test_property_reserve_and_get_mut);
     
     // Type-safe macro tests
     RUN_TEST(test_type_safe_macros);
     RUN_TEST(test_interned_macros);
+    RUN_TEST(test_static_key_table);
     
     // Prototype chain tests
     RUN_TEST(test_prototype_inheritance_basic);
@@ -1406,12 +3375,47 @@ int main(void) {
     
     // Performance optimization tests
     RUN_TEST(test_linear_to_hash_upgrade);
+    RUN_TEST(test_hash_downgrade_and_compact);
+    RUN_TEST(test_hash_delete_churn);
     RUN_TEST(test_interned_key_performance);
+    RUN_TEST(test_shapes_shared_by_key_order);
+    RUN_TEST(test_shapes_lookup_every_slot);
+    RUN_TEST(test_property_table_large);
+    RUN_TEST(test_shapes_delete_transitions);
+    RUN_TEST(test_shapes_megamorphic_fallback);
+    RUN_TEST(test_prototype_lookup_invalidation);
+    RUN_TEST(test_inline_cache_own_and_inherited);
+    RUN_TEST(test_inline_cache_set_and_hashed);
+    RUN_TEST(test_batch_set_get_delete);
+    RUN_TEST(test_reserve_properties);
+#if DO_TAGGED_VALUES
+    RUN_TEST(test_tagged_values);
+#endif
+    RUN_TEST(test_clone_copy_on_write);
+    RUN_TEST(test_freeze_objects);
+    RUN_TEST(test_arena_objects);
+#if DO_SNAPSHOT
+    RUN_TEST(test_snapshot_round_trip);
+#endif
+    RUN_TEST(test_allocator_hooks_and_memory_usage);
+#if DO_INTERN_CONTEXT
+    RUN_TEST(test_intern_context_sweep);
+#if DO_INTERN_CONCURRENT
+    RUN_TEST(test_intern_context_concurrent_sweep);
+#endif
+#endif
+#if DO_POOL_ALLOCATOR
+    RUN_TEST(test_pool_allocator_reuse);
+#endif
+#if DO_STATS
+    RUN_TEST(test_stats_counters);
+#endif
     
     // Utility function tests
     RUN_TEST(test_get_own_keys);
     RUN_TEST(test_get_all_keys_with_inheritance);
     RUN_TEST(test_foreach_property);
+    RUN_TEST(test_iter_own_and_inherited);
     
     // Error handling and edge case tests
     RUN_TEST(test_null_parameter_handling);
@@ -1427,6 +3431,13 @@ int main(void) {
     RUN_TEST(test_complex_inheritance_scenario);
     RUN_TEST(test_mixed_storage_types);
     RUN_TEST(test_object_with_circular_properties);
+#if DO_CYCLE_COLLECTOR
+    RUN_TEST(test_cycle_collector);
+    RUN_TEST(test_cycle_collector_incremental);
+#endif
+#if DO_DEFERRED_RELEASE
+    RUN_TEST(test_deferred_release_drain);
+#endif
     
     // Method support tests
     RUN_TEST(test_method_storage_basic);
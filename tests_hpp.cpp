@@ -0,0 +1,239 @@
+/**
+ * @file tests_hpp.cpp
+ * @brief Unit tests for the dynamic_object.hpp C++ wrapper
+ *
+ * Built against the C implementation in tests_hpp_impl.c.
+ */
+
+#include "libs/unity/unity.h"
+
+#include "dynamic_object.hpp"
+
+#include <string_view>
+#include <utility>
+
+/* =============================================================================
+ * TEST FIXTURES AND HELPERS
+ * ============================================================================= */
+
+static int release_call_count = 0;
+
+static void count_release(void* data) {
+    if (data) release_call_count++;
+}
+
+struct alignas(32) WideValue {
+    double lanes[4];
+};
+
+void setUp(void) {
+    release_call_count = 0;
+}
+
+void tearDown(void) {
+    do_drain_releases(SIZE_MAX);
+    dobj::intern_cleanup();  // Also forgets the pointers cached by dobj::Key
+}
+
+/* =============================================================================
+ * HANDLE TESTS
+ * ============================================================================= */
+
+void test_handle_copy_and_move(void) {
+    dobj::Object obj = dobj::Object::create(count_release);
+    TEST_ASSERT_TRUE(static_cast<bool>(obj));
+    TEST_ASSERT_EQUAL_INT(1, do_get_ref_count(obj.handle()));
+    
+    // Copies retain; moves hand the reference over untouched
+    dobj::Object copy = obj;
+    TEST_ASSERT_EQUAL_INT(2, do_get_ref_count(obj.handle()));
+    dobj::Object moved = std::move(copy);
+    TEST_ASSERT_FALSE(static_cast<bool>(copy));
+    TEST_ASSERT_EQUAL_INT(2, do_get_ref_count(obj.handle()));
+    TEST_ASSERT_TRUE(moved == obj);
+    
+    moved = dobj::Object();
+    TEST_ASSERT_EQUAL_INT(1, do_get_ref_count(obj.handle()));
+    
+    // The last handle releases the object and, with it, its values
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, obj.set("value", 7));
+    {
+        dobj::Object last = std::move(obj);
+    }
+    do_drain_releases(SIZE_MAX);  // Destroys now in DO_DEFERRED_RELEASE builds
+    TEST_ASSERT_EQUAL_INT(1, release_call_count);
+    
+    // adopt takes an owned reference, retain adds one, detach gives it back
+    do_object raw = do_create(NULL);
+    dobj::Object adopted = dobj::Object::adopt(raw);
+    dobj::Object shared = dobj::Object::retain(raw);
+    TEST_ASSERT_EQUAL_INT(2, do_get_ref_count(raw));
+    do_object detached = shared.detach();
+    TEST_ASSERT_EQUAL_PTR(raw, detached);
+    TEST_ASSERT_EQUAL_INT(2, do_get_ref_count(raw));
+    do_release(&detached);
+}
+
+void test_handle_prototypes(void) {
+    dobj::Object base = dobj::Object::create();
+    base.set("legs", 4);
+    dobj::Object dog = dobj::Object::create(base);
+    TEST_ASSERT_TRUE(dog.prototype() == base);
+    TEST_ASSERT_EQUAL_INT(4, *dog.get<int>("legs"));
+    TEST_ASSERT_EQUAL_INT(0, dog.property_count());
+    
+    dobj::Object copy = base.clone();
+    TEST_ASSERT_TRUE(copy.has("legs"));
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, dog.set_prototype(dobj::Object()));
+    TEST_ASSERT_FALSE(dog.has("legs"));
+}
+
+/* =============================================================================
+ * TYPED ACCESS TESTS
+ * ============================================================================= */
+
+void test_typed_get_set(void) {
+    dobj::Object obj = dobj::Object::create();
+    
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, obj.set("count", 3));
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, obj.set(std::string_view("ratio_suffix").substr(0, 5), 0.5));
+    TEST_ASSERT_EQUAL_INT(3, *obj.get<int>("count"));
+    TEST_ASSERT_TRUE(obj.value<double>("ratio").value_or(0.0) == 0.5);
+    TEST_ASSERT_NULL(obj.get<int>("missing"));
+    TEST_ASSERT_FALSE(obj.value<int>("missing").has_value());
+    
+    // Zero-copy reads are const; get_mut writes through
+    static_assert(std::is_same_v<decltype(obj.get<int>("count")), const int*>);
+    *obj.get_mut<int>("count") += 1;
+    TEST_ASSERT_EQUAL_INT(4, obj.value<int>("count").value());
+    TEST_ASSERT_NULL(obj.get_mut<int>("missing"));
+    
+    // Writing through a clone leaves the source alone
+    dobj::Object copy = obj.clone();
+    TEST_ASSERT_EQUAL_PTR(obj.get<int>("count"), copy.get<int>("count"));
+    *copy.get_mut<int>("count") = 10;
+    TEST_ASSERT_EQUAL_INT(4, *obj.get<int>("count"));
+    TEST_ASSERT_EQUAL_INT(10, *copy.get<int>("count"));
+    
+    // Inherited and frozen values are not writable
+    {
+        dobj::Object proto = dobj::Object::create();
+        TEST_ASSERT_EQUAL_INT(DO_SUCCESS, proto.set("limit", 8));
+        do_freeze(proto.handle(), 0);
+        dobj::Object child = dobj::Object::create(proto);
+        TEST_ASSERT_EQUAL_INT(8, *child.get<int>("limit"));
+        TEST_ASSERT_NULL(child.get_mut<int>("limit"));
+        TEST_ASSERT_NULL(proto.get_mut<int>("limit"));
+        TEST_ASSERT_EQUAL_INT(DO_SUCCESS, child.set("limit", 9));
+        TEST_ASSERT_EQUAL_INT(9, *child.get_mut<int>("limit"));
+        TEST_ASSERT_EQUAL_INT(8, *proto.get<int>("limit"));
+    }
+    do_frozen_cleanup();  // Handles are gone; frozen objects are immortal until now
+    
+    // Over-aligned values are copied out rather than dereferenced in place
+    WideValue wide = { { 1.0, 2.0, 3.0, 4.0 } };
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, obj.set("wide", wide));
+    std::optional<WideValue> read = obj.value<WideValue>("wide");
+    TEST_ASSERT_TRUE(read.has_value() && read->lanes[3] == 4.0);
+    
+    dobj::InternedKey count = dobj::intern("count");
+    TEST_ASSERT_EQUAL_PTR(do_string_intern("count"), count.ptr);
+    TEST_ASSERT_TRUE(obj.erase(count));
+    TEST_ASSERT_FALSE(obj.erase(count));
+    TEST_ASSERT_FALSE(obj.has(count));
+}
+
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+void test_compile_time_keys(void) {
+    using Name = dobj::Key<"name">;
+    static_assert(Name::text == "name");
+    
+    // The compile-time hash is the one the intern table uses
+    TEST_ASSERT_TRUE(do_string_hash("name", 4) == Name::hash);
+    const char* interned = Name::get();
+    TEST_ASSERT_EQUAL_PTR(do_string_intern("name"), interned);
+    TEST_ASSERT_EQUAL_PTR(interned, Name::get());
+    
+    dobj::Object obj = dobj::Object::create();
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, obj.set(Name{}, 42L));
+    TEST_ASSERT_EQUAL_INT(42, *obj.get<long>(Name{}));
+    TEST_ASSERT_EQUAL_INT(42, *obj.get<long>("name"));
+    obj.reset();
+    
+    // intern_cleanup drops the cached pointer; the next use interns again
+    dobj::intern_cleanup();
+    TEST_ASSERT_NULL(do_string_find_interned("name"));
+    TEST_ASSERT_EQUAL_PTR(do_string_intern("name"), Name::get());
+}
+
+#if DO_INTERN_CONTEXT
+void test_keys_with_context_bound(void) {
+    using Tenant = dobj::Key<"tenant_field">;
+    do_context ctx = do_context_create(nullptr);
+    TEST_ASSERT_NOT_NULL(ctx);
+    
+    // First use on a tenant thread still interns into the global table
+    do_context_bind(ctx);
+    dobj::Object obj = dobj::Object::create();
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, obj.set(Tenant{}, 1));
+    do_context_bind(nullptr);
+    const char* interned = Tenant::get();
+    TEST_ASSERT_EQUAL_PTR(do_string_find_interned("tenant_field"), interned);
+    obj.reset();
+    
+    // Sweeps cannot free it, and the next use sees the same pointer
+    do_context_sweep(ctx);
+    do_context_sweep(ctx);
+    do_context_bind(ctx);
+    obj = dobj::Object::create();
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, obj.set(Tenant{}, 2));
+    TEST_ASSERT_EQUAL_INT(2, *obj.get<int>(Tenant{}));
+    TEST_ASSERT_EQUAL_PTR(interned, Tenant::get());
+    do_context_bind(nullptr);
+    
+    obj.reset();
+    do_context_destroy(&ctx);
+}
+#endif
+#endif
+
+#if DO_TAGGED_VALUES
+void test_object_values(void) {
+    dobj::Object owner = dobj::Object::create();
+    dobj::Object target = dobj::Object::create();
+    
+    TEST_ASSERT_EQUAL_INT(DO_SUCCESS, owner.set("target", target));
+    TEST_ASSERT_EQUAL_INT(2, do_get_ref_count(target.handle()));
+    TEST_ASSERT_TRUE(owner.get_object("target") == target);
+    TEST_ASSERT_FALSE(static_cast<bool>(owner.get_object("missing")));
+    
+    TEST_ASSERT_TRUE(owner.erase("target"));
+    TEST_ASSERT_EQUAL_INT(1, do_get_ref_count(target.handle()));
+}
+#endif
+
+/* =============================================================================
+ * TEST RUNNER
+ * ============================================================================= */
+
+int main(void) {
+    UNITY_BEGIN();
+    
+    // Handle tests
+    RUN_TEST(test_handle_copy_and_move);
+    RUN_TEST(test_handle_prototypes);
+    
+    // Typed access tests
+    RUN_TEST(test_typed_get_set);
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+    RUN_TEST(test_compile_time_keys);
+#if DO_INTERN_CONTEXT
+    RUN_TEST(test_keys_with_context_bound);
+#endif
+#endif
+#if DO_TAGGED_VALUES
+    RUN_TEST(test_object_values);
+#endif
+    
+    return UNITY_END();
+}
@@ -0,0 +1,10 @@
+/**
+ * @file tests_hpp_impl.c
+ * @brief Library implementation for tests_hpp.cpp
+ *
+ * The implementation is C11; C++ translation units include the declarations
+ * only (see dynamic_object.hpp).
+ */
+
+#define DO_IMPLEMENTATION
+#include "dynamic_object.h"